@@ -95,6 +95,7 @@ _config = {
     'mpl_backend': None,
     'msd': None,
     'multithreading': True,
+    'nngt_storage': "dict",
     'omp': 1,
     'palette_continuous': 'magma',
     'palette_discrete': 'Set1',
@@ -11,11 +11,13 @@ import numpy as np
 import scipy.signal as sps
 import scipy.sparse as ssp
 
+import nngt
 from nngt.lib import nonstring_container, find_idx_nearest
 from nngt.lib.logger import _log_message
 
 
 __all__ = [
+    "SpikeStatistics",
     "get_b2",
     "get_firing_rate",
     "get_spikes",
@@ -26,6 +28,202 @@ __all__ = [
 logger = logging.getLogger(__name__)
 
 
+# columns of the per-neuron statistics (same as spike_stat in func_analysis.h)
+_COUNT, _FIRST, _LAST, _PREV_ISI, _SUM_ISI, _SQ_ISI, _SUM_ISI2, _SQ_ISI2 = \
+    range(8)
+
+
+# ---------------- #
+# Spike statistics #
+# ---------------- #
+
+class SpikeStatistics:
+    '''
+    Per-neuron spike statistics accumulated from (possibly streamed) chunks
+    of spikes.
+
+    Only the number of spikes, the first and last spike times, and the sums
+    of the inter-spike intervals (ISIs) and of their squares are stored for
+    each neuron, so the B2 coefficients and firing rates of very long
+    recordings can be computed without keeping the spikes in memory.
+    The chunks are processed by a multithreaded C++ kernel when available.
+
+    .. versionadded:: 2.8
+
+    Parameters
+    ----------
+    nodes : array-like
+        Ids of the neurons (e.g. NEST GIDs) to analyse, spikes from other
+        senders are only used to measure the duration of the recording.
+
+    Example
+    -------
+    >>> stats = SpikeStatistics(gids)
+    >>> for _ in range(10):
+    ...     nest.Simulate(1000.)
+    ...     events = nest.GetStatus(recorder, "events")[0]
+    ...     stats.add(events["senders"], events["times"])
+    ...     nest.SetStatus(recorder, "n_events", 0)
+    >>> b2 = stats.b2()
+    '''
+
+    def __init__(self, nodes):
+        nodes = np.asarray(nodes, dtype=np.int64).ravel()
+
+        self._nodes, self._order = np.unique(nodes, return_inverse=True)
+        self._state = np.zeros((len(self._nodes), 8))
+
+        self._start = np.inf
+        self._stop  = -np.inf
+
+    @property
+    def nodes(self):
+        ''' Ids of the analysed neurons '''
+        return self._nodes[self._order]
+
+    @property
+    def num_spikes(self):
+        ''' Number of spikes of each neuron '''
+        return self._state[self._order, _COUNT].astype(int)
+
+    @property
+    def duration(self):
+        ''' Time between the first and the last spikes of all senders '''
+        return max(self._stop - self._start, 0.)
+
+    def add(self, senders, times):
+        '''
+        Add a chunk of spikes.
+
+        Chunks must be added in chronological order (the last spike of a
+        chunk must not come after the first one of the next chunk), but the
+        spikes inside a chunk can be in any order.
+
+        Parameters
+        ----------
+        senders : array-like
+            Id of the neuron associated to each spike.
+        times : array-like
+            Spike times.
+        '''
+        senders = np.asarray(senders, dtype=np.int64).ravel()
+        times   = np.asarray(times, dtype=float).ravel()
+
+        if len(senders) != len(times):
+            raise ValueError("`senders` and `times` must have the same size.")
+
+        if not len(times):
+            return
+
+        self._start = min(self._start, np.min(times))
+        self._stop  = max(self._stop, np.max(times))
+
+        add_chunk = _compiled_spike_function("_add_spike_chunk")
+
+        if add_chunk is not None:
+            add_chunk(self._nodes, senders, times, self._state)
+        else:
+            self._add_numpy(senders, times)
+
+    def b2(self):
+        '''
+        B2 coefficient of each neuron, ``(2 var(ISI1) - var(ISI2)) /
+        (2 mean(ISI1)**2)``, with ISI1 the intervals between consecutive
+        spikes and ISI2 the sum of two consecutive intervals.
+
+        Returns NaN for neurons with less than 3 spikes and infinity if the
+        mean ISI is zero.
+        '''
+        st = self._state[self._order]
+
+        n1 = st[:, _COUNT] - 1
+        n2 = st[:, _COUNT] - 2
+
+        with np.errstate(divide="ignore", invalid="ignore"):
+            avg1 = st[:, _SUM_ISI] / n1
+            var1 = st[:, _SQ_ISI] / n1 - avg1**2
+            var2 = st[:, _SQ_ISI2] / n2 - (st[:, _SUM_ISI2] / n2)**2
+
+            b2 = (2*var1 - var2) / (2*avg1**2)
+
+        b2[n2 < 1] = np.NaN
+        b2[(n1 >= 1) & (avg1 == 0)] = np.inf
+
+        return b2
+
+    def firing_rate(self, duration=None):
+        '''
+        Average firing rate of each neuron.
+
+        Parameters
+        ----------
+        duration : float, optional (default: :attr:`duration`)
+            Duration over which the rate is computed.
+        '''
+        duration = self.duration if duration is None else float(duration)
+
+        with np.errstate(divide="ignore", invalid="ignore"):
+            return self._state[self._order, _COUNT] / duration
+
+    def _add_numpy(self, senders, times):
+        ''' Vectorized update of the statistics '''
+        nodes, st = self._nodes, self._state
+
+        pos   = np.searchsorted(nodes, senders)
+        keep  = pos < len(nodes)
+        keep[keep] = nodes[pos[keep]] == senders[keep]
+        pos, times = pos[keep], times[keep]
+
+        if not len(pos):
+            return
+
+        # the previous spikes needed to get the first ISIs of the chunk
+        # (pos, time) are prepended to the new ones
+        seen = np.unique(pos)
+        one  = seen[st[seen, _COUNT] >= 1]
+        two  = seen[st[seen, _COUNT] >= 2]
+
+        vpos  = np.concatenate((two, one, pos))
+        vtime = np.concatenate((st[two, _LAST] - st[two, _PREV_ISI],
+                                st[one, _LAST], times))
+        new   = np.repeat([False, True], [len(two) + len(one), len(pos)])
+
+        order = np.lexsort((new, vtime, vpos))
+        vpos, vtime, new = vpos[order], vtime[order], new[order]
+
+        num = len(nodes)
+
+        # ISIs and sum of two consecutive ISIs ending on a new spike
+        isi   = np.diff(vtime)
+        keep1 = (vpos[1:] == vpos[:-1]) & new[1:]
+        isi2  = vtime[2:] - vtime[:-2]
+        keep2 = (vpos[2:] == vpos[:-2]) & new[2:]
+
+        for col, values, mask, p in (
+                (_SUM_ISI, isi, keep1, vpos[1:]),
+                (_SUM_ISI2, isi2, keep2, vpos[2:])):
+            st[:, col]     += np.bincount(p[mask], values[mask], num)
+            st[:, col + 1] += np.bincount(p[mask], values[mask]**2, num)
+
+        # first, last, and last ISI of each neuron
+        start = np.ones(len(vpos), dtype=bool)
+        start[1:] = vpos[1:] != vpos[:-1]
+
+        end = np.roll(start, -1)
+
+        first = start & (st[vpos, _COUNT] == 0)
+        st[vpos[first], _FIRST] = vtime[first]
+
+        st[vpos[end], _LAST] = vtime[end]
+
+        last_isi = end.copy()
+        last_isi[0] = False
+        last_isi[1:] &= ~start[1:]
+        st[vpos[last_isi], _PREV_ISI] = isi[last_isi[1:]]
+
+        st[:, _COUNT] += np.bincount(pos, minlength=num)
+
+
 # ----------------------- #
 # Get activity properties #
 # ----------------------- #
@@ -165,9 +363,14 @@ def total_firing_rate(network=None, spike_detector=None, nodes=None, data=None,
     rate = np.zeros(len(times))
 
     # counts the spikes at each time
-    pos = find_idx_nearest(times, data[:, 1])
-    bins = np.linspace(0, len(times), len(times)+1)
-    counts, _ = np.histogram(pos, bins=bins)
+    histogram = _compiled_spike_function("_spike_histogram")
+
+    if histogram is not None:
+        counts = histogram(data[:, 1], times[0], resolution, len(times))
+    else:
+        pos = find_idx_nearest(times, data[:, 1])
+        bins = np.linspace(0, len(times), len(times)+1)
+        counts, _ = np.histogram(pos, bins=bins)
 
     # initialize with delta rate in Hz
     rate += 1000. * counts / (kernel_std*np.sqrt(np.pi))
@@ -263,33 +466,39 @@ def get_spikes(recorder=None, spike_times=None, senders=None, astype="ssp"):
 # ----- #
 
 def _b2_from_data(ids, data):
-    b2 = np.full(len(ids), np.NaN)
-    if len(data[:, 0]) > 0:
-        for i, neuron in enumerate(ids):
-            ids = np.where(data[:, 0] == neuron)[0]
-            dt1 = np.diff(data[ids, 1])
-            dt2 = dt1[1:] + dt1[:-1]
-            avg_isi = np.mean(dt1)
-            if avg_isi != 0.:
-                b2[i] = (2*np.var(dt1) - np.var(dt2)) / (2*avg_isi**2)
-            else:
-                b2[i] = np.inf
-    else:
+    if not len(data[:, 0]):
         _log_message(logger, "WARNING", 'No spikes in the data.')
-    return b2
+        return np.full(len(ids), np.NaN)
+
+    stats = SpikeStatistics(ids)
+    stats.add(data[:, 0], data[:, 1])
+
+    return stats.b2()
 
 
 def _fr_from_data(ids, data):
-    fr = np.zeros(len(ids))
+    if not len(data[:, 0]):
+        return np.zeros(len(ids))
+
+    stats = SpikeStatistics(ids)
+    stats.add(data[:, 0], data[:, 1])
 
-    if len(data[:, 0]):
-        T = float(np.max(data[:, 1]) - np.min(data[:, 1]))
+    return stats.firing_rate()
 
-        for i, neuron in enumerate(ids):
-            ids = np.where(data[:, 0] == neuron)[0]
-            fr[i] = len(ids) / T
 
-    return fr
+def _compiled_spike_function(name):
+    '''
+    C++ spike analysis function `name` if the multithreaded algorithms are
+    available, None otherwise.
+    '''
+    if nngt.get_config("multithreading"):
+        try:
+            import nngt.generation.cconnect as cconnect
+            return getattr(cconnect, name)
+        except ImportError:
+            pass
+
+    return None
 
 
 def _set_data_nodes(network, data, nodes):
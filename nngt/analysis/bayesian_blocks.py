@@ -18,6 +18,8 @@ References
 
 import numpy as np
 
+import nngt
+
 
 class FitnessFunc:
 
@@ -344,42 +346,54 @@ def bayesian_blocks(t, x=None, sigma=None, fitness='events', **kwargs):
     best = np.zeros(N, dtype=float)
     last = np.zeros(N, dtype=int)
 
-    #-----------------------------------------------------------------
-    # Start with first data cell; add one cell at each iteration
-    #-----------------------------------------------------------------
-    for R in range(N):
-        # Compute fit_vec : fitness of putative last block (end at R)
-        kwds = {}
+    # use the multithreaded C++ loop if possible (positive event counts)
+    event_blocks = None
 
-        # T_k: width/duration of each block
-        if 'T_k' in fitfunc.args:
-            kwds['T_k'] = block_length[:R + 1] - block_length[R + 1]
+    if type(fitfunc) is Events and np.all(x > 0):
+        event_blocks = _compiled_event_blocks()
+
+    if event_blocks is not None:
+        cum_counts = np.concatenate(([0.], np.cumsum(x, dtype=float)))
+        prior = np.zeros(N) + fitfunc.prior(np.arange(1., N + 1), N)
+
+        last = event_blocks(block_length, cum_counts, prior)
+    else:
+        #-----------------------------------------------------------------
+        # Start with first data cell; add one cell at each iteration
+        #-----------------------------------------------------------------
+        for R in range(N):
+            # Compute fit_vec : fitness of putative last block (end at R)
+            kwds = {}
 
-        # N_k: number of elements in each block
-        if 'N_k' in fitfunc.args:
-            kwds['N_k'] = np.cumsum(x[:R + 1][::-1])[::-1]
+            # T_k: width/duration of each block
+            if 'T_k' in fitfunc.args:
+                kwds['T_k'] = block_length[:R + 1] - block_length[R + 1]
 
-        # a_k: eq. 31
-        if 'a_k' in fitfunc.args:
-            kwds['a_k'] = 0.5 * np.cumsum(ak_raw[:R + 1][::-1])[::-1]
+            # N_k: number of elements in each block
+            if 'N_k' in fitfunc.args:
+                kwds['N_k'] = np.cumsum(x[:R + 1][::-1])[::-1]
 
-        # b_k: eq. 32
-        if 'b_k' in fitfunc.args:
-            kwds['b_k'] = - np.cumsum(bk_raw[:R + 1][::-1])[::-1]
+            # a_k: eq. 31
+            if 'a_k' in fitfunc.args:
+                kwds['a_k'] = 0.5 * np.cumsum(ak_raw[:R + 1][::-1])[::-1]
 
-        # c_k: eq. 33
-        if 'c_k' in fitfunc.args:
-            kwds['c_k'] = 0.5 * np.cumsum(ck_raw[:R + 1][::-1])[::-1]
+            # b_k: eq. 32
+            if 'b_k' in fitfunc.args:
+                kwds['b_k'] = - np.cumsum(bk_raw[:R + 1][::-1])[::-1]
 
-        # evaluate fitness function
-        fit_vec = fitfunc.fitness(**kwds)
+            # c_k: eq. 33
+            if 'c_k' in fitfunc.args:
+                kwds['c_k'] = 0.5 * np.cumsum(ck_raw[:R + 1][::-1])[::-1]
 
-        A_R = fit_vec - fitfunc.prior(R + 1, N)
-        A_R[1:] += best[:R]
+            # evaluate fitness function
+            fit_vec = fitfunc.fitness(**kwds)
 
-        i_max = np.argmax(A_R)
-        last[R] = i_max
-        best[R] = A_R[i_max]
+            A_R = fit_vec - fitfunc.prior(R + 1, N)
+            A_R[1:] += best[:R]
+
+            i_max = np.argmax(A_R)
+            last[R] = i_max
+            best[R] = A_R[i_max]
 
     #-----------------------------------------------------------------
     # Now find changepoints by iteratively peeling off the last block
@@ -396,3 +410,18 @@ def bayesian_blocks(t, x=None, sigma=None, fitness='events', **kwargs):
     change_points = change_points[i_cp:]
 
     return edges[change_points]
+
+
+def _compiled_event_blocks():
+    '''
+    C++ Bayesian blocks function for event data if the multithreaded
+    algorithms are available, None otherwise.
+    '''
+    if nngt.get_config("multithreading"):
+        try:
+            from nngt.generation.cconnect import _event_blocks
+            return _event_blocks
+        except ImportError:
+            pass
+
+    return None
@@ -223,52 +223,36 @@ def local_closure(g, directed=True, weights=None, method=None,
         mat /= mat.max()
         mat.setdiag(0)
 
-    mat2, mat3 = None, None
+    # matrices for the 2-walks (sqmat) and the triangles (cbmat)
+    sqmat, cbmat = None, None
+
+    if method == "continuous" and weights is not None:
+        sqmat = mat.sqrt()
+        cbmat = mat.power(2/3)
+    elif method in ("normal", "zhang", None):
+        sqmat, cbmat = mat, mat
+    else:
+        raise ValueError("Unknown `method`: '" + method + "'.'")
+
+    triangle_intensity, diag3 = _triangle_kernels()
 
     if directed:
         # set correct matrix
         if mode.endswith("-in"):
-            mat = mat.T
-
-        if method == "continuous" and weights is not None:
-            sqmat = mat.sqrt()
-            cbmat = mat.power(2/3)
+            sqmat, cbmat = sqmat.T, cbmat.T
 
-            mat2 = sqmat@sqmat
-
-            if mode in ("cycle-in", "cycle-out"):
-                mat3 = cbmat@cbmat@cbmat
-            elif mode in ("fan-in", "fan-out"):
-                mat3 = cbmat@cbmat@cbmat.T
-            else:
-                raise ValueError("Unknown `mode`: '" + mode + "'.'")
-        elif method in ("normal", "zhang", None):
-            mat2 = mat@mat
-
-            if mode in ("cycle-in", "cycle-out"):
-                mat3 = mat2@mat
-            elif mode in ("fan-in", "fan-out"):
-                mat3 = mat2@mat.T
-            else:
-                raise ValueError("Unknown `mode`: '" + mode + "'.'")
+        if mode in ("cycle-in", "cycle-out"):
+            numer = diag3(cbmat, cbmat, cbmat)
+        elif mode in ("fan-in", "fan-out"):
+            numer = diag3(cbmat, cbmat, cbmat.T)
         else:
-            raise ValueError("Unknown `method`: '" + method + "'.'")
+            raise ValueError("Unknown `mode`: '" + mode + "'.'")
     else:
-        # undirected
-        if method == "continuous" and weights is not None:
-            sqmat = mat.sqrt()
-            cbmat = mat.power(2/3)
+        # undirected (symmetric matrix)
+        numer = 2*triangle_intensity(cbmat)
 
-            mat2 = sqmat@sqmat
-            mat3 = cbmat@cbmat@cbmat
-        elif method in ("normal", "zhang", None):
-            mat2 = mat@mat
-            mat3 = mat2@mat
-        else:
-            raise ValueError("Unknown `method`: '" + method + "'.'")
-
-    numer = mat3.diagonal()
-    denom = _sum(mat2, axis=1) - mat2.diagonal()
+    # sum of the 2-walks starting from each node, without the 2-cycles
+    denom = sqmat@_sum(sqmat, axis=1) - _diag2(sqmat, sqmat)
 
     denom[denom == 0] = 1
 
@@ -650,7 +634,7 @@ def triplet_count(g, nodes=None, directed=True, weights=None,
         if mode in ("total", "cycle", "middleman"):
             adj = g.adjacency_matrix()
 
-            d_recip = (adj@adj).diagonal()
+            d_recip = _diag2(adj, adj)
 
             if nodes is not None:
                 d_recip = d_recip[nodes]
@@ -767,17 +751,19 @@ def _triangle_count(mat, matsym, adj, adjsym, method, mode, weighted, directed,
     '''
     tr = None
 
+    triangle_intensity, diag3 = _triangle_kernels()
+
     if method == "barrat":
         if mode == "total":
-            tr = 0.5*(matsym@adjsym@adjsym).diagonal()
+            tr = 0.5*diag3(matsym, adjsym, adjsym)
         elif mode == "cycle":
-            tr = 0.5*(mat@adj@adj + mat.T@adj.T@adj.T).diagonal()
+            tr = 0.5*(diag3(mat, adj, adj) + diag3(mat.T, adj.T, adj.T))
         elif mode == "middleman":
-            tr = 0.5*(mat.T@adj@adj.T + mat@adj.T@adj).diagonal()
+            tr = 0.5*(diag3(mat.T, adj, adj.T) + diag3(mat, adj.T, adj))
         elif mode == "fan-in":
-            tr = 0.5*(mat.T@adjsym@adj).diagonal()
+            tr = 0.5*diag3(mat.T, adjsym, adj)
         elif mode == "fan-out":
-            tr = 0.5*(mat@adjsym@adj.T).diagonal()
+            tr = 0.5*diag3(mat, adjsym, adj.T)
         else:
             raise ValueError("Unknown mode ''.".format(mode))
     else:
@@ -787,15 +773,15 @@ def _triangle_count(mat, matsym, adj, adjsym, method, mode, weighted, directed,
             raise ValueError("Invalid `method`: '{}'".format(method))
 
         if mode == "total":
-            tr = 0.5*(matsym@matsym@matsym).diagonal()
+            tr = triangle_intensity(matsym)
         elif mode == "cycle":
-            tr = (mat@mat@mat).diagonal()
+            tr = diag3(mat, mat, mat)
         elif mode == "middleman":
-            tr = (mat@mat.T@mat).diagonal()
+            tr = diag3(mat, mat.T, mat)
         elif mode == "fan-in":
-            tr = (mat.T@mat@mat).diagonal()
+            tr = diag3(mat.T, mat, mat)
         elif mode == "fan-out":
-            tr = (mat@mat@mat.T).diagonal()
+            tr = diag3(mat, mat, mat.T)
         else:
             raise ValueError("Unknown mode ''.".format(mode))
 
@@ -825,13 +811,13 @@ def _triplet_count_weighted(g, mat, matsym, adj, adjsym, method, mode,
                 s2_sq_tot = np.square(
                     _sum(sqmat, axis=0) + _sum(sqmat, axis=1))
                 s_tot     = _sum(mat, axis=0) + _sum(mat, axis=1)
-                s_recip   = 2*(sqmat@sqmat).diagonal()
+                s_recip   = 2*_diag2(sqmat, sqmat)
 
                 tr = s2_sq_tot - s_tot - s_recip
             elif mode in ("cycle", "middleman"):
                 s_sq_out = _sum(sqmat, axis=0)
                 s_sq_in  = _sum(sqmat, axis=1)
-                s_recip  = (sqmat@sqmat).diagonal()
+                s_recip  = _diag2(sqmat, sqmat)
 
                 tr = s_sq_in*s_sq_out - s_recip
             elif mode in ("fan-in", "fan-out"):
@@ -856,13 +842,13 @@ def _triplet_count_weighted(g, mat, matsym, adj, adjsym, method, mode,
             if mode == "total":
                 s2_sq_tot = np.square(_sum(mat, axis=0) + _sum(mat, axis=1))
                 s_tot     = _sum(mat2, axis=0) + _sum(mat2, axis=1)
-                s_recip   = 2*(mat@mat).diagonal()
+                s_recip   = 2*_diag2(mat, mat)
 
                 tr = s2_sq_tot - s_tot - s_recip
             elif mode in ("cycle", "middleman"):
                 s_sq_out = _sum(mat, axis=0)
                 s_sq_in  = _sum(mat, axis=1)
-                s_recip  = (mat@mat).diagonal()
+                s_recip  = _diag2(mat, mat)
 
                 tr = s_sq_in*s_sq_out - s_recip
             elif mode in ("fan-in", "fan-out"):
@@ -884,7 +870,7 @@ def _triplet_count_weighted(g, mat, matsym, adj, adjsym, method, mode,
         if directed:
             # specifc definition of the reciprocal strength from Clemente
             if mode == "total":
-                s_recip = 0.5*(mat@adj + adj@mat).diagonal()
+                s_recip = 0.5*(_diag2(mat, adj) + _diag2(adj, mat))
 
                 dtot = g.get_degrees("total")
                 wmax = np.max(g.get_weights())
@@ -892,7 +878,7 @@ def _triplet_count_weighted(g, mat, matsym, adj, adjsym, method, mode,
 
                 tr = stot*(dtot - 1) - 2*s_recip
             elif mode in ("cycle", "middleman"):
-                s_recip = 0.5*(mat@adj + adj@mat).diagonal()
+                s_recip = 0.5*(_diag2(mat, adj) + _diag2(adj, mat))
                 s_in    = _sum(mat, axis=0)
                 s_out   = _sum(mat, axis=1)
                 d_in    = g.get_degrees("in")
@@ -927,6 +913,39 @@ def _triplet_count_weighted(g, mat, matsym, adj, adjsym, method, mode,
     return tr[nodes]
 
 
+def _diag2(a, b):
+    ''' Diagonal of a@b without computing the product '''
+    return _sum(a.multiply(b.T), axis=1)
+
+
+def _py_product_diagonal(x, y, z):
+    ''' Diagonal of x@y@z (scipy fallback of the C++ kernel) '''
+    return (x@y@z).diagonal()
+
+
+def _py_triangle_intensity(matsym):
+    ''' Half the diagonal of matsym^3 (scipy fallback of the C++ kernel) '''
+    return 0.5*(matsym@matsym@matsym).diagonal()
+
+
+def _triangle_kernels():
+    '''
+    Return the functions computing the triangle intensities for a symmetric
+    matrix and the diagonal of a product of three matrices: the C++ kernels,
+    which do not materialise the matrix products, if the multithreaded
+    algorithms are available, the scipy versions otherwise.
+    '''
+    if nngt.get_config("multithreading"):
+        try:
+            from nngt.generation.cconnect import (_product_diagonal,
+                                                  _triangle_intensity)
+            return _triangle_intensity, _product_diagonal
+        except ImportError:
+            pass
+
+    return _py_triangle_intensity, _py_product_diagonal
+
+
 def _sum(mat, axis):
     ''' Sum either sparse matrix or array '''
     res = mat.sum(axis=axis)
@@ -10,6 +10,8 @@ from collections import deque
 import numpy as np
 import scipy.sparse as ssp
 
+import nngt
+
 
 def adj_mat(g, weight=None, mformat="csr"):
     data = None
@@ -22,6 +24,10 @@ def adj_mat(g, weight=None, mformat="csr"):
     else:
         data = np.ones(num_edges)
 
+    if g._graph._compact is not None:
+        # the compact storage is already indexed in CSR format
+        return g._graph._compact.adjacency(data, mformat)
+
     if not g.is_directed():
         data = np.repeat(data, 2)
 
@@ -60,6 +66,11 @@ def reciprocity(g):
 
     g = g._graph
 
+    if g._compact is not None:
+        reciprocal = g._compact.edge_ids(g._compact.edges[:, ::-1])
+
+        return np.sum(reciprocal >= 0) / num_edges
+
     num_recip = sum((1 if e[::-1] in g._edges else 0 for e in g._edges))
 
     return num_recip / num_edges
@@ -97,6 +108,13 @@ def connected_components(g, ctype=None):
 
     num_nodes = g.node_nb()
 
+    components_engine = _compiled_components()
+
+    if components_engine is not None:
+        strong = ctype == "scc" and g.is_directed()
+
+        return components_engine(g.edges_array, num_nodes, strong)
+
     all_nodes = set(g.get_nodes())
 
     all_seen = set()
@@ -185,12 +203,27 @@ def connected_components(g, ctype=None):
 
     order = np.argsort(hist)[::-1]
 
-    for i, s in zip(order, components):
-        labels[list(s)] = i
+    for i, idx in enumerate(order):
+        labels[list(components[idx])] = i
 
     return labels, hist[order]
 
 
+def _compiled_components():
+    '''
+    C++ connected components function if the multithreaded algorithms are
+    available, None otherwise.
+    '''
+    if nngt.get_config("multithreading"):
+        try:
+            from nngt.generation.cconnect import _connected_components
+            return _connected_components
+        except ImportError:
+            pass
+
+    return None
+
+
 def _dfs(adjacency, start):
     '''
     Depth-first search returning all nodes that can be reached from a
@@ -171,13 +171,16 @@ class Graph(nngt.core.GraphObject):
     def from_file(filename, fmt="auto", separator=" ", secondary=";",
                   attributes=None, attributes_types=None, notifier="@",
                   ignore="#", from_string=False, name=None,
-                  directed=True, cleanup=False):
+                  directed=True, cleanup=False, checksums=False):
         '''
         Import a saved graph from a file.
 
         .. versionchanged :: 2.0
             Added optional `attributes_types` and `cleanup` arguments.
 
+        .. versionchanged :: 2.8
+            Added the "binary" format and the `checksums` argument.
+
         Parameters
         ----------
         filename: str
@@ -191,7 +194,8 @@ class Graph(nngt.core.GraphObject):
             default if `filename` ends with '.graphml' or '.xml'), "dot" (dot
             format, default if `filename` ends with '.dot'), "gt" (only
             when using `graph_tool <http://graph-tool.skewed.de/>`_ as library,
-            detected if `filename` ends with '.gt').
+            detected if `filename` ends with '.gt'), "binary" (NNGT binary
+            format, detected if `filename` ends with '.nngt').
         separator : str, optional (default " ")
             separator used to separate inputs in the case of custom formats
             (namely "neighbour" and "edge_list")
@@ -230,6 +234,9 @@ class Graph(nngt.core.GraphObject):
         cleanup : bool, optional (default: False)
            If true, removes nodes before the first one that appears in the
            edges and after the last one and renumber the nodes from 0.
+        checksums : bool, optional (default: False)
+            For the "binary" format, also check the memory-mapped blocks
+            against their CRC32 (requires reading the whole file).
 
         Returns
         -------
@@ -238,7 +245,7 @@ class Graph(nngt.core.GraphObject):
         '''
         fmt = _get_format(fmt, filename)
 
-        if fmt not in di_get_edges:
+        if fmt not in di_get_edges and fmt != "binary":
             # only partial support for these formats, relying on backend
             libgraph = _library_load(filename, fmt)
 
@@ -252,7 +259,7 @@ class Graph(nngt.core.GraphObject):
             filename=filename, fmt=fmt, separator=separator, ignore=ignore,
             secondary=secondary, attributes=attributes,
             attributes_types=attributes_types, notifier=notifier,
-            cleanup=cleanup)
+            cleanup=cleanup, checksums=checksums)
 
         # create the graph
         name = info.get("name", "LoadedGraph") if name is None else name
@@ -633,7 +640,7 @@ class Graph(nngt.core.GraphObject):
         return gc_instance
 
     def to_file(self, filename, fmt="auto", separator=" ", secondary=";",
-                attributes=None, notifier="@"):
+                attributes=None, notifier="@", compression=None):
         '''
         Save graph to file; options detailed below.
 
@@ -643,7 +650,7 @@ class Graph(nngt.core.GraphObject):
         '''
         save_to_file(self, filename, fmt=fmt, separator=separator,
                      secondary=secondary, attributes=attributes,
-                     notifier=notifier)
+                     notifier=notifier, compression=compression)
 
     #~ def inhibitory_subgraph(self):
         #~ ''' Create a :class:`~nngt.Graph` instance which graph
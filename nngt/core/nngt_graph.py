@@ -10,14 +10,14 @@ from copy import deepcopy
 import logging
 
 import numpy as np
-from scipy.sparse import coo_matrix, lil_matrix
+from scipy.sparse import coo_matrix, csr_matrix, lil_matrix
 
 import nngt
-from nngt.analysis.nngt_functions import _dfs
+from nngt.analysis.nngt_functions import _compiled_components, _dfs
 from nngt.lib import InvalidArgument, nonstring_container, is_integer
 from nngt.lib.connect_tools import (_cleanup_edges, _set_dist_new_edges,
                                     _set_default_edge_attributes)
-from nngt.lib.graph_helpers import _get_edge_attr, _get_dtype, _post_del_update
+from nngt.lib.graph_helpers import _get_dtype, _post_del_update
 from nngt.lib.converters import _np_dtype, _to_np_array
 from nngt.lib.logger import _log_message
 from .graph_interface import GraphInterface, BaseProperty
@@ -294,6 +294,332 @@ class _EProperty(BaseProperty):
             self._num_values_set[key] -= len(eids)
 
 
+# --------------- #
+# Compact storage #
+# --------------- #
+
+class _CompactEdges:
+    '''
+    Compact edge storage for the native backend (``"csr"`` storage).
+
+    Edges are stored by order of creation (their edge id) in a contiguous
+    (E, 2) array.
+    Out-neighbours (CSR) and in-neighbours (CSC) are indexed lazily: edges
+    added since the last query are merged into the index the next time it is
+    needed, while deletions trigger a full rebuild.
+    Each index is made of an `indptr` array (size N + 1), the sorted
+    neighbours of each node, and the associated edge ids; for undirected
+    graphs, a single index contains both orientations of each edge.
+    '''
+
+    #: number of unindexed edges that are scanned before merging them
+    pending_max = 1024
+
+    def __init__(self, num_nodes, directed):
+        self.directed  = directed
+        self.num_nodes = num_nodes
+
+        self._edges   = np.empty((0, 2), dtype=np.int64)
+        self._num     = 0
+        self._indexed = 0     # number of edges in the index
+        self._out     = None  # (indptr, neighbours, eids) by source
+        self._in      = None  # (indptr, neighbours, eids) by target
+
+    def __len__(self):
+        return self._num
+
+    def copy(self):
+        ''' Returns a deep copy of the storage '''
+        copy = _CompactEdges(self.num_nodes, self.directed)
+
+        copy._edges   = self.edges.copy()
+        copy._num     = self._num
+        copy._indexed = self._indexed
+
+        if self._out is not None:
+            copy._out = tuple(a.copy() for a in self._out)
+            copy._in  = copy._out if not self.directed else \
+                        tuple(a.copy() for a in self._in)
+
+        return copy
+
+    @property
+    def edges(self):
+        ''' View on the (E, 2) array of edges, sorted by edge id '''
+        return self._edges[:self._num]
+
+    # mutations
+
+    def add_nodes(self, n):
+        ''' Add `n` nodes without edges '''
+        self.num_nodes += n
+
+        if self._out is not None:
+            self._out = self._extend_ptr(self._out, n)
+            self._in  = self._out if not self.directed else \
+                        self._extend_ptr(self._in, n)
+
+    def append(self, edges):
+        '''
+        Add new edges at the end (ids ``len(self)`` to
+        ``len(self) + len(edges)``), they are indexed lazily.
+        '''
+        edges = np.asarray(edges, dtype=np.int64).reshape(-1, 2)
+
+        num_new = len(edges)
+        total   = self._num + num_new
+
+        if total > len(self._edges):
+            # amortized growth
+            new_storage = np.empty((max(total, 2*len(self._edges)), 2),
+                                   dtype=np.int64)
+
+            new_storage[:self._num] = self.edges
+
+            self._edges = new_storage
+
+        self._edges[self._num:total] = edges
+        self._num = total
+
+    def delete(self, eids):
+        ''' Remove edges, the ids of the remaining edges are shifted '''
+        keep = np.ones(self._num, dtype=bool)
+        keep[np.asarray(eids, dtype=np.int64)] = False
+
+        self._edges = self.edges[keep]
+        self._num   = len(self._edges)
+
+        self._reset_index()
+
+    def delete_nodes(self, nodes):
+        '''
+        Remove nodes and their edges, the remaining nodes are renumbered.
+
+        Returns the removed edge ids.
+        '''
+        removed = np.zeros(self.num_nodes, dtype=bool)
+        removed[list(nodes)] = True
+
+        edges    = self.edges
+        del_eids = np.flatnonzero(removed[edges[:, 0]]
+                                  | removed[edges[:, 1]])
+
+        remapping = np.cumsum(~removed) - 1
+
+        self.delete(del_eids)
+
+        self._edges    = remapping[self._edges]
+        self.num_nodes = int(np.sum(~removed))
+
+        return del_eids
+
+    def clear(self):
+        ''' Remove all edges '''
+        self._edges = np.empty((0, 2), dtype=np.int64)
+        self._num   = 0
+
+        self._reset_index()
+
+    # queries
+
+    def edge_id(self, s, t):
+        ''' Id of the edge (s, t), -1 if it does not exist '''
+        indptr, neighbours, eids = self._index(lookup=True)[0]
+
+        start, stop = indptr[s], indptr[s + 1]
+
+        i = start + np.searchsorted(neighbours[start:stop], t)
+
+        if i < stop and neighbours[i] == t:
+            return int(eids[i])
+
+        # edges that were not indexed yet
+        pending = self.edges[self._indexed:]
+
+        found = (pending[:, 0] == s) & (pending[:, 1] == t)
+
+        if not self.directed:
+            found |= (pending[:, 0] == t) & (pending[:, 1] == s)
+
+        found = np.flatnonzero(found)
+
+        return self._indexed + int(found[0]) if len(found) else -1
+
+    def edge_ids(self, edges):
+        ''' Ids of an array of edges, -1 for missing edges '''
+        indptr, neighbours, eids = self._index()[0]
+
+        edges = np.asarray(edges, dtype=np.int64).reshape(-1, 2)
+
+        # edges define a sorted key in the index
+        n    = self.num_nodes
+        rows = np.repeat(np.arange(n, dtype=np.int64), np.diff(indptr))
+        keys = rows*n + neighbours
+
+        if len(keys) == 0:
+            return np.full(len(edges), -1, dtype=np.int64)
+
+        queries = edges[:, 0]*n + edges[:, 1]
+
+        pos = np.minimum(np.searchsorted(keys, queries), len(keys) - 1)
+
+        return np.where(keys[pos] == queries, eids[pos], -1)
+
+    def degrees(self, mode="total"):
+        ''' Degrees of all nodes '''
+        index = self._index()
+
+        if not self.directed:
+            return np.diff(index[0][0])
+
+        if mode == "in":
+            return np.diff(index[1][0])
+
+        if mode == "out":
+            return np.diff(index[0][0])
+
+        return np.diff(index[0][0]) + np.diff(index[1][0])
+
+    def neighbours(self, node, mode="out"):
+        ''' View on the out- or in-neighbours of `node` '''
+        index = self._index()
+
+        indptr, neighbours, _ = index[1] if mode == "in" else index[0]
+
+        return neighbours[indptr[node]:indptr[node + 1]]
+
+    def adjacency(self, data, mformat="csr"):
+        '''
+        Adjacency matrix built on the index (`data` contains the value
+        associated to each edge id).
+        '''
+        indptr, neighbours, eids = self._index()[0]
+
+        n = self.num_nodes
+
+        values = np.asarray(data)[eids]
+
+        if not self.directed:
+            # self-loops are indexed in both orientations, count them once
+            rows  = np.repeat(np.arange(n, dtype=np.int64), np.diff(indptr))
+            loops = np.where(rows == neighbours)[0]
+
+            if len(loops):
+                _, first = np.unique(eids[loops], return_index=True)
+
+                keep = np.ones(len(eids), dtype=bool)
+                keep[loops] = False
+                keep[loops[first]] = True
+
+                rows, neighbours, values = \
+                    rows[keep], neighbours[keep], values[keep]
+
+                indptr = np.zeros(n + 1, dtype=np.int64)
+                np.cumsum(np.bincount(rows, minlength=n), out=indptr[1:])
+
+        mat = csr_matrix((values, neighbours, indptr), shape=(n, n))
+
+        # as for the coo conversion, duplicate edges are summed
+        mat.sum_duplicates()
+
+        return mat.asformat(mformat)
+
+    # index
+
+    def _index(self, lookup=False):
+        '''
+        Returns the (out, in) indices, merging the new edges in them.
+
+        For lookups, only large numbers of new edges are merged, the others
+        are scanned.
+        '''
+        if self._out is None:
+            self._build_index()
+        elif self._indexed < self._num:
+            if not lookup or self._num - self._indexed > self.pending_max:
+                self._merge_index()
+
+        return self._out, self._in
+
+    def _entries(self, start, reverse):
+        ''' (rows, columns, eids) of the edges from `start` in an index '''
+        edges = self.edges[start:]
+        eids  = np.arange(start, self._num, dtype=np.int64)
+
+        sources, targets = edges[:, 0], edges[:, 1]
+
+        if not self.directed:
+            # both orientations
+            return (np.concatenate((sources, targets)),
+                    np.concatenate((targets, sources)),
+                    np.concatenate((eids, eids)))
+
+        if reverse:
+            return targets, sources, eids
+
+        return sources, targets, eids
+
+    def _build_index(self):
+        self._out = self._build(*self._entries(0, False))
+
+        self._in = self._out if not self.directed else \
+                   self._build(*self._entries(0, True))
+
+        self._indexed = self._num
+
+    def _build(self, rows, cols, eids):
+        # lexsort is stable, so equal entries stay sorted by edge id
+        order = np.lexsort((cols, rows))
+
+        indptr = np.zeros(self.num_nodes + 1, dtype=np.int64)
+        np.cumsum(np.bincount(rows, minlength=self.num_nodes),
+                  out=indptr[1:])
+
+        return indptr, cols[order], eids[order]
+
+    def _merge_index(self):
+        self._out = self._merge(self._out,
+                                *self._entries(self._indexed, False))
+
+        self._in = self._out if not self.directed else \
+                   self._merge(self._in, *self._entries(self._indexed, True))
+
+        self._indexed = self._num
+
+    def _merge(self, index, rows, cols, eids):
+        ''' Insert the new entries in the sorted index in O(E) '''
+        indptr, neighbours, old_eids = index
+
+        n = self.num_nodes
+
+        order = np.lexsort((cols, rows))
+        rows, cols, eids = rows[order], cols[order], eids[order]
+
+        old_rows = np.repeat(np.arange(n, dtype=np.int64), np.diff(indptr))
+
+        # new edges have larger ids, so they go after equal entries
+        pos = np.searchsorted(old_rows*n + neighbours, rows*n + cols,
+                              side="right")
+
+        new_indptr = indptr.copy()
+        new_indptr[1:] += np.cumsum(np.bincount(rows, minlength=n))
+
+        return (new_indptr, np.insert(neighbours, pos, cols),
+                np.insert(old_eids, pos, eids))
+
+    def _extend_ptr(self, index, n):
+        indptr, neighbours, eids = index
+
+        indptr = np.concatenate((indptr, np.full(n, indptr[-1])))
+
+        return indptr, neighbours, eids
+
+    def _reset_index(self):
+        self._out     = None
+        self._in      = None
+        self._indexed = 0
+
+
 # ----------------- #
 # NNGT backup graph #
 # ----------------- #
@@ -304,20 +630,40 @@ class _NNGTGraphObject:
     graph-library.
     '''
 
-    def __init__(self, nodes=0, weighted=True, directed=True):
-        ''' Initialized independent graph '''
+    def __init__(self, nodes=0, weighted=True, directed=True, storage=None):
+        '''
+        Initialized independent graph
+
+        `storage` is either "dict" (ordered dictionaries of edge tuples) or
+        "csr" (compact arrays, see :class:`_CompactEdges`); it defaults to
+        the "nngt_storage" configuration entry.
+        '''
+        storage = nngt._config.get("nngt_storage", "dict") \
+                  if storage is None else storage
+
+        if storage not in ("dict", "csr"):
+            raise ValueError("`storage` must be either 'dict' or 'csr'.")
+
         self._nodes    = set(i for i in range(nodes))
-        self._out_deg  = [0]*nodes
-        self._in_deg   = [0]*nodes
+        self._compact  = None
 
-        if directed:
-            # for directed networks, edges and unique are the same
-            self._edges = self._unique = OrderedDict()
-            assert self._edges is self._unique
+        if storage == "csr":
+            # edges and degrees are only stored in the compact storage
+            self._compact = _CompactEdges(nodes, directed)
+            self._edges   = self._unique = None
+            self._out_deg = self._in_deg = None
         else:
-            # for undirected networks
-            self._edges  = OrderedDict()
-            self._unique = OrderedDict()
+            self._out_deg  = np.zeros(nodes, dtype=int)
+            self._in_deg   = np.zeros(nodes, dtype=int)
+
+            if directed:
+                # for directed networks, edges and unique are the same
+                self._edges = self._unique = OrderedDict()
+                assert self._edges is self._unique
+            else:
+                # for undirected networks
+                self._edges  = OrderedDict()
+                self._unique = OrderedDict()
 
         self._directed = directed
         self._weighted = weighted
@@ -325,10 +671,17 @@ class _NNGTGraphObject:
     def copy(self):
         ''' Returns a deep copy of the graph object '''
         copy = _NNGTGraphObject(len(self._nodes), weighted=self._weighted,
-                                directed=self._directed)
+                                directed=self._directed,
+                                storage="dict" if self._compact is None
+                                else "csr")
 
         copy._nodes   = self._nodes.copy()
 
+        if self._compact is not None:
+            copy._compact = self._compact.copy()
+
+            return copy
+
         if self._directed:
             copy._unique = copy._edges = self._edges.copy()
             assert copy._unique is copy._edges
@@ -392,6 +745,21 @@ class _NNGTGraph(GraphInterface):
         '''
         g = self._graph
 
+        if g._compact is not None and is_integer(edge[0]):
+            eid = g._compact.edge_id(*edge)
+
+            if eid < 0:
+                raise KeyError(tuple(edge))
+
+            return eid
+        elif g._compact is not None and nonstring_container(edge[0]):
+            eids = g._compact.edge_ids(edge)
+
+            if np.any(eids < 0):
+                raise KeyError(tuple(edge[int(np.argmax(eids < 0))]))
+
+            return eids.tolist()
+
         if is_integer(edge[0]):
             return g._edges[tuple(edge)]
         elif nonstring_container(edge[0]):
@@ -407,9 +775,14 @@ class _NNGTGraph(GraphInterface):
 
         .. versionadded:: 2.0
         '''
+        g = self._graph
+
+        if g._compact is not None:
+            return g._compact.edge_id(*edge) >= 0
+
         e = tuple(edge)
 
-        return e in self._graph._edges
+        return e in g._edges
 
     @property
     def edges_array(self):
@@ -417,7 +790,12 @@ class _NNGTGraph(GraphInterface):
         Edges of the graph, sorted by order of creation, as an array of
         2-tuple.
         '''
-        return np.asarray(list(self._graph._unique), dtype=int)
+        g = self._graph
+
+        if g._compact is not None:
+            return g._compact.edges.astype(int)
+
+        return np.asarray(list(g._unique), dtype=int)
 
     def _get_edges(self, source_node=None, target_node=None):
         '''
@@ -426,6 +804,9 @@ class _NNGTGraph(GraphInterface):
         '''
         g = self._graph
 
+        if g._compact is not None:
+            return self._get_compact_edges(source_node, target_node)
+
         if source_node is not None:
             source_node = \
                 {source_node} if is_integer(source_node) else set(source_node)
@@ -464,6 +845,38 @@ class _NNGTGraph(GraphInterface):
         return [e for e in g._unique
                 if e[0] in target_node or e[1] in target_node]
 
+    def _get_compact_edges(self, source_node=None, target_node=None):
+        ''' _get_edges for the compact storage '''
+        g     = self._graph
+        edges = g._compact.edges
+
+        def ends(nodes):
+            ''' Whether each source and each target is in `nodes` '''
+            nodes = [nodes] if is_integer(nodes) else list(nodes)
+
+            return (np.isin(edges[:, 0], nodes), np.isin(edges[:, 1], nodes))
+
+        keep = np.ones(len(edges), dtype=bool)
+
+        if source_node is not None and target_node is not None:
+            src_s, tgt_s = ends(source_node)
+            src_t, tgt_t = ends(target_node)
+
+            keep = src_s & tgt_t
+
+            if not g._directed:
+                keep |= tgt_s & src_t
+        elif source_node is not None:
+            src_s, tgt_s = ends(source_node)
+
+            keep = src_s if g._directed else src_s | tgt_s
+        elif target_node is not None:
+            src_t, tgt_t = ends(target_node)
+
+            keep = tgt_t if g._directed else src_t | tgt_t
+
+        return list(map(tuple, edges[keep].tolist()))
+
     def is_connected(self, mode="strong"):
         '''
         Return whether the graph is connected.
@@ -476,6 +889,15 @@ class _NNGTGraph(GraphInterface):
         '''
         num_nodes = self.node_nb()
 
+        components_engine = _compiled_components()
+
+        if components_engine is not None:
+            strong = mode == "strong" and self.is_directed()
+
+            _, hist = components_engine(self.edges_array, num_nodes, strong)
+
+            return len(hist) <= 1
+
         # get adjacency matrix
         A = self.adjacency_matrix()
 
@@ -525,16 +947,19 @@ class _NNGTGraph(GraphInterface):
 
         g = self._graph
 
-        if n == 1:
+        if g._compact is not None:
+            nodes.extend(range(len(g._nodes), len(g._nodes) + n))
+            g._compact.add_nodes(n)
+        elif n == 1:
             nodes.append(len(g._nodes))
-            g._in_deg.append(0)
-            g._out_deg.append(0)
+            g._in_deg  = np.append(g._in_deg, 0)
+            g._out_deg = np.append(g._out_deg, 0)
         else:
             num_nodes = len(g._nodes)
             nodes.extend(
                 [i for i in range(num_nodes, num_nodes + n)])
-            g._in_deg.extend([0 for _ in range(n)])
-            g._out_deg.extend([0 for _ in range(n)])
+            g._in_deg  = np.concatenate((g._in_deg, np.zeros(n, dtype=int)))
+            g._out_deg = np.concatenate((g._out_deg, np.zeros(n, dtype=int)))
 
         g._nodes.update(nodes)
 
@@ -606,8 +1031,10 @@ class _NNGTGraph(GraphInterface):
             g._nodes = g._nodes.difference(nodes)
         else:
             g._nodes.remove(nodes)
-            g._out_deg.pop(nodes)
-            g._in_deg.pop(nodes)
+
+            if g._compact is None:
+                g._out_deg = np.delete(g._out_deg, nodes)
+                g._in_deg  = np.delete(g._in_deg, nodes)
 
             nodes = {nodes}
 
@@ -627,24 +1054,29 @@ class _NNGTGraph(GraphInterface):
         # remove edges and remap edges
         remove_eids = set()
 
-        new_edges  = OrderedDict()
+        if g._compact is not None:
+            remove_eids.update(g._compact.delete_nodes(nodes).tolist())
 
-        new_eid = 0
+            self._max_eid = len(g._compact)
+        else:
+            new_edges  = OrderedDict()
 
-        for e, eid in g._unique.items():
-            if e[0] in nodes or e[1] in nodes:
-                remove_eids.add(eid)
-            else:
-                new_edges[(remapping[e[0]], remapping[e[1]])] = new_eid
-                new_eid += 1
+            new_eid = 0
 
-        g._unique = new_edges
+            for e, eid in g._unique.items():
+                if e[0] in nodes or e[1] in nodes:
+                    remove_eids.add(eid)
+                else:
+                    new_edges[(remapping[e[0]], remapping[e[1]])] = new_eid
+                    new_eid += 1
 
-        if not g._directed:
-            g._edges = new_edges.copy()
-            g._edges.update({e[::-1]: i for e, i in new_edges.items()})
-        else:
-            g._edges = g._unique
+            g._unique = new_edges
+
+            if not g._directed:
+                g._edges = new_edges.copy()
+                g._edges.update({e[::-1]: i for e, i in new_edges.items()})
+            else:
+                g._edges = g._unique
 
         # tell edge attributes
         self._eattr.edges_deleted(remove_eids)
@@ -707,7 +1139,21 @@ class _NNGTGraph(GraphInterface):
 
                 return None
 
-        if (g._directed and edge not in g._unique) or edge not in g._edges:
+        if g._compact is not None:
+            is_new = g._compact.edge_id(source, target) < 0
+        else:
+            is_new = (g._directed and edge not in g._unique) \
+                     or edge not in g._edges
+
+        if is_new and g._compact is not None:
+            g._compact.append([edge])
+
+            self._max_eid += 1
+
+            _set_dist_new_edges(attributes, self, [edge])
+
+            self._attr_new_edges([(source, target)], attributes=attributes)
+        elif is_new:
             edge_id             = self._max_eid
             # ~ edge_id             = len(g._unique)
             g._unique[edge]     = edge_id
@@ -809,38 +1255,40 @@ class _NNGTGraph(GraphInterface):
             else:
                 new_attr = attributes
 
-            # create the edges
+            # create the edges in bulk
             initial_eid = self._max_eid
+            num_added   = len(edge_list)
 
-            ws        = None
-            num_added = len(edge_list)
-
-            if "weight" in new_attr:
-                if nonstring_container(new_attr["weight"]):
-                    ws = new_attr["weight"]
-                else:
-                    ws = (new_attr["weight"] for _ in range(num_added))
-            else:
-                ws = _get_edge_attr(self, edge_list, "weight", last_edges=True)
+            if num_added and g._compact is not None:
+                g._compact.append(edge_list)
 
-            for i, (e, w) in enumerate(zip(edge_list, ws)):
-                eid = self._max_eid
+                self._max_eid += num_added
+            elif num_added:
+                edge_array = np.asarray(edge_list, dtype=np.int64)
+                tuples     = list(map(tuple, edge_array.tolist()))
+                eids       = range(initial_eid, initial_eid + num_added)
 
-                g._unique[tuple(e)] = eid
+                g._unique.update(zip(tuples, eids))
 
-                self._max_eid += 1
+                self._max_eid += num_added
 
-                g._out_deg[e[0]] += 1
-                g._in_deg[e[1]]  += 1
+                sources, targets = edge_array[:, 0], edge_array[:, 1]
 
                 if not g._directed:
                     # edges and unique are different objects, so update _edges
-                    g._edges[tuple(e)] = eid
-                    # reciprocal edge
-                    g._edges[tuple(e[::-1])] = eid
+                    # with each edge followed by its reciprocal (this order is
+                    # used by adj_mat)
+                    reciprocal = map(tuple, edge_array[:, ::-1].tolist())
+
+                    for e, e_recip, eid in zip(tuples, reciprocal, eids):
+                        g._edges[e]       = eid
+                        g._edges[e_recip] = eid
 
-                    g._out_deg[e[1]] += 1
-                    g._in_deg[e[0]]  += 1
+                    sources = targets = edge_array.ravel()
+
+                # only the entries of the new edges are touched
+                np.add.at(g._out_deg, sources, 1)
+                np.add.at(g._in_deg, targets, 1)
 
             # check distance
             _set_dist_new_edges(new_attr, self, edge_list)
@@ -852,7 +1300,20 @@ class _NNGTGraph(GraphInterface):
 
     def delete_edges(self, edges):
         ''' Remove a list of edges '''
-        if len(edges):
+        if len(edges) and self._graph._compact is not None:
+            g = self._graph
+
+            if not nonstring_container(edges[0]):
+                edges = [edges]
+
+            eids = self.edge_id(edges)
+
+            g._compact.delete(eids)
+
+            self._max_eid = len(g._compact)
+
+            self._eattr.edges_deleted(set(eids))
+        elif len(edges):
             g = self._graph
 
             old_enum = len(g._unique)
@@ -899,6 +1360,14 @@ class _NNGTGraph(GraphInterface):
     def clear_all_edges(self):
         g = self._graph
 
+        if g._compact is not None:
+            g._compact.clear()
+
+            self._max_eid = 0
+            self._eattr.clear()
+
+            return
+
         if g._directed:
             g._edges = g._unique = OrderedDict()
             assert g._edges is g._unique
@@ -906,8 +1375,8 @@ class _NNGTGraph(GraphInterface):
             g._edges  = OrderedDict()
             g._unique = OrderedDict()
 
-        g._out_deg = [0 for _ in range(self.node_nb())]
-        g._out_deg = [0 for _ in range(self.node_nb())]
+        g._out_deg = np.zeros(self.node_nb(), dtype=int)
+        g._in_deg  = np.zeros(self.node_nb(), dtype=int)
 
         self._eattr.clear()
 
@@ -928,7 +1397,12 @@ class _NNGTGraph(GraphInterface):
 
         .. warning:: When using MPI, returns only the local number of edges.
         '''
-        return len(self._graph._unique)
+        g = self._graph
+
+        if g._compact is not None:
+            return len(g._compact)
+
+        return len(g._unique)
 
     def is_directed(self):
         return g._directed
@@ -970,19 +1444,18 @@ class _NNGTGraph(GraphInterface):
             raise ValueError("Invalid `weights` {}".format(weights))
 
         # unweighted
+        if g._compact is not None:
+            degrees = g._compact.degrees(mode)[nodes]
+
+            return degrees[0] if num_nodes == 1 else degrees
+
         degrees = np.zeros(num_nodes, dtype=int)
 
         if not g._directed or mode in ("in", "total"):
-            if isinstance(nodes, slice):
-                degrees += g._in_deg[nodes]
-            else:
-                degrees += [g._in_deg[i] for i in nodes]
+            degrees += g._in_deg[nodes]
 
         if g._directed and mode in ("out", "total"):
-            if isinstance(nodes, slice):
-                degrees += g._out_deg[nodes]
-            else:
-                degrees += [g._out_deg[i] for i in nodes]
+            degrees += g._out_deg[nodes]
 
         if num_nodes == 1:
             return degrees[0]
@@ -1008,6 +1481,21 @@ class _NNGTGraph(GraphInterface):
         neighbours : set
             The neighbours of `node`.
         '''
+        compact = self._graph._compact
+
+        if compact is not None:
+            if mode == "all" or not self._graph._directed:
+                neighbours = set(compact.neighbours(node, "out").tolist())
+                neighbours.update(compact.neighbours(node, "in").tolist())
+
+                return neighbours
+
+            if mode in ("in", "out"):
+                return set(compact.neighbours(node, mode).tolist())
+
+            raise ValueError(('Invalid `mode` argument {}; possible values'
+                              'are "all", "out" or "in".').format(mode))
+
         edges = self.edges_array
 
         if mode == "all" or not self._graph._directed:
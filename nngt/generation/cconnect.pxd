@@ -10,7 +10,7 @@ from libcpp.vector cimport vector
 from libcpp.string cimport string
 from libcpp cimport bool
 
-from libc.stdint cimport int64_t, uint64_t
+from libc.stdint cimport int64_t, uint8_t, uint64_t
 
 
 # ---------------------- #
@@ -18,16 +18,150 @@ from libc.stdint cimport int64_t, uint64_t
 # ---------------------- #
 
 cdef extern from "func_connect.h" namespace "generation":
+    cdef cppclass array_view[T]:
+        array_view()
+        array_view(const T* data, size_t size)
+        size_t size()
+
+    ctypedef bool (*edge_sink)(void* data, const int64_t* edges,
+                               const float* dist, size_t num_edges)
+
+    ctypedef float (*distance_kernel)(float distance, float scale,
+                                      float norm) noexcept nogil
+
+    cdef void _register_distance_rule(
+      const string& name, distance_kernel kernel, float cutoff=*) except +
+
+    cdef float _distance_rule_cutoff(const string& rule) except +
+
     cdef void _gen_edges(
-      int64_t* ia_edges, const vector[size_t]& first_nodes,
-      const vector[unsigned int]& degrees, const vector[size_t]& second_nodes,
-      const vector[ vector[size_t] ]& existing_edges, unsigned int idx,
-      bool multigraph, bool directed, vector[long]& seeds) except +
+      int64_t* ia_edges, array_view[size_t] first_nodes,
+      array_view[unsigned int] degrees, array_view[size_t] second_nodes,
+      array_view[int64_t] existing_edges, unsigned int idx,
+      bool multigraph, bool directed, long seed, unsigned int omp,
+      edge_sink sink, void* sink_data, size_t batch_size) except +
+
+    cdef void _gen_edges_batch(
+      int64_t* ia_edges, array_view[size_t] job_nodes,
+      array_view[size_t] first_nodes, array_view[unsigned int] degrees,
+      array_view[size_t] job_targets, array_view[size_t] second_nodes,
+      array_view[uint8_t] idx, array_view[int64_t] existing_edges,
+      bool multigraph, bool directed, long seed, unsigned int omp) except +
 
     cdef void _cdistance_rule(
-      int64_t* ia_edges, const vector[size_t]& source_nodes,
-      const vector[ vector[size_t] ]& target_nodes, const string& rule,
-      float scale, float norm, const vector[float]& x, const vector[float]& y,
-      size_t num_neurons, size_t num_edges,
-      const vector[ vector[size_t] ]& existing_edges, vector[float]& dist,
-      bool multigraph, bool directed, vector[long]& seeds) except +
+      int64_t* ia_edges, array_view[size_t] source_nodes,
+      const size_t* tgt_offsets, const size_t* tgt_indices, const string& rule,
+      float scale, float norm, const float* positions, unsigned int ndim,
+      size_t num_positions, size_t num_neurons, size_t num_edges,
+      array_view[int64_t] existing_edges, float* dist,
+      bool multigraph, bool directed, long seed, unsigned int omp,
+      edge_sink sink, void* sink_data, size_t batch_size) except +
+
+    cdef size_t _cdistance_rule_proba(
+      vector[int64_t]& edges, array_view[size_t] source_nodes,
+      const size_t* tgt_offsets, const size_t* tgt_indices, const string& rule,
+      float scale, float max_proba, const float* positions, unsigned int ndim,
+      size_t num_positions, bool pairs_once, vector[float]& dist, long seed,
+      unsigned int omp, edge_sink sink, void* sink_data,
+      size_t batch_size) except +
+
+    cdef size_t _gen_gnp(
+      vector[int64_t]& edges, array_view[size_t] sources,
+      array_view[size_t] targets, double p, bool one_pop, bool directed,
+      long seed, unsigned int omp) except +
+
+    cdef void _gen_gnm(
+      int64_t* ia_edges, array_view[size_t] sources,
+      array_view[size_t] targets, size_t num_edges, bool one_pop,
+      bool directed, bool multigraph, long seed, unsigned int omp) except +
+
+    cdef void _gen_degree_sequence(
+      int64_t* ia_edges, array_view[size_t] nodes,
+      array_view[size_t] degrees, bool directed, bool multigraph,
+      size_t max_rounds, long seed, unsigned int omp) except +
+
+    cdef size_t _circular_edge_nb(
+      size_t num_nodes, unsigned int coord_nb, double reciprocity,
+      bool directed) except +
+
+    cdef void _gen_circular(
+      int64_t* ia_edges, array_view[size_t] nodes, unsigned int coord_nb,
+      double reciprocity, bool closest, bool directed, long seed,
+      unsigned int omp) except +
+
+    cdef void _gen_newman_watts(
+      int64_t* ia_edges, array_view[size_t] nodes, unsigned int coord_nb,
+      double reciprocity, bool closest, size_t num_edges, bool directed,
+      bool multigraph, long seed, unsigned int omp) except +
+
+    cdef void _gen_watts_strogatz(
+      int64_t* ia_edges, array_view[size_t] nodes, unsigned int coord_nb,
+      double proba, double reciprocity, bool closest, int shuffle,
+      bool directed, long seed, unsigned int omp) except +
+
+    cdef size_t _gen_edge_swaps(
+      int64_t* ia_edges, size_t num_edges, size_t num_nodes,
+      size_t num_swaps, bool directed, const int64_t* groups, long seed,
+      unsigned int omp) except +
+
+    cdef size_t _gen_price(
+      vector[int64_t]& edges, array_view[size_t] nodes, unsigned int m,
+      double c, double gamma, double reciprocity, bool directed,
+      long seed) except +
+
+    cdef size_t _edge_status(
+      array_view[int64_t] edges, array_view[int64_t] existing_edges,
+      bool directed, bool loops, bool existing, uint8_t* status) except +
+
+    cdef void _box_neighbours(
+      array_view[size_t] source_nodes, array_view[size_t] target_nodes,
+      array_view[float] x, array_view[float] y, float lim,
+      bool exclude_self, size_t* tgt_offsets, size_t* tgt_indices,
+      unsigned int omp) except +
+
+
+cdef extern from "func_analysis.h" namespace "generation":
+    cdef cppclass csr_view:
+        csr_view()
+        csr_view(array_view[int64_t] indptr, array_view[int64_t] indices,
+                 array_view[double] data)
+
+    cdef void _triangle_strength(
+      const csr_view& sym, double* strength, unsigned int omp) except +
+
+    cdef void _diag_product(
+      const csr_view& x, const csr_view& y, const csr_view& zt, double* out,
+      unsigned int omp) except +
+
+    cdef size_t _components(
+      array_view[int64_t] edges, size_t num_nodes, bool strong,
+      int64_t* labels, unsigned int omp) except +
+
+    cdef enum spike_stat:
+        NUM_SPIKE_STATS
+
+    cdef void _add_spikes(
+      array_view[int64_t] nodes, array_view[int64_t] senders,
+      array_view[double] times, double* state, unsigned int omp) except +
+
+    cdef void _bin_spikes(
+      array_view[double] times, double start, double bin_size,
+      size_t num_bins, int64_t* counts, unsigned int omp) except +
+
+    cdef void _bayesian_blocks_events(
+      array_view[double] block_length, array_view[double] cum_counts,
+      array_view[double] prior, int64_t* last, unsigned int omp) except +
+
+
+cdef extern from "func_io.h" namespace "generation":
+    cdef size_t _parse_edges(
+      const char* buffer, size_t size, bool neighbour, char separator,
+      char secondary, const string& notifier, const string& ignore,
+      size_t num_attributes, vector[int64_t]& edges,
+      vector[double]& attributes, unsigned int omp) except +
+
+    cdef void _format_edges(
+      array_view[int64_t] edges, array_view[double] attributes,
+      array_view[uint8_t] integer, const string& separator,
+      const string& secondary, size_t first, size_t last, string& out,
+      unsigned int omp) except +
@@ -6,11 +6,17 @@
 
 """ Cython interface to C++ parallel generation tools for NNGT """
 
+import mmap
+import os
 import warnings
 
+from cpython.buffer cimport PyObject_GetBuffer, PyBuffer_Release, PyBUF_SIMPLE
+
 from .cconnect cimport *
 cimport numpy as cnp
 
+cnp.import_array()
+
 import numpy as np
 import scipy.sparse as ssp
 from numpy.random import randint, get_state
@@ -18,20 +24,28 @@ from numpy.random import randint, get_state
 import nngt
 from nngt.lib import InvalidArgument
 from nngt.lib.connect_tools import (_check_num_edges, _compute_connections,
-                                    _set_degree_type, max_proba_dist_rule)
+                                    _set_degree_type)
+from nngt.generation.connect_algorithms import _erdos_renyi as _py_erdos_renyi
 
 
 __all__ = [
     "_all_to_all",
+    "_circular",
     "_distance_rule",
+    "_edge_swaps",
+    "_erdos_renyi",
     "_fixed_degree",
     "_from_degree_list",
     "_gaussian_degree",
+    "_newman_watts",
+    "_price_scale_free",
+    "_watts_strogatz",
 ]
 
 
 cdef unsigned int MAXTESTS = 1000 # ensure that generation will finish
 cdef float EPS = 0.00001
+cdef size_t BATCH_SIZE = 1048576  # default number of edges per streamed batch
 
 # We now need to fix a datatype for our arrays. I've used the variable
 # DTYPE for this, which is assigned to the usual NumPy runtime
@@ -46,6 +60,121 @@ ctypedef cnp.int64_t int64
 # Simple tools #
 # ------------ #
 
+cdef inline size_t* _first(cnp.ndarray arr):
+    ''' Pointer to the first element of a (possibly empty) array '''
+    return <size_t*> cnp.PyArray_DATA(arr)
+
+
+cdef inline array_view[size_t] _size_view(cnp.ndarray arr):
+    '''
+    View on a contiguous np.uint array, passed to C++ without copy (the
+    array must outlive the view).
+    '''
+    return array_view[size_t](<size_t*> cnp.PyArray_DATA(arr),
+                              cnp.PyArray_SIZE(arr))
+
+
+cdef inline array_view[unsigned int] _uintc_view(cnp.ndarray arr):
+    ''' View on a contiguous np.uintc array (see _size_view) '''
+    return array_view[unsigned int](<unsigned int*> cnp.PyArray_DATA(arr),
+                                    cnp.PyArray_SIZE(arr))
+
+
+cdef inline array_view[float] _float_view(cnp.ndarray arr):
+    ''' View on a contiguous np.float32 array (see _size_view) '''
+    return array_view[float](<float*> cnp.PyArray_DATA(arr),
+                             cnp.PyArray_SIZE(arr))
+
+
+cdef inline array_view[double] _double_view(cnp.ndarray arr):
+    ''' View on a contiguous np.float64 array (see _size_view) '''
+    return array_view[double](<double*> cnp.PyArray_DATA(arr),
+                              cnp.PyArray_SIZE(arr))
+
+
+cdef inline array_view[int64_t] _edge_view(cnp.ndarray arr):
+    '''
+    View on a contiguous (E, 2) int64 array of edges, linearized (see
+    _size_view); None gives an empty view.
+    '''
+    if arr is None:
+        return array_view[int64_t]()
+
+    return array_view[int64_t](<int64_t*> cnp.PyArray_DATA(arr),
+                               cnp.PyArray_SIZE(arr))
+
+
+cdef class _EdgeBuffer:
+    '''
+    Owner of the edges and distances (or attribute values) returned by a C++
+    function in a vector, so that they can be exposed as NumPy arrays without
+    copy.
+    '''
+
+    cdef vector[int64_t] edges
+    cdef vector[float] dist
+    cdef vector[double] values
+
+
+cdef object _wrap_edges(_EdgeBuffer buf, size_t num_edges):
+    ''' (num_edges, 2) NumPy array sharing the memory of `buf.edges` '''
+    if num_edges == 0:
+        return np.zeros((0, 2), dtype=DTYPE)
+
+    cdef:
+        cnp.npy_intp shape[2]
+        cnp.ndarray arr
+
+    shape[0] = num_edges
+    shape[1] = 2
+
+    arr = cnp.PyArray_SimpleNewFromData(2, shape, cnp.NPY_INT64,
+                                        buf.edges.data())
+
+    cnp.set_array_base(arr, buf)
+
+    return arr
+
+
+cdef object _wrap_dist(_EdgeBuffer buf):
+    ''' NumPy array sharing the memory of `buf.dist` '''
+    if buf.dist.empty():
+        return np.zeros(0, dtype=np.float32)
+
+    cdef:
+        cnp.npy_intp shape[1]
+        cnp.ndarray arr
+
+    shape[0] = buf.dist.size()
+
+    arr = cnp.PyArray_SimpleNewFromData(1, shape, cnp.NPY_FLOAT32,
+                                        buf.dist.data())
+
+    cnp.set_array_base(arr, buf)
+
+    return arr
+
+
+cdef object _wrap_values(_EdgeBuffer buf, size_t num_columns):
+    ''' (num_edges, num_columns) NumPy array sharing `buf.values` memory '''
+    if buf.values.empty() or num_columns == 0:
+        return np.zeros((buf.edges.size() // 2, num_columns))
+
+    cdef:
+        cnp.npy_intp shape[2]
+        cnp.ndarray arr
+
+    shape[0] = buf.values.size() // num_columns
+    shape[1] = num_columns
+
+    arr = cnp.PyArray_SimpleNewFromData(2, shape, cnp.NPY_FLOAT64,
+                                        buf.values.data())
+
+    cnp.set_array_base(arr, buf)
+
+    return arr
+
+
 cdef bytes _to_bytes(string):
     ''' Convert string to bytes '''
     if not isinstance(string, bytes):
@@ -54,6 +183,68 @@ cdef bytes _to_bytes(string):
     return string
 
 
+# -------------- #
+# Edge streaming #
+# -------------- #
+
+cdef class _EdgeCallback:
+    '''
+    Python callable receiving the edges by batches, called as
+    ``func(edges, distances)`` with `edges` an (N, 2) array and `distances`
+    an array of size N (or None).
+    Stores the exception that the callable might raise so that it can be
+    re-raised once the C++ generator returned.
+    '''
+
+    cdef object func
+    cdef object error
+
+    def __cinit__(self, func):
+        self.func  = func
+        self.error = None
+
+    def reraise(self):
+        if self.error is not None:
+            raise self.error
+
+
+cdef bool _edge_sink(void* data, const int64_t* edges, const float* dist,
+                     size_t num_edges) noexcept with gil:
+    ''' Forward a batch of edges from the C++ generators to Python '''
+    cdef _EdgeCallback callback = <_EdgeCallback> data
+
+    try:
+        # the buffers are reused by the generator, so they are copied
+        batch = np.array(<int64_t[:num_edges, :2]> <int64_t*> edges)
+
+        distances = None
+
+        if dist != NULL:
+            distances = np.array(<float[:num_edges]> <float*> dist)
+
+        callback.func(batch, distances)
+    except BaseException as e:
+        callback.error = e
+        return False
+
+    return True
+
+
+def _emit(edge_callback, ia_edges, distance=None, batch_size=BATCH_SIZE):
+    '''
+    Pass edges which were generated at once to `edge_callback` by batches.
+    '''
+    ia_edges = np.asarray(ia_edges)
+
+    if distance is not None:
+        distance = np.asarray(distance, dtype=np.float32)
+
+    for i in range(0, len(ia_edges), batch_size):
+        edge_callback(
+            ia_edges[i:i + batch_size],
+            None if distance is None else distance[i:i + batch_size])
+
+
 def _no_self_loops(cnp.ndarray[int64_t, ndim=2] array):
     '''
     Remove self-loops
@@ -124,6 +315,33 @@ def _filter(cnp.ndarray[int64, ndim=2] ia_edges,
     return ia_edges, num_ecurrent
 
 
+def _check_new_edges(edges, existing_edges, bool directed=True,
+                     bool loops=True, bool existing=True):
+    '''
+    Status of edges that are about to be added to a graph (C++ function):
+    0 for valid edges, 1 for edges that exist in `existing_edges` (if
+    `existing` is True) or appeared earlier in `edges`, 2 for self-loops (if
+    `loops` is True).
+
+    Returns the status of each edge and the number of valid edges.
+    '''
+    cdef:
+        cnp.ndarray cedges = np.ascontiguousarray(edges, dtype=DTYPE)
+        cnp.ndarray old = None
+        cnp.ndarray[uint8, ndim=1] status = np.zeros(len(cedges),
+                                                     dtype=np.uint8)
+        size_t num_valid = 0
+
+    if existing and existing_edges is not None and len(existing_edges):
+        old = np.ascontiguousarray(existing_edges, dtype=DTYPE)
+
+    if len(cedges):
+        num_valid = _edge_status(_edge_view(cedges), _edge_view(old),
+                                 directed, loops, existing, &status[0])
+
+    return status, num_valid
+
+
 # ---------------------- #
 # Graph model generation #
 # ---------------------- #
@@ -193,12 +411,23 @@ def _all_to_all(cnp.ndarray[size_t, ndim=1] source_ids,
 def _total_degree_list(cnp.ndarray[int64, ndim=1] source_ids,
                        cnp.ndarray[int64, ndim=1] target_ids,
                        cnp.ndarray[int64, ndim=1] degree_list,
-                       bool directed=True, bool multigraph=False, **kwargs):
-    ''' Called from _from_degree_list '''
+                       bool directed=True, bool multigraph=False,
+                       max_rounds=MAXTESTS, **kwargs):
+    '''
+    Called from _from_degree_list
+
+    Generation of the graph through the C++ configuration model: the
+    Erdos-Gallai check is O(N) and the stubs are matched at random, at most
+    for `max_rounds` rounds (no limit if None).
+    '''
     cdef:
-        size_t num_source = len(source_ids)
         size_t num_target = len(target_ids)
         size_t edges = 0.5*np.sum(degree_list)
+        unsigned int omp = nngt._config["omp"]
+        vector[long] seeds = _random_init(omp)
+        cnp.ndarray nodes, degrees
+        cnp.ndarray[int64, ndim=2] ia_edges
+        bool b_one_pop
 
     # check if the sequence is not obviously impossible
     if not multigraph:
@@ -208,161 +437,41 @@ def _total_degree_list(cnp.ndarray[int64, ndim=1] source_ids,
     if np.sum(degree_list) % 2 != 0:
         raise ValueError("The sum of the degrees must ben even.")
 
-    # check one pop
-    cdef:
-        bool b_one_pop
-        set source_set, target_set
-
-    b_one_pop, source_set, target_set = _check_num_edges(
-        source_ids, target_ids, edges, directed, multigraph, return_sets=True)
-
-    cdef:
-        size_t i, k, num_tests, num_choice, new_etot
-        size_t ecurrent = 0
-        set edges_hash = set()
-        set recip_hash = set()
-        set ids
-        int64[:] sorted_degrees = np.sort(degree_list)[::-1]
-        int64[:] data
-        cnp.ndarray[int64, ndim=1] incr, decr
-        cnp.ndarray[int64, ndim=1] deg_tmp, unfinished, even_deg, add_node
-        cnp.ndarray[int64, ndim=2] chosen, new_edges
-        cnp.ndarray[int64, ndim=2] ia_edges = np.full((edges, 2), -1,
-                                                      dtype=np.int64)
-
-    rng = nngt._rng
-
-    if b_one_pop:
-        # check that the degree sequence is graphic (i.e. can be realized)
-        for k in range(1, num_source + 1):
-            partial_sum = np.sum(sorted_degrees[:k])
-            capped_deg  = np.minimum(sorted_degrees[k:], k)
-
-            if not partial_sum <= k*(k-1) + np.sum(capped_deg):
-                raise ValueError("The degree sequence provided is not "
-                                 "graphical and cannot be realized.")
-
-        num_tests = 0
-
-        while ecurrent < edges and num_tests < MAXTESTS:
-            # initial procedure
-            remaining = max(int(0.5*(edges - ecurrent)), 1)
-
-            data = np.repeat(source_ids, degree_list)
-            sources = rng.choice(data, remaining, replace=False)
-
-            deg_tmp = degree_list.copy()
-            np.add.at(deg_tmp, sources, -1)
-
-            data = np.repeat(source_ids, deg_tmp)
-            targets = rng.choice(data, remaining, replace=False)
-
-            new_edges = np.array((sources, targets), dtype=DTYPE).T
-
-            ia_edges, new_etot =  _filter(
-                ia_edges, new_edges, ecurrent, edges_hash, b_one_pop,
-                multigraph, directed=directed, recip_hash=recip_hash)
-
-            np.add.at(degree_list, np.ravel(ia_edges[ecurrent:new_etot]), -1)
-
-            ecurrent = new_etot
-
-            # trying to correct things if initial procedure did not converge
-            if num_tests >= 0.5*MAXTESTS:
-                nnz_degree = degree_list != 0
-                unfinished = np.where(nnz_degree)[0]
-                num_choice = max(int(0.5*len(unfinished)), 1)
-
-                # pick random edges
-                ids    = set(rng.choice(ecurrent, num_choice, replace=False))
-                chosen = np.array([ia_edges[i] for i in ids], dtype=np.int64)
-
-                # if unfinished is odd then we need to readd a node that has
-                # a remaining degree of 2
-                if len(unfinished) % 2 == 1:
-                    even_deg = np.where((degree_list % 2 == 0)*nnz_degree)[0]
-                    add_node = rng.choice(even_deg, 1)
-                    unfinished = np.array(
-                        list(unfinished) + list(add_node), dtype=np.int64)
-
-                # try to pair them differently
-                rng.shuffle(unfinished)
-
-                new_edges = np.array(
-                    [(u, v) for u, v in zip(unfinished, chosen.ravel())],
-                    dtype=np.int64)
-
-                # randomize direction if directed
-                if directed:
-                    num_reverse = rng.binomial(2*num_choice, 0.5)
-                    reverse     = rng.choice(2*num_choice, num_reverse,
-                                             replace=False)
-
-                    new_edges[reverse, 0], new_edges[reverse, 1] = \
-                        new_edges[reverse, 1], new_edges[reverse, 0]
-
-                # check that new_edges are indeed new
-                skip = False
-
-                for e in new_edges:
-                    if e[0] == e[1]:
-                        skip = True
-                        break
-
-                    tpl_e = tuple(e)
-
-                    if tpl_e in edges_hash:
-                        skip = True
-                        break
-
-                    if not directed and tpl_e in recip_hash:
-                        skip = True
-                        break
-
-                if skip:
-                    num_tests += 1
-                    continue
-
-                # remove old ones from edges_hash
-                edges_hash -= {tuple(e) for e in chosen}
-
-                if not directed:
-                    recip_hash -= {tuple(e) for e in chosen[:, ::-1]}
-
-                # remove chosen edges from existing edges
-                ia_edges[:ecurrent - num_choice] = np.array(
-                    [e for i, e in enumerate(ia_edges[:ecurrent])
-                     if i not in ids])
-
-                ecurrent -= num_choice
-
-                ia_edges, new_etot =  _filter(
-                    ia_edges, new_edges, ecurrent, edges_hash, b_one_pop,
-                    multigraph, directed=directed, recip_hash=recip_hash)
-
-                decr  = new_edges.ravel()
-                incr  = chosen.ravel()
-
-                np.add.at(degree_list, incr, 1)
-                np.add.at(degree_list, decr, -1)
-
-                ecurrent += len(new_edges)
+    b_one_pop = _check_num_edges(
+        source_ids, target_ids, edges, directed, multigraph)
 
-            num_tests += 1
+    if not b_one_pop:
+        raise NotImplementedError("not available if sources != targets.")
 
-        if num_tests == MAXTESTS:
-            raise RuntimeError("Graph generation did not converge.")
+    nodes    = np.ascontiguousarray(source_ids, dtype=np.uint)
+    degrees  = np.ascontiguousarray(degree_list, dtype=np.uint)
+    ia_edges = np.empty((edges, 2), dtype=DTYPE)
 
-        return ia_edges
+    if edges:
+        _gen_degree_sequence(
+            &ia_edges[0, 0], _size_view(nodes), _size_view(degrees),
+            directed, multigraph,
+            0 if max_rounds is None else max_rounds, seeds[0], omp)
 
-    raise NotImplementedError("not available if sources != targets.")
+    return ia_edges
 
 
 def _from_degree_list(cnp.ndarray[size_t, ndim=1] source_ids,
                       cnp.ndarray[size_t, ndim=1] target_ids, degrees,
                       degree_type="in", bool directed=True,
-                      bool multigraph=False, existing_edges=None, **kwargs):
-    ''' Generation of the degree list through the C++ function '''
+                      bool multigraph=False, existing_edges=None,
+                      edge_callback=None, size_t batch_size=BATCH_SIZE,
+                      max_rounds=MAXTESTS, seed=None, **kwargs):
+    '''
+    Generation of the degree list through the C++ function.
+
+    If `edge_callback` is provided, the edges are passed to it by batches of
+    at most `batch_size` edges as they are generated and None is returned.
+
+    For in/out-degrees, each node draws its edges from its own stream of
+    `seed` (by default, the first local seed), so processes sharing the same
+    `seed` generate the same edges for the same nodes.
+    '''
 
     assert len(degrees) == len(source_ids), \
         "One degree per source neuron must be provided."
@@ -378,16 +487,20 @@ def _from_degree_list(cnp.ndarray[size_t, ndim=1] source_ids,
         size_t edges = np.sum(degrees)
         bool b_one_pop = _check_num_edges(
             source_ids, target_ids, edges, directed, multigraph)
-        int64_t[:, :] ia_edges = np.full((edges, 2), -1, dtype=DTYPE)
+        int64_t[:, :] ia_edges
+        int64_t* edge_ptr = NULL
+        edge_sink sink = NULL
+        _EdgeCallback callback = None
 
-        vector[size_t] sources = source_ids
-        vector[size_t] targets = target_ids
+        # inputs are passed to C++ as views on the NumPy buffers
+        cnp.ndarray sources = np.ascontiguousarray(source_ids, dtype=np.uint)
+        cnp.ndarray targets = np.ascontiguousarray(target_ids, dtype=np.uint)
 
         unsigned int idx = 0 if b_out else 1  # differenciate source / target
         unsigned int omp = nngt._config["omp"]
         cnp.ndarray[int64, ndim=1] degree_list, source64, target64
-        vector[unsigned int] cdegrees = degrees
-        vector[ vector[size_t] ] old_edges = vector[ vector[size_t] ]()
+        cnp.ndarray cdegrees = np.ascontiguousarray(degrees, dtype=np.uintc)
+        cnp.ndarray old_edges = None
         vector[long] seeds = _random_init(omp)
 
     # total-degree or undirected case
@@ -396,24 +509,126 @@ def _from_degree_list(cnp.ndarray[size_t, ndim=1] source_ids,
         source64 = np.array(source_ids, dtype=np.int64)
         target64 = np.array(target_ids, dtype=np.int64)
 
-        return _total_degree_list(source64, target64, degree_list,
-                                  directed=directed, multigraph=multigraph)
+        ia_edges = _total_degree_list(
+            source64, target64, degree_list, directed=directed,
+            multigraph=multigraph, max_rounds=max_rounds)
+
+        if edge_callback is not None:
+            _emit(edge_callback, ia_edges, batch_size=batch_size)
+            return None
+
+        return ia_edges
 
     if existing_edges is not None:
-        old_edges.push_back(list(existing_edges[:, 0]))
-        old_edges.push_back(list(existing_edges[:, 1]))
+        old_edges = np.ascontiguousarray(existing_edges, dtype=DTYPE)
+
+    if edge_callback is None:
+        ia_edges = np.full((edges, 2), -1, dtype=DTYPE)
+
+        if edges:
+            edge_ptr = &ia_edges[0, 0]
+    else:
+        callback = _EdgeCallback(edge_callback)
+        sink     = _edge_sink
+
+    if seed is not None:
+        seeds[0] = seed
 
     # directed case for in/out-degrees
-    _gen_edges(&ia_edges[0,0], source_ids, cdegrees, target_ids, old_edges,
-               idx, multigraph, use_directed, seeds)
+    _gen_edges(edge_ptr, _size_view(sources), _uintc_view(cdegrees),
+               _size_view(targets), _edge_view(old_edges), idx, multigraph,
+               use_directed, seeds[0], omp, sink, <void*> callback,
+               batch_size)
 
-    return ia_edges
+    if edge_callback is not None:
+        callback.reraise()
+        return None
+
+    return np.asarray(ia_edges)
+
+
+def _batch_degree_edges(list first_nodes, list second_nodes, list degrees,
+                        list degree_types, bool multigraph=False,
+                        existing_edges=None):
+    '''
+    Directed edges of several degree-based jobs, generated in a single
+    parallel call of the C++ function.
+
+    Job `j` gives the `degree_types[j]` ("in" or "out") degrees
+    `degrees[j]` of `first_nodes[j]`, which are connected to
+    `second_nodes[j]` (see :func:`_from_degree_list`).
+
+    Returns
+    -------
+    ia_edges : array of shape (E, 2)
+        The edges, the ones of job `j` being
+        ``ia_edges[offsets[j]:offsets[j+1]]``.
+    offsets : array of size ``len(first_nodes) + 1``
+        Offsets of the edges of each job.
+    '''
+    cdef size_t j, num_jobs = len(first_nodes)
+
+    assert len(second_nodes) == num_jobs and len(degrees) == num_jobs \
+        and len(degree_types) == num_jobs, "Inconsistent job descriptions."
+
+    degree_types = [_set_degree_type(d) for d in degree_types]
+
+    assert "total" not in degree_types, \
+        "Only 'in' and 'out' degrees can be generated in batches."
+
+    offsets = np.zeros(num_jobs + 1, dtype=np.int64)
+
+    for j in range(num_jobs):
+        assert len(degrees[j]) == len(first_nodes[j]), \
+            "One degree per source neuron must be provided."
+
+        offsets[j + 1] = offsets[j] + np.sum(degrees[j], dtype=np.int64)
+
+        _check_num_edges(first_nodes[j], second_nodes[j],
+                         offsets[j + 1] - offsets[j], True, multigraph)
+
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        vector[long] seeds = _random_init(omp)
+        # all jobs are concatenated, with the offsets of each job
+        cnp.ndarray cfirst = np.ascontiguousarray(
+            np.concatenate(first_nodes) if num_jobs else [], dtype=np.uint)
+        cnp.ndarray csecond = np.ascontiguousarray(
+            np.concatenate(second_nodes) if num_jobs else [], dtype=np.uint)
+        cnp.ndarray cdegrees = np.ascontiguousarray(
+            np.concatenate(degrees) if num_jobs else [], dtype=np.uintc)
+        cnp.ndarray job_nodes = np.concatenate(
+            ([0], np.cumsum([len(f) for f in first_nodes]))).astype(np.uint)
+        cnp.ndarray job_targets = np.concatenate(
+            ([0], np.cumsum([len(t) for t in second_nodes]))).astype(np.uint)
+        cnp.ndarray cidx = np.array(
+            [0 if d == "out" else 1 for d in degree_types], dtype=np.uint8)
+        cnp.ndarray old_edges = None
+        int64_t[:, :] ia_edges = np.full((offsets[-1], 2), -1, dtype=DTYPE)
+        int64_t* edge_ptr = NULL
+
+    if existing_edges is not None:
+        old_edges = np.ascontiguousarray(existing_edges, dtype=DTYPE)
+
+    if offsets[-1]:
+        edge_ptr = &ia_edges[0, 0]
+
+        _gen_edges_batch(
+            edge_ptr, _size_view(job_nodes), _size_view(cfirst),
+            _uintc_view(cdegrees), _size_view(job_targets),
+            _size_view(csecond),
+            array_view[uint8_t](<uint8_t*> cnp.PyArray_DATA(cidx), num_jobs),
+            _edge_view(old_edges), multigraph, True, seeds[0], omp)
+
+    return np.asarray(ia_edges), offsets
 
 
 def _fixed_degree(cnp.ndarray[size_t, ndim=1] source_ids,
                   cnp.ndarray[size_t, ndim=1] target_ids, degree=-1,
                   degree_type="in", float reciprocity=-1, bool directed=True,
-                  bool multigraph=False, existing_edges=None, **kwargs):
+                  bool multigraph=False, existing_edges=None,
+                  edge_callback=None, size_t batch_size=BATCH_SIZE,
+                  **kwargs):
     ''' Generation of the edges through the C++ function '''
     degree = int(degree)
 
@@ -424,14 +639,17 @@ def _fixed_degree(cnp.ndarray[size_t, ndim=1] source_ids,
     return _from_degree_list(source_ids, target_ids, degrees,
                              degree_type=degree_type, directed=directed,
                              multigraph=multigraph,
-                             existing_edges=existing_edges)
+                             existing_edges=existing_edges,
+                             edge_callback=edge_callback,
+                             batch_size=batch_size)
 
 
 def _gaussian_degree(cnp.ndarray[size_t, ndim=1] source_ids,
                      cnp.ndarray[size_t, ndim=1] target_ids, float avg=-1,
                      float std=-1, degree_type="in", float reciprocity=-1,
                      bool directed=True, bool multigraph=False,
-                     existing_edges=None, **kwargs):
+                     existing_edges=None, edge_callback=None,
+                     size_t batch_size=BATCH_SIZE, **kwargs):
     '''
     Connect nodes with a Gaussian distribution (generation through C++
     function.
@@ -469,7 +687,268 @@ def _gaussian_degree(cnp.ndarray[size_t, ndim=1] source_ids,
 
     return _from_degree_list(source_ids, target_ids, degrees,
         degree_type=degree_type, directed=directed, multigraph=multigraph,
-        existing_edges=existing_edges)
+        existing_edges=existing_edges, edge_callback=edge_callback,
+        batch_size=batch_size)
+
+
+def _erdos_renyi(source_ids, target_ids, density=None, edges=None,
+                 avg_deg=None, reciprocity=-1, directed=True, multigraph=False,
+                 exact_edge_nb=True, **kwargs):
+    '''
+    Returns a numpy array of dimension (edges, 2) that describes the edge list
+    of an Erdos-Renyi graph (generation through C++ function).
+
+    If `exact_edge_nb` is False and `density` is given, each possible edge
+    exists independently with probability `density` (G(n, p) model);
+    otherwise the number of edges is fixed (G(n, m) model).
+    For a population of N nodes, G(n, m) creates `density`*N^2 edges, while
+    G(n, p) draws among N(N - 1) possible edges if it is directed and
+    N(N - 1)/2 if it is undirected.
+    '''
+    if directed and reciprocity > 0:
+        # reciprocal edges are only handled by the python algorithm
+        return _py_erdos_renyi(
+            source_ids, target_ids, density=density, edges=edges,
+            avg_deg=avg_deg, reciprocity=reciprocity, directed=directed,
+            multigraph=multigraph, exact_edge_nb=exact_edge_nb)
+
+    source_ids = np.ascontiguousarray(source_ids, dtype=np.uint)
+    target_ids = np.ascontiguousarray(target_ids, dtype=np.uint)
+
+    cdef:
+        size_t num_source = source_ids.shape[0]
+        size_t num_target = target_ids.shape[0]
+        unsigned int omp = nngt._config["omp"]
+        vector[long] seeds = _random_init(omp)
+        cnp.ndarray sources = source_ids
+        cnp.ndarray targets
+        _EdgeBuffer buf
+        cnp.ndarray[int64, ndim=2] ia_edges
+        size_t num_edges
+        bool b_one_pop
+
+    if not exact_edge_nb and density is not None:
+        b_one_pop = _check_num_edges(
+            source_ids, target_ids, 0, directed, multigraph)
+
+        # same order as the sources to exclude self-loops
+        targets = source_ids if b_one_pop else target_ids
+
+        buf = _EdgeBuffer()
+
+        num_edges = _gen_gnp(buf.edges, _size_view(sources),
+                             _size_view(targets), density, b_one_pop,
+                             directed, seeds[0], omp)
+
+        return _wrap_edges(buf, num_edges)
+
+    num_edges, _ = _compute_connections(
+        num_source, num_target, density, edges, avg_deg, directed)
+
+    b_one_pop = _check_num_edges(
+        source_ids, target_ids, num_edges, directed, multigraph)
+
+    targets = source_ids if b_one_pop else target_ids
+
+    ia_edges = np.empty((num_edges, 2), dtype=DTYPE)
+
+    if num_edges:
+        _gen_gnm(&ia_edges[0, 0], _size_view(sources), _size_view(targets),
+                 num_edges, b_one_pop, directed, multigraph, seeds[0], omp)
+
+    return ia_edges
+
+
+def _price_scale_free(ids, m, c, gamma, reciprocity, directed, multigraph,
+                      **kwargs):
+    '''
+    Generate a Price network (generation through C++ function).
+
+    Each new node creates `m` edges towards different existing nodes, hence
+    `multigraph` does not change the result, as for the python algorithm.
+    '''
+    assert isinstance(m, int) and m >= 0, "`m` must be a positive integer."
+
+    if directed:
+        assert c > 0, "`c` > 0 is required for directed graphs."
+    else:
+        assert c > -1, "`c` > -1 is required for undirected graphs."
+
+    assert 0 <= reciprocity <= 1, "`reciprocity` must be in [0, 1]."
+
+    cdef:
+        cnp.ndarray nodes = np.ascontiguousarray(ids, dtype=np.uint)
+        vector[long] seeds = _random_init(nngt._config["omp"])
+        _EdgeBuffer buf = _EdgeBuffer()
+        size_t num_edges
+
+    num_edges = _gen_price(buf.edges, _size_view(nodes), m, c, gamma,
+                           reciprocity, directed, seeds[0])
+
+    return _wrap_edges(buf, num_edges)
+
+
+def _circular(source_ids, target_ids, coord_nb, reciprocity=1, directed=True,
+              reciprocity_choice="random", **kwargs):
+    '''
+    Circular graph (generation through C++ function).
+
+    Note
+    ----
+    `source_ids` and `target_ids` are only there for compatibility with the
+    connect functions, this algorithm requires a single population.
+    This check (if necessary) is performed above.
+    '''
+    if reciprocity_choice not in ("random", "closest", "closest-ordered"):
+        # note: only "random" and "closest" are publicly advertised,
+        # "closest-ordered" is only for internal use in lattice_rewire.
+        raise ValueError("Valid entries for `reciprocity_choice` are "
+                         "'random' and 'closest'.")
+
+    if coord_nb % 2:
+        raise ValueError("`coord_nb` must be even.")
+
+    cdef:
+        cnp.ndarray nodes = np.ascontiguousarray(source_ids, dtype=np.uint)
+        unsigned int omp = nngt._config["omp"]
+        vector[long] seeds = _random_init(omp)
+        size_t num_edges = _circular_edge_nb(
+            nodes.shape[0], coord_nb, reciprocity, directed)
+        cnp.ndarray[int64, ndim=2] ia_edges = np.empty((num_edges, 2),
+                                                       dtype=DTYPE)
+
+    if num_edges:
+        _gen_circular(&ia_edges[0, 0], _size_view(nodes), coord_nb,
+                      reciprocity, reciprocity_choice != "random", directed,
+                      seeds[0], omp)
+
+    return ia_edges
+
+
+def _newman_watts(source_ids, target_ids, coord_nb, proba_shortcut,
+                  reciprocity_circular=1, reciprocity_choice_circular="random",
+                  edges=None, directed=True, multigraph=False, **kwargs):
+    '''
+    Returns a numpy array of dimension (num_edges,2) that describes the edge
+    list of a Newman-Watts graph (generation through C++ function).
+
+    Note
+    ----
+    `source_ids` and `target_ids` are only there for compatibility with the
+    connect functions, this algorithm requires a single population.
+    This check (if necessary) is performed above.
+    '''
+    if coord_nb % 2:
+        raise ValueError("`coord_nb` must be even.")
+
+    cdef:
+        cnp.ndarray nodes = np.ascontiguousarray(source_ids, dtype=np.uint)
+        unsigned int omp = nngt._config["omp"]
+        size_t circular_edges = _circular_edge_nb(
+            nodes.shape[0], coord_nb, reciprocity_circular, directed)
+        cnp.ndarray[int64, ndim=2] ia_edges
+        vector[long] seeds
+
+    if edges is None:
+        rng   = nngt._rng
+        edges = circular_edges + rng.binomial(circular_edges, proba_shortcut)
+    elif edges < circular_edges:
+        raise ValueError("`edges` must be greater or equal to "
+                         "{} given current arguments.".format(circular_edges))
+
+    b_one_pop = _check_num_edges(
+        source_ids, target_ids, edges, directed, multigraph)
+
+    if not b_one_pop:
+        raise InvalidArgument("This graph model can only be used if source "
+                              "and target populations are the same.")
+
+    seeds    = _random_init(omp)
+    ia_edges = np.empty((edges, 2), dtype=DTYPE)
+
+    if edges:
+        _gen_newman_watts(
+            &ia_edges[0, 0], _size_view(nodes), coord_nb,
+            reciprocity_circular, reciprocity_choice_circular != "random",
+            edges, directed, multigraph, seeds[0], omp)
+
+    return ia_edges
+
+
+def _watts_strogatz(
+        source_ids, target_ids, coord_nb, proba_shortcut,
+        reciprocity_circular=1, reciprocity_choice_circular="random",
+        shuffle="random", directed=True, multigraph=False, **kwargs):
+    '''
+    Returns a numpy array of dimension (num_edges,2) that describes the edge
+    list of a Watts-Strogatz graph (generation through C++ function).
+
+    Note
+    ----
+    `source_ids` and `target_ids` are only there for compatibility with the
+    connect functions, this algorithm requires a single population.
+    This check (if necessary) is performed above.
+    '''
+    assert shuffle in ('sources', 'targets', 'random'), \
+        "Shuffle must be either 'sources', 'targets', or 'random'."
+
+    if coord_nb % 2:
+        raise ValueError("`coord_nb` must be even.")
+
+    cdef:
+        cnp.ndarray nodes = np.ascontiguousarray(source_ids, dtype=np.uint)
+        unsigned int omp = nngt._config["omp"]
+        size_t num_edges = _circular_edge_nb(
+            nodes.shape[0], coord_nb, reciprocity_circular, directed)
+        int end = {"targets": 0, "sources": 1, "random": -1}[shuffle]
+        cnp.ndarray[int64, ndim=2] ia_edges
+        vector[long] seeds
+
+    b_one_pop = _check_num_edges(
+        source_ids, target_ids, num_edges, directed, multigraph)
+
+    if not b_one_pop:
+        raise InvalidArgument("This graph model can only be used if source "
+                              "and target populations are the same.")
+
+    seeds    = _random_init(omp)
+    ia_edges = np.empty((num_edges, 2), dtype=DTYPE)
+
+    if num_edges:
+        _gen_watts_strogatz(
+            &ia_edges[0, 0], _size_view(nodes), coord_nb, proba_shortcut,
+            reciprocity_circular, reciprocity_choice_circular != "random",
+            end, directed, seeds[0], omp)
+
+    return ia_edges
+
+
+def _edge_swaps(ia_edges, num_nodes, size_t num_swaps, bool directed=True,
+                groups=None, **kwargs):
+    '''
+    Degree-preserving randomization through double edge swaps (C++ function).
+
+    Returns the rewired edges and the number of accepted swaps.
+    '''
+    cdef:
+        cnp.ndarray[int64, ndim=2] edges = np.array(ia_edges, dtype=DTYPE)
+        cnp.ndarray[int64, ndim=1] cgroups
+        const int64_t* group_ptr = NULL
+        size_t num_edges = edges.shape[0]
+        unsigned int omp = nngt._config["omp"]
+        vector[long] seeds = _random_init(omp)
+        size_t accepted = 0
+
+    if groups is not None:
+        cgroups   = np.ascontiguousarray(groups, dtype=DTYPE)
+        group_ptr = &cgroups[0]
+
+    if num_edges:
+        accepted = _gen_edge_swaps(&edges[0, 0], num_edges, num_nodes,
+                                   num_swaps, directed, group_ptr, seeds[0],
+                                   omp)
+
+    return edges, accepted
 
 
 def _distance_rule(cnp.ndarray[size_t, ndim=1] source_ids,
@@ -478,12 +957,28 @@ def _distance_rule(cnp.ndarray[size_t, ndim=1] source_ids,
                    float max_proba=-1., shape=None,
                    cnp.ndarray[float, ndim=2] positions=np.array([[0], [0]]),
                    bool directed=True, bool multigraph=False,
-                   num_neurons=None, distance=None, **kwargs):
+                   num_neurons=None, distance=None, edge_callback=None,
+                   size_t batch_size=BATCH_SIZE, exclude_self=None, **kwargs):
     '''
-    Returns a distance-rule graph
+    Returns a distance-rule graph.
+
+    `positions` is an array of shape (ndim, N) giving the N-dimensional
+    positions of the nodes; distances use all dimensions, while the
+    neighbour search is done on the first two.
+    `rule` is either one of the built-in rules ("lin", "exp", "gaussian") or
+    a rule registered from C++ or Cython via ``_register_distance_rule``,
+    together with the cutoff (in units of `scale`, 10 by default) beyond
+    which its probability is considered null.
+
+    If `edge_callback` is provided, the edges and their distances are passed
+    to it by batches of at most `batch_size` edges and None is returned.
+    Otherwise, the distances of the new edges are appended to `distance` if
+    it is not None.
+
+    Self-loops are excluded if `exclude_self` is True, or, by default, if the
+    sources and targets are the same nodes (`exclude_self` is used when only
+    part of the graph is generated, e.g. under MPI).
     '''
-    distance = [] if distance is None else distance
-
     if num_neurons is None:
         num_neurons = len(set(np.concatenate((source_ids, target_ids))))
 
@@ -494,66 +989,434 @@ def _distance_rule(cnp.ndarray[size_t, ndim=1] source_ids,
         size_t s, i, edge_num
         string crule = _to_bytes(rule)
         unsigned int omp = nngt._config["omp"]
-        vector[ vector[size_t] ] old_edges = vector[ vector[size_t] ]()
-        vector[ vector[size_t] ] local_targets
-        cnp.ndarray[long, ndim=1] loc_tgts
-        list sources = []
-        list targets = []
-        vector[float] x = positions[0]
-        vector[float] y = positions[1]
+        cnp.ndarray[size_t, ndim=1] tgt_offsets, tgt_indices
+        # inputs are passed to C++ as views on the NumPy buffers
+        cnp.ndarray sources = np.ascontiguousarray(source_ids, dtype=np.uint)
+        cnp.ndarray targets = np.ascontiguousarray(target_ids, dtype=np.uint)
+        # positions as a contiguous (ndim, num_positions) array
+        cnp.ndarray[float, ndim=2, mode="c"] cpos = np.ascontiguousarray(
+            positions, dtype=np.float32)
+        unsigned int ndim = cpos.shape[0]
+        size_t num_positions = cpos.shape[1]
+        # the neighbours are found from the first two coordinates only
+        cnp.ndarray x = cpos[0]
+        cnp.ndarray y = cpos[1] if ndim > 1 else np.zeros(num_positions,
+                                                          dtype=np.float32)
         float cscale = scale
 
     # compute the required values
+    edge_num = 0
+
     if max_proba <= 0.:
         edge_num, _ = _compute_connections(
             num_source, num_target, density, edges, avg_deg, directed)
-    else:
-        raise RuntimeError(
-            "Not working with max_proba and multithreading yet.")
 
     existing = 0  # for now
     b_one_pop = _check_num_edges(
         source_ids, target_ids, edge_num, directed, multigraph)
 
+    if exclude_self is None:
+        exclude_self = b_one_pop
+
     # for each node, check the neighbours that are in an area where
-    # connections can be made: +/- scale for lin, +/- 10*scale for exp
-    lim = scale if rule == 'lin' else 10*scale
-    for i in source_ids:
-        keep  = (np.abs(positions[0, target_ids] - positions[0, i]) < lim)
-        keep *= (np.abs(positions[1, target_ids] - positions[1, i]) < lim)
-        if b_one_pop:
-            idx = np.where(target_ids == i)[0][0]
-            keep[idx] = 0
-        local_targets.push_back(target_ids[keep].tolist())
+    # connections can be made: +/- scale for lin, +/- 10*scale for exp and
+    # gaussian, or the cutoff of a registered rule
+    cdef float lim = _distance_rule_cutoff(crule)*scale
+
+    tgt_offsets, tgt_indices = _csr_neighbours(
+        sources, targets, x, y, lim, exclude_self, omp)
 
     # create the edges
     cdef:
         size_t cedges = edge_num
-        int64_t[:, :] ia_edges = np.full((existing + edge_num, 2), -1,
-                                         dtype=DTYPE)
-        vector[float] dist = vector[float]()
+        int64_t[:, :] ia_edges
+        int64_t* edge_ptr = NULL
+        cnp.ndarray[float, ndim=1] dist
+        float* dist_ptr = NULL
         vector[long] seeds = _random_init(omp)
+        edge_sink sink = NULL
+        _EdgeCallback callback = None
 
     if max_proba <= 0.:
-        _cdistance_rule(&ia_edges[0,0], source_ids, local_targets, crule,
-                        cscale, 1., x, y, cnum_neurons, cedges, old_edges,
-                        dist, multigraph, directed, seeds)
-        distance.extend(dist)
-        return ia_edges
+        if edge_callback is None:
+            ia_edges = np.full((existing + edge_num, 2), -1, dtype=DTYPE)
+
+            if existing + edge_num:
+                edge_ptr = &ia_edges[0, 0]
+
+            # the distances are written in place (not computed if unused)
+            if distance is not None and edge_num:
+                dist     = np.empty(edge_num, dtype=np.float32)
+                dist_ptr = &dist[0]
+        else:
+            callback = _EdgeCallback(edge_callback)
+            sink     = _edge_sink
+
+        _cdistance_rule(edge_ptr, _size_view(sources), &tgt_offsets[0],
+                        _first(tgt_indices), crule, cscale, 1., &cpos[0, 0],
+                        ndim, num_positions, cnum_neurons, cedges,
+                        _edge_view(None), dist_ptr, multigraph, directed,
+                        seeds[0], omp, sink, <void*> callback, batch_size)
+
+        if edge_callback is not None:
+            callback.reraise()
+            return None
+
+        if dist_ptr != NULL:
+            distance.extend(dist.tolist())
+
+        return np.asarray(ia_edges)
+
+    # max_proba: each pair of neighbours is tested once
+    cdef:
+        _EdgeBuffer buf = _EdgeBuffer()
+        bool pairs_once = b_one_pop and not directed
+        size_t num_new
+
+    if edge_callback is not None:
+        callback = _EdgeCallback(edge_callback)
+        sink     = _edge_sink
+
+    num_new = _cdistance_rule_proba(
+        buf.edges, _size_view(sources), &tgt_offsets[0], _first(tgt_indices),
+        crule, cscale, max_proba, &cpos[0, 0], ndim, num_positions,
+        pairs_once, buf.dist, seeds[0], omp, sink, <void*> callback,
+        batch_size)
+
+    if edge_callback is not None:
+        callback.reraise()
+        return None
+
+    if distance is not None:
+        distance.extend(_wrap_dist(buf).tolist())
+
+    return _wrap_edges(buf, num_new)
+
+
+def _rule_cutoff(rule):
+    '''
+    Distance, in units of the scale, beyond which `rule` is never tested (1
+    for "lin", 10 for "exp" and "gaussian", or the cutoff of a registered
+    rule).
+    '''
+    return _distance_rule_cutoff(_to_bytes(rule))
+
+
+def _spatial_neighbours(cnp.ndarray[size_t, ndim=1] source_ids,
+                        cnp.ndarray[size_t, ndim=1] target_ids,
+                        cnp.ndarray[float, ndim=2] positions, float lim,
+                        bool exclude_self=True):
+    '''
+    Return, for each source, the array of targets located strictly inside the
+    square box of half-width `lim` centered on the source (targets are
+    returned in the order of `target_ids`).
+    '''
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        cnp.ndarray x = np.ascontiguousarray(positions[0], dtype=np.float32)
+        cnp.ndarray y = np.ascontiguousarray(positions[1], dtype=np.float32)
+
+    tgt_offsets, tgt_indices = _csr_neighbours(
+        np.ascontiguousarray(source_ids, dtype=np.uint),
+        np.ascontiguousarray(target_ids, dtype=np.uint), x, y, lim,
+        exclude_self, omp)
+
+    return np.split(tgt_indices.astype(int), tgt_offsets[1:-1])
+
+
+def _neighbour_number(cnp.ndarray[size_t, ndim=1] source_ids,
+                      cnp.ndarray[size_t, ndim=1] target_ids,
+                      cnp.ndarray[float, ndim=2] positions, float lim,
+                      bool exclude_self=True):
+    '''
+    Total number of targets of all sources in the boxes of
+    :func:`_spatial_neighbours`, only counted.
+    '''
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        size_t num_sources = source_ids.shape[0]
+        size_t num_positions = positions.shape[1]
+        cnp.ndarray x = np.ascontiguousarray(positions[0], dtype=np.float32)
+        cnp.ndarray y = np.ascontiguousarray(
+            positions[1] if positions.shape[0] > 1
+            else np.zeros(num_positions), dtype=np.float32)
+        cnp.ndarray sources = np.ascontiguousarray(source_ids, dtype=np.uint)
+        cnp.ndarray targets = np.ascontiguousarray(target_ids, dtype=np.uint)
+        cnp.ndarray[size_t, ndim=1] offsets = np.zeros(num_sources + 1,
+                                                       dtype=np.uint)
+
+    _box_neighbours(_size_view(sources), _size_view(targets), _float_view(x),
+                    _float_view(y), lim, exclude_self, &offsets[0], NULL,
+                    omp)
+
+    return offsets[num_sources]
+
+
+cdef tuple _csr_neighbours(cnp.ndarray sources, cnp.ndarray targets,
+                           cnp.ndarray x, cnp.ndarray y, float lim,
+                           bool exclude_self, unsigned int omp):
+    '''
+    Compute the neighbours of each source in CSR format, returns the
+    (offsets, indices) NumPy arrays.
+
+    `sources` and `targets` must be contiguous np.uint arrays, `x` and `y`
+    contiguous np.float32 arrays.
+    '''
+    cdef:
+        size_t num_sources = sources.shape[0]
+        cnp.ndarray[size_t, ndim=1] offsets = np.zeros(num_sources + 1,
+                                                       dtype=np.uint)
+        cnp.ndarray[size_t, ndim=1] indices
+
+    # first count the neighbours, then fill the arrays in place
+    _box_neighbours(_size_view(sources), _size_view(targets), _float_view(x),
+                    _float_view(y), lim, exclude_self, &offsets[0], NULL,
+                    omp)
+
+    indices = np.empty(offsets[num_sources], dtype=np.uint)
+
+    _box_neighbours(_size_view(sources), _size_view(targets), _float_view(x),
+                    _float_view(y), lim, exclude_self, &offsets[0],
+                    _first(indices), omp)
+
+    return offsets, indices
+
+
+# -------------- #
+# Graph analysis #
+# -------------- #
+
+cdef class _CSRBuffer:
+    '''
+    Contiguous int64/float64 arrays of a scipy sparse matrix in CSR format
+    with sorted indices, kept alive while C++ reads them through a view.
+    '''
+
+    cdef cnp.ndarray indptr
+    cdef cnp.ndarray indices
+    cdef cnp.ndarray data
+
+    def __init__(self, mat):
+        mat = ssp.csr_matrix(mat)
+
+        if not mat.has_canonical_format:
+            mat = mat.copy()
+            mat.sum_duplicates()
+
+        self.indptr  = np.ascontiguousarray(mat.indptr, dtype=DTYPE)
+        self.indices = np.ascontiguousarray(mat.indices, dtype=DTYPE)
+        self.data    = np.ascontiguousarray(mat.data, dtype=np.float64)
+
+    cdef csr_view view(self):
+        return csr_view(
+            array_view[int64_t](<int64_t*> cnp.PyArray_DATA(self.indptr),
+                                cnp.PyArray_SIZE(self.indptr)),
+            array_view[int64_t](<int64_t*> cnp.PyArray_DATA(self.indices),
+                                cnp.PyArray_SIZE(self.indices)),
+            array_view[double](<double*> cnp.PyArray_DATA(self.data),
+                               cnp.PyArray_SIZE(self.data)))
+
+
+def _triangle_intensity(matsym):
+    '''
+    Intensity of the triangles of each node for a symmetric sparse matrix,
+    equal to 0.5*(matsym@matsym@matsym).diagonal() with a null diagonal (C++
+    function, nothing larger than `matsym` is allocated).
+    '''
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        _CSRBuffer sym = _CSRBuffer(matsym)
+        cnp.ndarray[double, ndim=1] strength = np.zeros(matsym.shape[0])
+
+    if len(strength):
+        _triangle_strength(sym.view(), &strength[0], omp)
+
+    return strength
+
+
+def _product_diagonal(x, y, z):
+    '''
+    Diagonal of x@y@z for three square sparse matrices, ignoring their
+    diagonal entries (C++ function, the product is never materialised).
+    '''
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        _CSRBuffer cx  = _CSRBuffer(x)
+        _CSRBuffer cy  = _CSRBuffer(y)
+        _CSRBuffer czt = _CSRBuffer(ssp.csr_matrix(z).T)
+        cnp.ndarray[double, ndim=1] out = np.zeros(x.shape[0])
 
-    for i, s in enumerate(source_ids):
-        loc_tgts = np.array(local_targets[i], dtype=int)
-        if len(loc_tgts):
-            dist_tmp = []
-            test = max_proba_dist_rule(
-                rule, scale, max_proba, positions[:, s],
-                positions[:, loc_tgts], dist=dist_tmp)
-            test = np.greater(test, np.random.uniform(size=len(test)))
-            added = np.sum(test)
-            sources.extend((s for i in range(added)))
-            targets.extend(loc_tgts[test])
-            distance.extend(np.array(dist_tmp)[test])
-    return np.array([sources, targets]).T
+    if len(out):
+        _diag_product(cx.view(), cy.view(), czt.view(), &out[0], omp)
+
+    return out
+
+
+def _connected_components(edges, size_t num_nodes, bool strong=True):
+    '''
+    Strongly (or weakly if `strong` is False) connected components of a graph
+    given by its (E, 2) array of edges (C++ function).
+
+    Returns the component of each node, with components sorted by decreasing
+    size, and the size of each component.
+    '''
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        cnp.ndarray cedges = np.ascontiguousarray(edges, dtype=DTYPE)
+        cnp.ndarray[int64, ndim=1] labels = np.zeros(num_nodes, dtype=DTYPE)
+        size_t num_cc = 0
+
+    if num_nodes:
+        num_cc = _components(_edge_view(cedges), num_nodes, strong,
+                             &labels[0], omp)
+
+    return labels, np.bincount(labels, minlength=num_cc)
+
+
+# ----------------- #
+# Activity analysis #
+# ----------------- #
+
+def _add_spike_chunk(nodes, senders, times, cnp.ndarray state):
+    '''
+    Update the (N, 8) spike statistics of the sorted `nodes` in place with a
+    chunk of spikes (C++ function, see :class:`~nngt.analysis.SpikeStatistics`
+    for the columns).
+    '''
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        cnp.ndarray cnodes = np.ascontiguousarray(nodes, dtype=DTYPE)
+        cnp.ndarray csend  = np.ascontiguousarray(senders, dtype=DTYPE)
+        cnp.ndarray ctimes = np.ascontiguousarray(times, dtype=np.float64)
+
+    if state.dtype != np.float64 or not state.flags.c_contiguous \
+       or state.ndim != 2 or state.shape[0] != len(cnodes) \
+       or state.shape[1] != NUM_SPIKE_STATS:
+        raise ValueError("`state` must be a C-contiguous float64 array of "
+                         "shape ({}, {}).".format(len(cnodes),
+                                                  NUM_SPIKE_STATS))
+
+    if len(cnodes) and len(csend):
+        _add_spikes(_edge_view(cnodes), _edge_view(csend),
+                    _double_view(ctimes), <double*> cnp.PyArray_DATA(state),
+                    omp)
+
+
+def _spike_histogram(times, double start, double bin_size, size_t num_bins):
+    '''
+    Number of spikes in each of the `num_bins` bins of width `bin_size`,
+    centered on ``start + i*bin_size``, with each spike counted in the bin
+    with the nearest center (C++ function).
+    '''
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        cnp.ndarray ctimes = np.ascontiguousarray(times, dtype=np.float64)
+        cnp.ndarray[int64, ndim=1] counts = np.zeros(num_bins, dtype=DTYPE)
+
+    if num_bins:
+        _bin_spikes(_double_view(ctimes), start, bin_size, num_bins,
+                    &counts[0], omp)
+
+    return counts
+
+
+def _event_blocks(block_length, cum_counts, prior):
+    '''
+    Start of the last block of the optimal partition ending at each cell for
+    Bayesian blocks with the "events" fitness (C++ function).
+    '''
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        cnp.ndarray clength = np.ascontiguousarray(block_length,
+                                                   dtype=np.float64)
+        cnp.ndarray ccounts = np.ascontiguousarray(cum_counts,
+                                                   dtype=np.float64)
+        cnp.ndarray cprior  = np.ascontiguousarray(prior, dtype=np.float64)
+        cnp.ndarray[int64, ndim=1] last = np.zeros(len(cprior), dtype=DTYPE)
+
+    if len(cprior):
+        _bayesian_blocks_events(_double_view(clength), _double_view(ccounts),
+                                _double_view(cprior), &last[0], omp)
+
+    return last
+
+
+# ---------- #
+# Text files #
+# ---------- #
+
+def _parse_edge_file(filename, fmt, separator, secondary, notifier, ignore,
+                     size_t num_attributes):
+    '''
+    Edges and attribute values of an "edge_list" or "neighbour" file, parsed
+    in parallel from a memory map of the file (C++ function).
+
+    `separator` and `secondary` must be single (ASCII) characters, the
+    attributes must all be numbers: their (E, `num_attributes`) array of
+    values is returned as float64.
+    '''
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        _EdgeBuffer buf = _EdgeBuffer()
+        Py_buffer view
+        size_t num_edges = 0
+        char csep = _to_bytes(separator)[0]
+        char csec = _to_bytes(secondary)[0]
+
+    with open(filename, "rb") as f:
+        if os.fstat(f.fileno()).st_size > 0:
+            mapped = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+
+            PyObject_GetBuffer(mapped, &view, PyBUF_SIMPLE)
+
+            try:
+                num_edges = _parse_edges(
+                    <const char*> view.buf, view.len, fmt == "neighbour",
+                    csep, csec, _to_bytes(notifier), _to_bytes(ignore),
+                    num_attributes, buf.edges, buf.values, omp)
+            finally:
+                PyBuffer_Release(&view)
+                mapped.close()
+
+    return _wrap_edges(buf, num_edges), _wrap_values(buf, num_attributes)
+
+
+def _write_edge_list(f, edges, values, integer, separator, secondary,
+                     size_t batch_size=BATCH_SIZE):
+    '''
+    Write the lines of an "edge_list" file to the binary file object `f`,
+    formatting `batch_size` edges at a time in parallel (C++ function), so
+    that the full text is never held in memory.
+
+    `values` is the (E, k) array of attribute values, `integer` says which
+    of the k attributes should be written as integers.
+    '''
+    cdef:
+        unsigned int omp = nngt._config["omp"]
+        cnp.ndarray cedges = np.ascontiguousarray(edges, dtype=DTYPE)
+        cnp.ndarray cvalues = np.ascontiguousarray(values, dtype=np.float64)
+        cnp.ndarray cinteger = np.ascontiguousarray(integer, dtype=np.uint8)
+        array_view[double] vview
+        array_view[uint8_t] iview
+        size_t num_edges = cnp.PyArray_SIZE(cedges) // 2
+        size_t step = max(batch_size, 1)
+        size_t first
+        bytes bsep = _to_bytes(separator)
+        bytes bsec = _to_bytes(secondary)
+        string out
+
+    vview = array_view[double](<double*> cnp.PyArray_DATA(cvalues),
+                               cnp.PyArray_SIZE(cvalues))
+    iview = array_view[uint8_t](<uint8_t*> cnp.PyArray_DATA(cinteger),
+                                cnp.PyArray_SIZE(cinteger))
+
+    for first in range(0, num_edges, step):
+        out.clear()
+
+        _format_edges(_edge_view(cedges), vview, iview, bsep, bsec, first,
+                      first + step, out, omp)
+
+        f.write(out)
 
 
 # ------------ #
@@ -564,6 +1427,10 @@ def _distance_rule(cnp.ndarray[size_t, ndim=1] source_ids,
 def _random_init(omp):
     '''
     Init the local random seeds
+
+    Note that the C++ generators only use the first seed: each node then
+    draws from its own random stream, so that the graphs do not depend on the
+    number of threads.
     '''
     # compute local random seeds
     seeds = None
@@ -576,7 +1443,8 @@ def _random_init(omp):
         nngt._config["seeds"] = seeds
     elif nngt._used_local:
         # the initial seeds have already been used so we generate new ones
-        msd   = np.random.randint(0, 2**31 - omp - 1)
+        # (fixed bound so the first seed does not depend on `omp`)
+        msd   = np.random.randint(0, 2**30)
         seeds = [msd + i + 1 for i in range(omp)]
     else:
         seeds = nngt.get_config('seeds')
@@ -19,6 +19,7 @@ __all__ = [
     "_all_to_all",
     "_circular",
     "_distance_rule",
+    "_edge_swaps",
     "_erdos_renyi",
     "_fixed_degree",
     "_from_degree_list",
@@ -476,15 +477,35 @@ def _random_scale_free(source_ids, target_ids, in_exp, out_exp, density=None,
 
 def _erdos_renyi(source_ids, target_ids, density=None, edges=None,
                  avg_deg=None, reciprocity=-1, directed=True, multigraph=False,
-                 **kwargs):
+                 exact_edge_nb=True, **kwargs):
     '''
     Returns a numpy array of dimension (2,edges) that describes the edge list
     of an Erdos-Renyi graph.
+
+    If `exact_edge_nb` is False and `density` is given, each possible edge
+    exists independently with probability `density` (G(n, p) model): there
+    are N(N - 1) possible edges in a directed population of N nodes, but
+    N(N - 1)/2 if it is undirected, whereas the G(n, m) model always creates
+    `density`*N^2 edges.
     @todo: perform all the calculations here
     '''
     source_ids = np.array(source_ids).astype(int)
     target_ids = np.array(target_ids).astype(int)
     num_source, num_target = len(source_ids), len(target_ids)
+
+    if not exact_edge_nb and density is not None:
+        # G(n, p) is G(n, m) with a binomial number of edges
+        if _check_num_edges(source_ids, target_ids, 0, directed, multigraph):
+            num_pairs = num_source*(num_source - 1)
+
+            if not directed:
+                num_pairs //= 2
+        else:
+            num_pairs = num_source*num_target
+
+        edges    = nngt._rng.binomial(num_pairs, density)
+        density  = None
+        avg_deg  = None
     edges, pre_recip_edges = _compute_connections(num_source, num_target,
                                 density, edges, avg_deg, directed, reciprocity)
 
@@ -1054,3 +1075,63 @@ def _distance_rule(source_ids, target_ids, density=None, edges=None,
         ia_edges = np.array([sources, targets]).T
 
     return ia_edges
+
+
+# -------- #
+# Rewiring #
+# -------- #
+
+def _edge_swaps(ia_edges, num_nodes, num_swaps, directed=True, groups=None,
+                **kwargs):
+    '''
+    Degree-preserving randomization through double edge swaps: (a, b) and
+    (c, d) become (a, d) and (c, b) if this creates neither a self-loop nor a
+    duplicate edge (and if b and d are in the same group when `groups` is
+    given).
+
+    Returns the rewired edges and the number of accepted swaps.
+    '''
+    ia_edges  = np.array(ia_edges, dtype=np.int64)
+    num_edges = len(ia_edges)
+
+    if num_edges < 2:
+        return ia_edges, 0
+
+    edges_hash = set(tuple(e) for e in ia_edges)
+
+    if not directed:
+        edges_hash.update(tuple(e) for e in ia_edges[:, ::-1])
+
+    rng = nngt._rng
+
+    chosen   = rng.integers(num_edges, size=(num_swaps, 2))
+    flip     = rng.integers(2, size=num_swaps) if not directed \
+               else np.zeros(num_swaps, dtype=int)
+    accepted = 0
+
+    for (e0, e1), f in zip(chosen, flip):
+        a, b = ia_edges[e0]
+        c, d = ia_edges[e1][::-1] if f else ia_edges[e1]
+
+        if e0 == e1 or a == d or c == b:
+            continue
+
+        if groups is not None and groups[b] != groups[d]:
+            continue
+
+        if (a, d) in edges_hash or (c, b) in edges_hash:
+            continue
+
+        edges_hash -= {(a, b), (c, d)}
+        edges_hash.update(((a, d), (c, b)))
+
+        if not directed:
+            edges_hash -= {(b, a), (d, c)}
+            edges_hash.update(((d, a), (b, c)))
+
+        ia_edges[e0] = (a, d)
+        ia_edges[e1] = (c, b)
+
+        accepted += 1
+
+    return ia_edges, accepted
@@ -10,6 +10,7 @@ import numpy as np
 import nngt
 from nngt.generation import graph_connectivity as gc
 from nngt.lib import is_iterable, nonstring_container
+from nngt.lib.connect_tools import _set_degree_type
 from nngt.lib.test_functions import deprecated
 from nngt.lib.rng_tools import _generate_random
 
@@ -17,6 +18,7 @@ from nngt.lib.rng_tools import _generate_random
 __all__ = [
     'connect_neural_groups',
     'connect_groups',
+    'connect_groups_batch',
     'connect_neural_types',
     'connect_nodes'
 ]
@@ -43,6 +45,22 @@ _one_pop_models = {
 }
 
 
+# models whose multithreaded generators can pass the edges by batches
+_streamed_models = {
+    "distance_rule", "fixed_degree", "from_degree_list", "gaussian_degree",
+}
+
+
+# models that connect_groups_batch can generate in a single parallel call
+_batched_models = {"fixed_degree", "from_degree_list", "gaussian_degree"}
+
+# parameters that connect_groups_batch handles for these models (the other
+# ones are passed to connect_groups)
+_batched_params = {
+    "avg", "degree", "degree_type", "degrees", "delays", "std", "weights",
+}
+
+
 def connect_nodes(network, sources, targets, graph_model, density=None,
                   edges=None, avg_deg=None, unit='um', weighted=True,
                   directed=True, multigraph=False, check_existing=True,
@@ -94,43 +112,52 @@ def connect_nodes(network, sources, targets, graph_model, density=None,
     targets  = np.array(targets, dtype=np.uint)
     distance = []
 
-    elist = _di_gen_edges[graph_model](
-        sources, targets, density=density, edges=edges,
-        avg_deg=avg_deg, weighted=weighted, directed=directed,
-        multigraph=multigraph, distance=distance, **kwargs)
-
-    # Attributes are not set by subfunctions
-    attr = {}
-
-    if 'weights' in kwargs:
-        ww = kwargs['weights']
-
-        if isinstance(ww, dict):
-            attr['weight'] = _generate_random(len(elist), ww)
-        elif nonstring_container(ww):
-            attr['weight'] = ww
-        else:
-            attr['weight'] = np.full(len(elist), ww)
-
-    if 'delays' in kwargs:
-        dd = kwargs['delays']
-
-        if isinstance(ww, dict):
-            attr['delay'] = _generate_random(len(elist), dd)
-        elif nonstring_container(dd):
-            attr['weight'] = dd
-        else:
-            attr['weight'] = np.full(len(elist), dd)
-
-    if network.is_spatial() and distance:
-        attr['distance'] = distance
-
-    # call only on root process (for mpi) unless using distributed backend
-    if nngt.on_master_process() or nngt.get_config("backend") == "nngt":
-        elist = network.new_edges(
-            elist, attributes=attr, check_duplicates=False,
-            check_self_loops=False, check_existing=check_existing,
-            ignore_invalid=ignore_invalid)
+    stream, existing_edges = _streaming_options(
+        network, graph_model, directed, multigraph, check_existing, kwargs)
+
+    if stream:
+        # each batch generated in C++ gets its attributes and is added to the
+        # network right away, no edge needs to be checked afterwards
+        batches = []
+        spatial = network.is_spatial()
+
+        def insert(batch, distances):
+            attr = _edge_attributes(kwargs, len(batch))
+
+            if spatial and distances is not None:
+                attr['distance'] = distances
+
+            batches.append(network.new_edges(
+                batch, attributes=attr, check_duplicates=False,
+                check_self_loops=False, check_existing=False,
+                ignore_invalid=ignore_invalid))
+
+        _di_gen_edges[graph_model](
+            sources, targets, density=density, edges=edges,
+            avg_deg=avg_deg, weighted=weighted, directed=directed,
+            multigraph=multigraph, existing_edges=existing_edges,
+            edge_callback=insert, **kwargs)
+
+        elist = np.concatenate(batches) if batches \
+                else np.zeros((0, 2), dtype=np.int64)
+    else:
+        elist = _di_gen_edges[graph_model](
+            sources, targets, density=density, edges=edges,
+            avg_deg=avg_deg, weighted=weighted, directed=directed,
+            multigraph=multigraph, distance=distance, **kwargs)
+
+        # Attributes are not set by subfunctions
+        attr = _edge_attributes(kwargs, len(elist))
+
+        if network.is_spatial() and distance:
+            attr['distance'] = distance
+
+        # call only on root process (for mpi) unless using distributed backend
+        if nngt.on_master_process() or nngt.get_config("backend") == "nngt":
+            elist = network.new_edges(
+                elist, attributes=attr, check_duplicates=False,
+                check_self_loops=False, check_existing=check_existing,
+                ignore_invalid=ignore_invalid)
 
     if not network._graph_type.endswith('_connect'):
         network._graph_type += "_nodes_connect"
@@ -217,6 +244,120 @@ def connect_neural_types(network, source_type, target_type, graph_model,
     return elist
 
 
+def connect_groups_batch(network, connections, weighted=True, directed=True,
+                         multigraph=False, check_existing=True,
+                         ignore_invalid=False):
+    '''
+    Function to connect several pairs of groups at once.
+
+    .. versionadded:: 2.8
+
+    Parameters
+    ----------
+    network : :class:`Network` or :class:`SpatialNetwork`
+        The network to connect.
+    connections : list of tuples
+        Each connection is given as ``(source_groups, target_groups,
+        graph_model, params)``, with `params` an optional dict of model
+        parameters and edge attributes and is equivalent to
+        ``connect_groups(network, source_groups, target_groups, graph_model,
+        **params)``.
+    weighted : bool, optional (default: True)
+        Whether the graph edges have weights. As `directed`, `multigraph`,
+        `check_existing`, and `ignore_invalid`, it applies to all connections
+        whose `params` do not give another value, and it is passed to
+        :func:`connect_groups` for those which are not batched (the batched
+        generators behave the same whatever its value).
+    directed : bool, optional (default: True)
+        Whether the edges are directed.
+    multigraph : bool, optional (default: False)
+        Whether the connections can create multiple edges between two nodes.
+    check_existing : bool, optional (default: True)
+        Check whether some of the edges that will be added already exist in the
+        graph.
+    ignore_invalid : bool, optional (default: False)
+        Ignore invalid edges: they are not added to the graph and are
+        silently dropped. Unless this is set to true, an error is raised
+        if an existing edge is re-generated.
+
+    Returns
+    -------
+    elist : array of shape (E, 2)
+        The edges that were added to the network.
+
+    Note
+    ----
+    When the multithreaded algorithms are used, the directed
+    "fixed_degree", "gaussian_degree", and "from_degree_list" connections
+    with in- or out-degrees are generated all together in a single parallel
+    call, then added to the network with a single insertion (unless their
+    edge attributes differ).
+    For simple graphs, a connection is only part of this batch if it cannot
+    generate the same edges as another connection of the batch; its `params`
+    must also only contain degree parameters, `weights`, and `delays`.
+    The other connections are then made one after the other with
+    :func:`connect_groups`.
+    '''
+    batched, others = [], []
+
+    batch_fn = None
+
+    if directed and gc.using_mt_algorithms and not nngt.get_config("mpi"):
+        from nngt.generation.cconnect import _batch_degree_edges as batch_fn
+
+    # sources and targets of the edges of each batched connection
+    batch_ends = []
+
+    for conn in connections:
+        source_groups, target_groups, graph_model = conn[:3]
+        params = dict(conn[3]) if len(conn) > 3 else {}
+
+        degree_type = _set_degree_type(params.get("degree_type", "in"))
+
+        if batch_fn is not None and graph_model in _batched_models \
+           and degree_type != "total" and _batched_params.issuperset(params):
+            first  = _group_ids(network, source_groups)
+            second = _group_ids(network, target_groups)
+
+            ends = (first, second) if degree_type == "out" else (second, first)
+
+            if multigraph or not any(_may_share_edges(ends, other)
+                                     for other in batch_ends):
+                batched.append((first, second, graph_model, params))
+                batch_ends.append(ends)
+                continue
+
+        others.append((source_groups, target_groups, graph_model, params))
+
+    elists = []
+
+    if batched:
+        elists.append(_connect_batch(
+            network, batched, batch_fn, multigraph, check_existing,
+            ignore_invalid))
+
+        if not network._graph_type.endswith('_neural_group_connect'):
+            network._graph_type += "_neural_group_connect"
+
+    for source_groups, target_groups, graph_model, params in others:
+        # the connection parameters take precedence over the common ones
+        kwargs = {
+            "weighted": weighted, "directed": directed,
+            "multigraph": multigraph, "check_existing": check_existing,
+            "ignore_invalid": ignore_invalid
+        }
+
+        kwargs.update(params)
+
+        elists.append(connect_groups(
+            network, source_groups, target_groups, graph_model, **kwargs))
+
+    elists = [np.asarray(e, dtype=np.int64).reshape(-1, 2) for e in elists]
+
+    return np.concatenate(elists) if elists \
+           else np.zeros((0, 2), dtype=np.int64)
+
+
 @deprecated("1.3.1", reason="the library is moving to more generic names",
             alternative="connect_groups", removal="3.0")
 def connect_neural_groups(*args, **kwargs):
@@ -264,37 +405,14 @@ def connect_groups(network, source_groups, target_groups, graph_model,
     specific degree (e.g. :func:`~nngt.generation.gaussian_degree`), the
     groups which have their property sets are the `source_groups`.
     '''
-    source_ids, target_ids = [], []
-
     if network.is_spatial():
         if 'positions' not in kwargs:
             kwargs['positions'] = network.get_positions().astype(np.float32).T
         if 'shape' not in kwargs:
             kwargs['shape'] = network.shape
 
-    if isinstance(source_groups, str) or not is_iterable(source_groups):
-        source_groups = [source_groups]
-    if isinstance(target_groups, str) or not is_iterable(target_groups):
-        target_groups = [target_groups]
-
-    for s in source_groups:
-        if isinstance(s, nngt.Structure):
-            source_ids.extend(s.ids)
-        elif isinstance(s, nngt.Group):
-            source_ids.extend(s.ids)
-        else:
-            source_ids.extend(network.structure[s].ids)
-
-    for t in target_groups:
-        if isinstance(t, nngt.Structure):
-            target_ids.extend(t.ids)
-        elif isinstance(t, nngt.Group):
-            target_ids.extend(t.ids)
-        else:
-            target_ids.extend(network.structure[t].ids)
-
-    source_ids = np.array(source_ids, dtype=np.uint)
-    target_ids = np.array(target_ids, dtype=np.uint)
+    source_ids = _group_ids(network, source_groups)
+    target_ids = _group_ids(network, target_groups)
 
     elist = connect_nodes(
         network, source_ids, target_ids, graph_model, density=density,
@@ -307,3 +425,177 @@ def connect_groups(network, source_groups, target_groups, graph_model,
         network._graph_type += "_neural_group_connect"
 
     return elist
+
+
+# ----- #
+# Tools #
+# ----- #
+
+def _group_ids(network, groups):
+    '''
+    Ids of the nodes in `groups` (names, :class:`~nngt.Group` or
+    :class:`~nngt.Structure` objects, or a list of them).
+    '''
+    ids = []
+
+    if isinstance(groups, str) or not is_iterable(groups):
+        groups = [groups]
+
+    for g in groups:
+        if isinstance(g, (nngt.Structure, nngt.Group)):
+            ids.extend(g.ids)
+        else:
+            ids.extend(network.structure[g].ids)
+
+    return np.array(ids, dtype=np.uint)
+
+
+def _degrees(graph_model, params, num_nodes):
+    ''' Degrees drawn by a degree-based model for `num_nodes` nodes '''
+    if graph_model == "fixed_degree":
+        degree = int(params.get("degree", -1))
+
+        assert degree >= 0, "A positive value is required for `degree`."
+
+        return np.repeat(degree, num_nodes)
+
+    if graph_model == "gaussian_degree":
+        avg = float(params.get("avg", -1))
+        std = float(params.get("std", -1))
+
+        assert avg >= 0, "A positive value is required for `avg`."
+        assert std >= 0, "A positive value is required for `std`."
+
+        return np.around(np.maximum(
+            nngt._rng.normal(avg, std, num_nodes), 0)).astype(np.uint64)
+
+    return np.asarray(params["degrees"])
+
+
+def _may_share_edges(ends, other):
+    '''
+    Whether two connections with (sources, targets) `ends` and `other` can
+    generate the same edges (id ranges are compared first since groups are
+    usually contiguous).
+    '''
+    for a, b in zip(ends, other):
+        if len(a) == 0 or len(b) == 0 or a.max() < b.min() \
+           or b.max() < a.min() or not np.isin(a, b).any():
+            return False
+
+    return True
+
+
+def _connect_batch(network, batched, batch_fn, multigraph, check_existing,
+                   ignore_invalid):
+    '''
+    Generate the edges of the degree-based connections in `batched` with a
+    single C++ call, then add them to `network`.
+    '''
+    first  = [b[0] for b in batched]
+    second = [b[1] for b in batched]
+
+    degrees = [_degrees(model, params, len(f))
+               for f, (_, _, model, params) in zip(first, batched)]
+
+    degree_types = [params.get("degree_type", "in")
+                    for _, _, _, params in batched]
+
+    existing_edges = None
+
+    if check_existing and not multigraph and network.edge_nb():
+        existing_edges = network.edges_array
+
+    ia_edges, offsets = batch_fn(first, second, degrees, degree_types,
+                                 multigraph=multigraph,
+                                 existing_edges=existing_edges)
+
+    # insert together the connections with the same edge attributes
+    groups = {}
+
+    for j, (_, _, _, params) in enumerate(batched):
+        attr = _edge_attributes(params, offsets[j + 1] - offsets[j])
+
+        edges, values = groups.setdefault(tuple(sorted(attr)), ([], []))
+
+        edges.append(ia_edges[offsets[j]:offsets[j + 1]])
+        values.append(attr)
+
+    elists = []
+
+    for names, (edges, values) in groups.items():
+        attr = {
+            name: np.concatenate([np.asarray(v[name]) for v in values])
+            for name in names
+        }
+
+        elists.append(network.new_edges(
+            np.concatenate(edges), attributes=attr, check_duplicates=False,
+            check_self_loops=False, check_existing=check_existing,
+            ignore_invalid=ignore_invalid))
+
+    return np.concatenate(elists)
+
+
+def _edge_attributes(kwargs, num_edges):
+    '''
+    Weights and delays of `num_edges` new edges from the `weights` and
+    `delays` entries of the connectors' keyword arguments (the generators do
+    not set the attributes).
+    '''
+    attr = {}
+
+    for key, name in (("weights", "weight"), ("delays", "delay")):
+        if key in kwargs:
+            val = kwargs[key]
+
+            if isinstance(val, dict):
+                attr[name] = _generate_random(num_edges, val)
+            elif nonstring_container(val):
+                attr[name] = val
+            else:
+                attr[name] = np.full(num_edges, val)
+
+    return attr
+
+
+def _streaming_options(network, graph_model, directed, multigraph,
+                       check_existing, kwargs):
+    '''
+    Whether the edges of `graph_model` can be added to `network` by batches
+    as they are generated and, if so, the existing edges that the generator
+    must avoid (None if there is nothing to avoid).
+
+    Batches are never checked, so streaming is only used if the generator
+    guarantees that the edges are valid.
+    '''
+    if graph_model not in _streamed_models or nngt.get_config("mpi") \
+       or not gc.using_mt_algorithms:
+        return False, None
+
+    # values given for all edges must match the full edge list
+    for key in ("weights", "delays"):
+        val = kwargs.get(key)
+
+        if not isinstance(val, dict) and nonstring_container(val):
+            return False, None
+
+    if not check_existing:
+        return True, None
+
+    # existing edges also include the duplicates of multigraphs
+    if multigraph:
+        return False, None
+
+    if network.edge_nb() == 0:
+        return True, None
+
+    # only the directed in/out-degree generators can avoid existing edges,
+    # and only in a directed network, where (v, u) does not duplicate (u, v)
+    degree_type = _set_degree_type(kwargs.get("degree_type", "in"))
+
+    if graph_model != "distance_rule" and directed \
+       and network.is_directed() and degree_type != "total":
+        return True, network.edges_array
+
+    return False, None
@@ -0,0 +1,786 @@
+// SPDX-FileCopyrightText: 2015-2023 Tanguy Fardet
+// SPDX-License-Identifier: GPL-3.0-or-later
+// nngt/generation/func_analysis.cpp
+//
+// Accelerated graph and activity analysis functions
+
+#include "func_analysis.h"
+
+#include <omp.h>
+
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <numeric>  // partial_sum, iota
+#include <stdexcept>
+
+
+namespace generation {
+
+// size ratio above which sorted ranges are intersected by binary search
+const size_t GALLOP_RATIO = 16;
+
+// number of cells below which Bayesian blocks are computed sequentially
+const size_t BLOCKS_PARALLEL = 2048;
+
+
+/*
+ * Call `f(pa, pb)` for each pair of positions holding the same value in the
+ * sorted ranges [a, a_end) and [b, b_end).
+ * The shortest range is looked up in the longest one by binary search when
+ * their sizes are very different (e.g. for hubs), otherwise both are merged.
+ */
+template <typename F>
+static inline void _intersect(const int64_t* a, const int64_t* a_end,
+                              const int64_t* b, const int64_t* b_end, F f)
+{
+    const size_t na = a_end - a;
+    const size_t nb = b_end - b;
+
+    if (na == 0 || nb == 0)
+    {
+        return;
+    }
+
+    if (na*GALLOP_RATIO < nb)
+    {
+        for (; a != a_end; a++)
+        {
+            b = std::lower_bound(b, b_end, *a);
+
+            if (b == b_end)
+            {
+                return;
+            }
+
+            if (*b == *a)
+            {
+                f(a, b);
+            }
+        }
+    }
+    else if (nb*GALLOP_RATIO < na)
+    {
+        for (; b != b_end; b++)
+        {
+            a = std::lower_bound(a, a_end, *b);
+
+            if (a == a_end)
+            {
+                return;
+            }
+
+            if (*a == *b)
+            {
+                f(a, b);
+            }
+        }
+    }
+    else
+    {
+        while (a != a_end && b != b_end)
+        {
+            if (*a < *b)
+            {
+                a++;
+            }
+            else if (*b < *a)
+            {
+                b++;
+            }
+            else
+            {
+                f(a, b);
+                a++;
+                b++;
+            }
+        }
+    }
+}
+
+
+static void _check_square(const csr_view& mat, size_t num_nodes)
+{
+    if (mat.indptr.size() != num_nodes + 1)
+    {
+        throw std::invalid_argument("Matrices must have the same shape.");
+    }
+
+    if (mat.indices.size() != mat.data.size()
+        || (size_t) mat.indptr[num_nodes] != mat.indices.size())
+    {
+        throw std::invalid_argument("Invalid CSR matrix.");
+    }
+}
+
+
+/*
+ * Triangles
+ */
+
+void _triangle_strength(const csr_view& sym, double* strength,
+                        unsigned int omp)
+{
+    const size_t num_nodes = sym.num_rows();
+
+    _check_square(sym, num_nodes);
+
+    const int64_t* indptr  = sym.indptr.data();
+    const int64_t* indices = sym.indices.data();
+
+    // edges go from u to v if v has a higher (degree, id) rank
+    auto oriented = [indptr](int64_t u, int64_t v)
+    {
+        int64_t du = indptr[u + 1] - indptr[u];
+        int64_t dv = indptr[v + 1] - indptr[v];
+
+        return du < dv || (du == dv && u < v);
+    };
+
+    // sorted out-neighbours in the oriented graph
+    std::vector<int64_t> optr(num_nodes + 1, 0);
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t u=0; u < num_nodes; u++)
+    {
+        int64_t count = 0;
+
+        for (int64_t e=indptr[u]; e < indptr[u + 1]; e++)
+        {
+            count += oriented(u, indices[e]);
+        }
+
+        optr[u + 1] = count;
+    }
+
+    std::partial_sum(optr.begin(), optr.end(), optr.begin());
+
+    std::vector<int64_t> oidx(optr[num_nodes]);
+    std::vector<double> ow(optr[num_nodes]);
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t u=0; u < num_nodes; u++)
+    {
+        int64_t pos = optr[u];
+
+        for (int64_t e=indptr[u]; e < indptr[u + 1]; e++)
+        {
+            if (oriented(u, indices[e]))
+            {
+                oidx[pos] = indices[e];
+                ow[pos]   = sym.data[e];
+                pos++;
+            }
+        }
+    }
+
+    const int64_t* base = oidx.data();
+
+    // intensity of the triangles (u, v, w) found from u, for v and w, stored
+    // on the oriented edges u -> v and u -> w so that each node only writes
+    // in its own range and the sums do not depend on the threads
+    std::vector<double> edge_strength(optr[num_nodes], 0.);
+
+    #pragma omp parallel for num_threads(omp) schedule(dynamic, 64)
+    for (size_t u=0; u < num_nodes; u++)
+    {
+        const int64_t* u_first = base + optr[u];
+        const int64_t* u_last  = base + optr[u + 1];
+
+        double local = 0.;
+
+        for (const int64_t* pv = u_first; pv != u_last; pv++)
+        {
+            const int64_t v   = *pv;
+            const double w_uv = ow[pv - base];
+
+            // closing nodes w of the triangles (u, v, w)
+            _intersect(u_first, u_last, base + optr[v], base + optr[v + 1],
+                [&](const int64_t* pa, const int64_t* pb)
+                {
+                    double intensity = w_uv*ow[pa - base]*ow[pb - base];
+
+                    local += intensity;
+
+                    edge_strength[pv - base] += intensity;
+                    edge_strength[pa - base] += intensity;
+                });
+        }
+
+        strength[u] = local;
+    }
+
+    // add the contributions of the oriented edges to their targets, in
+    // edge order
+    for (size_t e=0; e < edge_strength.size(); e++)
+    {
+        strength[oidx[e]] += edge_strength[e];
+    }
+}
+
+
+void _diag_product(const csr_view& x, const csr_view& y, const csr_view& zt,
+                   double* out, unsigned int omp)
+{
+    const size_t num_nodes = x.num_rows();
+
+    _check_square(x, num_nodes);
+    _check_square(y, num_nodes);
+    _check_square(zt, num_nodes);
+
+    const int64_t* ybase = y.indices.data();
+    const int64_t* zbase = zt.indices.data();
+
+    #pragma omp parallel for num_threads(omp) schedule(dynamic, 64)
+    for (size_t i=0; i < num_nodes; i++)
+    {
+        const int64_t node = i;
+
+        const int64_t* z_first = zbase + zt.indptr[i];
+        const int64_t* z_last  = zbase + zt.indptr[i + 1];
+
+        double total = 0.;
+
+        for (int64_t e=x.indptr[i]; e < x.indptr[i + 1]; e++)
+        {
+            const int64_t j = x.indices[e];
+
+            if (j == node)
+            {
+                continue;
+            }
+
+            double inner = 0.;
+
+            _intersect(ybase + y.indptr[j], ybase + y.indptr[j + 1],
+                       z_first, z_last,
+                [&](const int64_t* pa, const int64_t* pb)
+                {
+                    if (*pa != node && *pa != j)
+                    {
+                        inner += y.data[pa - ybase]*zt.data[pb - zbase];
+                    }
+                });
+
+            total += x.data[e]*inner;
+        }
+
+        out[i] = total;
+    }
+}
+
+
+
+/*
+ * Connected components
+ */
+
+// root of `x` in the union-find forest, with path halving
+static inline int64_t _find(std::vector< std::atomic<int64_t> >& parent,
+                            int64_t x)
+{
+    int64_t p = parent[x].load(std::memory_order_relaxed);
+
+    while (p != x)
+    {
+        int64_t gp = parent[p].load(std::memory_order_relaxed);
+
+        // concurrent updates only ever replace a parent by an ancestor
+        parent[x].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+
+        x = p;
+        p = parent[x].load(std::memory_order_relaxed);
+    }
+
+    return x;
+}
+
+
+static void _union_find(array_view<int64_t> edges, size_t num_nodes,
+                        int64_t* roots, unsigned int omp)
+{
+    std::vector< std::atomic<int64_t> > parent(num_nodes);
+
+    for (size_t i=0; i < num_nodes; i++)
+    {
+        parent[i].store(i, std::memory_order_relaxed);
+    }
+
+    const size_t num_edges = edges.size() / 2;
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t e=0; e < num_edges; e++)
+    {
+        int64_t u = edges[2*e];
+        int64_t v = edges[2*e + 1];
+
+        while (true)
+        {
+            u = _find(parent, u);
+            v = _find(parent, v);
+
+            if (u == v)
+            {
+                break;
+            }
+
+            // link the root with the highest id below the other one, this
+            // only succeeds if it is still a root
+            if (u < v)
+            {
+                std::swap(u, v);
+            }
+
+            int64_t expected = u;
+
+            if (parent[u].compare_exchange_strong(expected, v))
+            {
+                break;
+            }
+        }
+    }
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t i=0; i < num_nodes; i++)
+    {
+        roots[i] = _find(parent, i);
+    }
+}
+
+
+static void _tarjan(array_view<int64_t> edges, size_t num_nodes,
+                    int64_t* roots)
+{
+    const size_t num_edges = edges.size() / 2;
+
+    // out-neighbours in CSR format (counting sort on the sources)
+    std::vector<int64_t> indptr(num_nodes + 1, 0);
+    std::vector<int64_t> indices(num_edges);
+
+    for (size_t e=0; e < num_edges; e++)
+    {
+        indptr[edges[2*e] + 1]++;
+    }
+
+    std::partial_sum(indptr.begin(), indptr.end(), indptr.begin());
+
+    std::vector<int64_t> pos(indptr.begin(), indptr.end() - 1);
+
+    for (size_t e=0; e < num_edges; e++)
+    {
+        indices[pos[edges[2*e]]++] = edges[2*e + 1];
+    }
+
+    // iterative Tarjan: `calls` replaces the recursion and stores, for each
+    // node being explored, the position of the next edge to follow
+    const int64_t unvisited = -1;
+
+    std::vector<int64_t> index(num_nodes, unvisited), low(num_nodes);
+    std::vector<bool> on_stack(num_nodes, false);
+    std::vector<int64_t> stack, calls;
+
+    int64_t counter = 0;
+
+    for (size_t s=0; s < num_nodes; s++)
+    {
+        if (index[s] != unvisited)
+        {
+            continue;
+        }
+
+        index[s] = low[s] = counter++;
+        stack.push_back(s);
+        on_stack[s] = true;
+        calls.push_back(s);
+        pos[s] = indptr[s];
+
+        while (!calls.empty())
+        {
+            const int64_t v = calls.back();
+
+            bool descend = false;
+
+            while (pos[v] < indptr[v + 1])
+            {
+                const int64_t w = indices[pos[v]++];
+
+                if (index[w] == unvisited)
+                {
+                    index[w] = low[w] = counter++;
+                    stack.push_back(w);
+                    on_stack[w] = true;
+                    calls.push_back(w);
+                    pos[w] = indptr[w];
+                    descend = true;
+                    break;
+                }
+                else if (on_stack[w])
+                {
+                    low[v] = std::min(low[v], index[w]);
+                }
+            }
+
+            if (descend)
+            {
+                continue;
+            }
+
+            // all edges of v have been followed
+            calls.pop_back();
+
+            if (low[v] == index[v])
+            {
+                int64_t w;
+
+                do
+                {
+                    w = stack.back();
+                    stack.pop_back();
+                    on_stack[w] = false;
+                    roots[w]    = v;
+                }
+                while (w != v);
+            }
+
+            if (!calls.empty())
+            {
+                const int64_t u = calls.back();
+
+                low[u] = std::min(low[u], low[v]);
+            }
+        }
+    }
+}
+
+
+size_t _components(array_view<int64_t> edges, size_t num_nodes, bool strong,
+                   int64_t* labels, unsigned int omp)
+{
+    const size_t num_edges = edges.size() / 2;
+
+    for (size_t i=0; i < 2*num_edges; i++)
+    {
+        if (edges[i] < 0 || (size_t) edges[i] >= num_nodes)
+        {
+            throw std::invalid_argument("Edges contain invalid nodes.");
+        }
+    }
+
+    // representative node of each component
+    if (strong)
+    {
+        _tarjan(edges, num_nodes, labels);
+    }
+    else
+    {
+        _union_find(edges, num_nodes, labels, omp);
+    }
+
+    // sort the components by decreasing size, then by smallest node
+    std::vector<int64_t> size(num_nodes, 0), first(num_nodes, -1);
+
+    for (size_t i=0; i < num_nodes; i++)
+    {
+        int64_t r = labels[i];
+
+        size[r]++;
+
+        if (first[r] < 0)
+        {
+            first[r] = i;
+        }
+    }
+
+    std::vector<int64_t> reps;
+
+    for (size_t r=0; r < num_nodes; r++)
+    {
+        if (size[r] > 0)
+        {
+            reps.push_back(r);
+        }
+    }
+
+    std::sort(reps.begin(), reps.end(),
+        [&size, &first](int64_t a, int64_t b)
+        {
+            return size[a] > size[b]
+                   || (size[a] == size[b] && first[a] < first[b]);
+        });
+
+    // reuse `first` to store the label of each representative
+    for (size_t c=0; c < reps.size(); c++)
+    {
+        first[reps[c]] = c;
+    }
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t i=0; i < num_nodes; i++)
+    {
+        labels[i] = first[labels[i]];
+    }
+
+    return reps.size();
+}
+
+
+/*
+ * Spike trains
+ */
+
+void _add_spikes(array_view<int64_t> nodes, array_view<int64_t> senders,
+                 array_view<double> times, double* state, unsigned int omp)
+{
+    const size_t num_nodes  = nodes.size();
+    const size_t num_spikes = senders.size();
+
+    if (times.size() != num_spikes)
+    {
+        throw std::invalid_argument("`senders` and `times` must have the "
+                                    "same size.");
+    }
+
+    if (num_spikes == 0 || num_nodes == 0)
+    {
+        return;
+    }
+
+    // position of the neuron of each spike (num_nodes if it is ignored)
+    std::vector<size_t> pos(num_spikes);
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t s=0; s < num_spikes; s++)
+    {
+        const int64_t* it = std::lower_bound(nodes.begin(), nodes.end(),
+                                             senders[s]);
+
+        pos[s] = (it != nodes.end() && *it == senders[s]) ?
+                 it - nodes.begin() : num_nodes;
+    }
+
+    // stable bucketing: each block of spikes counts its spikes per neuron,
+    // then writes them after those of the previous blocks
+    const size_t num_blocks = std::max(std::min(static_cast<size_t>(omp),
+                                                num_spikes), size_t(1));
+    const size_t stride     = num_nodes + 1;
+
+    std::vector<size_t> block_pos(num_blocks*stride, 0);
+
+    #pragma omp parallel for num_threads(omp) schedule(static, 1)
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        size_t* local = block_pos.data() + b*stride;
+
+        for (size_t s=b*num_spikes/num_blocks;
+             s < (b + 1)*num_spikes/num_blocks; s++)
+        {
+            local[pos[s]]++;
+        }
+    }
+
+    std::vector<size_t> offsets(stride + 1, 0);
+
+    size_t total = 0;
+
+    for (size_t n=0; n < stride; n++)
+    {
+        offsets[n] = total;
+
+        for (size_t b=0; b < num_blocks; b++)
+        {
+            size_t count = block_pos[b*stride + n];
+
+            block_pos[b*stride + n] = total;
+            total += count;
+        }
+    }
+
+    offsets[stride] = total;
+
+    std::vector<double> sorted(num_spikes);
+
+    #pragma omp parallel for num_threads(omp) schedule(static, 1)
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        size_t* local = block_pos.data() + b*stride;
+
+        for (size_t s=b*num_spikes/num_blocks;
+             s < (b + 1)*num_spikes/num_blocks; s++)
+        {
+            sorted[local[pos[s]]++] = times[s];
+        }
+    }
+
+    // update the statistics of each neuron
+    #pragma omp parallel for num_threads(omp) schedule(dynamic, 64)
+    for (size_t n=0; n < num_nodes; n++)
+    {
+        double* first = sorted.data() + offsets[n];
+        double* last  = sorted.data() + offsets[n + 1];
+
+        if (first == last)
+        {
+            continue;
+        }
+
+        if (not std::is_sorted(first, last))
+        {
+            std::sort(first, last);
+        }
+
+        double* st   = state + n*NUM_SPIKE_STATS;
+        double count = st[SPK_COUNT];
+
+        for (const double* t = first; t != last; t++)
+        {
+            if (count == 0)
+            {
+                st[SPK_FIRST] = *t;
+            }
+            else
+            {
+                const double isi = *t - st[SPK_LAST];
+
+                st[SPK_SUM_ISI] += isi;
+                st[SPK_SQ_ISI]  += isi*isi;
+
+                if (count >= 2)
+                {
+                    const double isi2 = isi + st[SPK_PREV_ISI];
+
+                    st[SPK_SUM_ISI2] += isi2;
+                    st[SPK_SQ_ISI2]  += isi2*isi2;
+                }
+
+                st[SPK_PREV_ISI] = isi;
+            }
+
+            st[SPK_LAST] = *t;
+            count++;
+        }
+
+        st[SPK_COUNT] = count;
+    }
+}
+
+
+void _bin_spikes(array_view<double> times, double start, double bin_size,
+                 size_t num_bins, int64_t* counts, unsigned int omp)
+{
+    if (num_bins == 0 || not (bin_size > 0))
+    {
+        throw std::invalid_argument("`num_bins` and `bin_size` must be "
+                                    "strictly positive.");
+    }
+
+    const size_t num_spikes = times.size();
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t s=0; s < num_spikes; s++)
+    {
+        const double x = std::floor((times[s] - start) / bin_size + 0.5);
+
+        if (std::isnan(x))
+        {
+            continue;
+        }
+
+        size_t bin = 0;
+
+        if (x >= num_bins - 1)
+        {
+            bin = num_bins - 1;
+        }
+        else if (x > 0)
+        {
+            bin = static_cast<size_t>(x);
+        }
+
+        #pragma omp atomic
+        counts[bin]++;
+    }
+}
+
+
+void _bayesian_blocks_events(array_view<double> block_length,
+                             array_view<double> cum_counts,
+                             array_view<double> prior, int64_t* last,
+                             unsigned int omp)
+{
+    const size_t num_cells = prior.size();
+
+    if (block_length.size() != num_cells + 1
+        || cum_counts.size() != num_cells + 1)
+    {
+        throw std::invalid_argument("`block_length` and `cum_counts` must "
+                                    "have one more entry than `prior`.");
+    }
+
+    // best fitness of the partitions ending at each cell
+    std::vector<double> best(num_cells);
+
+    const double ninf = -std::numeric_limits<double>::infinity();
+
+    // maximum over all threads, the first cell winning ties
+    double best_fit = ninf;
+    size_t best_idx = num_cells + 1;
+
+    if (num_cells < BLOCKS_PARALLEL)
+    {
+        omp = 1;
+    }
+
+    #pragma omp parallel num_threads(omp)
+    {
+        for (size_t r=0; r < num_cells; r++)
+        {
+            double local_fit = ninf;
+            size_t local_idx = r + 1;
+
+            #pragma omp for schedule(static) nowait
+            for (size_t i=0; i <= r; i++)
+            {
+                // fitness of a last block made of cells i to r (eq. 19)
+                const double n_k = cum_counts[r + 1] - cum_counts[i];
+                const double t_k = block_length[i] - block_length[r + 1];
+
+                double fit = n_k*(std::log(n_k) - std::log(t_k)) - prior[r];
+
+                if (i > 0)
+                {
+                    fit += best[i - 1];
+                }
+
+                if (fit > local_fit || local_idx > r)
+                {
+                    local_fit = fit;
+                    local_idx = i;
+                }
+            }
+
+            #pragma omp critical
+            {
+                if (local_idx <= r
+                    && (local_fit > best_fit
+                        || (local_fit == best_fit && local_idx < best_idx)
+                        || best_idx > r))
+                {
+                    best_fit = local_fit;
+                    best_idx = local_idx;
+                }
+            }
+
+            #pragma omp barrier
+
+            #pragma omp single
+            {
+                best[r]  = best_fit;
+                last[r]  = best_idx;
+                best_fit = ninf;
+                best_idx = num_cells + 1;
+            }
+        }
+    }
+}
+
+}
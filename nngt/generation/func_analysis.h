@@ -0,0 +1,169 @@
+// SPDX-FileCopyrightText: 2015-2023 Tanguy Fardet
+// SPDX-License-Identifier: GPL-3.0-or-later
+// nngt/generation/func_analysis.h
+//
+// Accelerated graph and activity analysis functions
+
+#ifndef FUNC_ANALYSIS_H
+#define FUNC_ANALYSIS_H
+
+#include "func_connect.h"
+
+
+namespace generation {
+
+/*
+ * Read-only view on a sparse matrix in CSR format with sorted column indices
+ * in each row (the arrays must outlive the view).
+ */
+class csr_view
+{
+  public:
+    csr_view() {}
+
+    csr_view(array_view<int64_t> indptr, array_view<int64_t> indices,
+             array_view<double> data)
+      : indptr(indptr), indices(indices), data(data) {}
+
+    size_t num_rows() const
+    {
+        return indptr.empty() ? 0 : indptr.size() - 1;
+    }
+
+    array_view<int64_t> indptr;
+    array_view<int64_t> indices;
+    array_view<double> data;
+};
+
+
+/*
+ * Intensity of the triangles of each node for a symmetric weight matrix,
+ * i.e. half of the diagonal of S^3, ignoring self-loops.
+ *
+ * Edges are oriented from low to high degree so that each triangle is
+ * found exactly once, by intersection of the sorted out-neighbours of its
+ * two lowest-degree nodes; its intensity (the product of its three weights)
+ * is then added to its three nodes, in an order which does not depend on
+ * the number of threads, so the results are reproducible.
+ *
+ * \param sym       - symmetric weight matrix
+ * \param strength  - array of size N, filled with the triangle intensities
+ * \param omp       - number of OpenMP threads
+ */
+void _triangle_strength(const csr_view& sym, double* strength,
+                        unsigned int omp);
+
+
+/*
+ * Diagonal of the product X Y Z for three N x N matrices, ignoring the
+ * diagonal entries of the matrices:
+ *
+ * out_i = sum_{j != i} X_ij sum_{k != i, j} Y_jk Z_ki
+ *
+ * The inner sum is computed by intersection of the sorted rows j of Y and i
+ * of Z^T, so the memory cost is limited to the inputs.
+ *
+ * \param x         - matrix X
+ * \param y         - matrix Y
+ * \param zt        - transpose of the matrix Z
+ * \param out       - array of size N, filled with the diagonal
+ * \param omp       - number of OpenMP threads
+ */
+void _diag_product(const csr_view& x, const csr_view& y, const csr_view& zt,
+                   double* out, unsigned int omp);
+
+
+/*
+ * Connected components of a graph given by its edges.
+ *
+ * Weak components are obtained by a parallel union-find, strong components
+ * by an iterative Tarjan algorithm over the CSR representation of the graph.
+ *
+ * \param edges     - linearized (E, 2) array of the edges
+ * \param num_nodes - number of nodes in the graph
+ * \param strong    - whether to compute the strongly connected components
+ *                    (true) or the weakly connected ones (false)
+ * \param labels    - array of size `num_nodes`, filled with the component of
+ *                    each node; components are sorted by decreasing size
+ *                    (ties by smallest node) so that 0 is the largest one
+ * \param omp       - number of OpenMP threads
+ *
+ * \return num_cc   - number of components
+ */
+size_t _components(array_view<int64_t> edges, size_t num_nodes, bool strong,
+                   int64_t* labels, unsigned int omp);
+
+
+/*
+ * Spike trains
+ */
+
+// columns of the per-neuron spike statistics (see _add_spikes)
+enum spike_stat
+{
+    SPK_COUNT, SPK_FIRST, SPK_LAST, SPK_PREV_ISI, SPK_SUM_ISI, SPK_SQ_ISI,
+    SPK_SUM_ISI2, SPK_SQ_ISI2, NUM_SPIKE_STATS
+};
+
+
+/*
+ * Add a chunk of spikes to the statistics of each neuron.
+ *
+ * Spikes are bucketed by neuron in parallel (keeping their order), then the
+ * statistics of each neuron are updated from its spikes in time order.
+ * Chunks must be added in chronological order.
+ *
+ * \param nodes     - sorted ids of the neurons to analyse (size N), spikes
+ *                    of other senders are ignored
+ * \param senders   - sender of each spike
+ * \param times     - time of each spike
+ * \param state     - linearized (N, NUM_SPIKE_STATS) array, with, for each
+ *                    neuron, the number of spikes, the time of the first and
+ *                    last spikes, the last inter-spike interval (ISI), and
+ *                    the sum and sum of squares of the ISIs and of the sums
+ *                    of two consecutive ISIs
+ * \param omp       - number of OpenMP threads
+ */
+void _add_spikes(array_view<int64_t> nodes, array_view<int64_t> senders,
+                 array_view<double> times, double* state, unsigned int omp);
+
+
+/*
+ * Count the spikes in regular bins, each spike going to the bin with the
+ * nearest center (ties going to the upper bin); spikes outside the range
+ * are counted in the first or last bin.
+ *
+ * \param times     - time of each spike
+ * \param start     - center of the first bin
+ * \param bin_size  - width of the bins
+ * \param num_bins  - number of bins
+ * \param counts    - array of size `num_bins` to which the counts are added
+ * \param omp       - number of OpenMP threads
+ */
+void _bin_spikes(array_view<double> times, double start, double bin_size,
+                 size_t num_bins, int64_t* counts, unsigned int omp);
+
+
+/*
+ * Optimal partition of Bayesian blocks for event data (Scargle et al.
+ * 2012), by dynamic programming: for each cell r, the best position of the
+ * last change point is searched over all cells i <= r in parallel.
+ *
+ * \param block_length - array of size N + 1, time from each cell edge to the
+ *                       end of the data
+ * \param cum_counts   - array of size N + 1, cumulated number of events
+ *                       before each cell
+ * \param prior        - array of size N, prior on the number of blocks when
+ *                       ending at each cell
+ * \param last         - array of size N, filled with the first cell of the
+ *                       last block ending at each cell
+ * \param omp          - number of OpenMP threads
+ */
+void _bayesian_blocks_events(array_view<double> block_length,
+                             array_view<double> cum_counts,
+                             array_view<double> prior, int64_t* last,
+                             unsigned int omp);
+
+}
+
+#endif // FUNC_ANALYSIS_H
@@ -13,6 +13,7 @@
 
 #define _USE_MATH_DEFINES
 #include <limits>
+#include <map>
 #include <random>
 #include <cmath>
 #include <numeric>  // partial_sum
@@ -47,44 +48,136 @@ size_t _unique_1d(std::vector<size_t>& a,
 }
 
 
-size_t _unique_2d(std::vector< std::vector<size_t> >& a, set_t& hash_set,
-                  set_t& recip_set, bool directed)
+/*
+* Flat edge set
+*/
+
+const uint64_t edge_set::empty_;
+
+
+edge_set::edge_set(size_t max_node, bool directed, size_t capacity)
+  : directed_(directed),
+    wide_(max_node >= std::numeric_limits<uint32_t>::max()),
+    stride_(wide_ ? 2 : 1), num_edges_(0), mask_(0)
+{
+    // start with 16 slots, the load factor is kept below 0.5
+    rehash(16);
+    reserve(capacity);
+}
+
+
+void edge_set::reserve(size_t num_edges)
+{
+    size_t new_capacity = capacity();
+
+    while (2*num_edges > new_capacity)
+    {
+        new_capacity *= 2;
+    }
+
+    if (new_capacity != capacity())
+    {
+        rehash(new_capacity);
+    }
+}
+
+
+void edge_set::clear()
+{
+    std::fill(keys_.begin(), keys_.end(), empty_);
+    num_edges_ = 0;
+}
+
+
+void edge_set::rehash(size_t new_capacity)
+{
+    std::vector<uint64_t> old_keys(stride_*new_capacity, empty_);
+    std::swap(keys_, old_keys);
+
+    mask_ = new_capacity - 1;
+
+    const size_t old_capacity = old_keys.size() / stride_;
+
+    for (size_t i=0; i < old_capacity; i++)
+    {
+        uint64_t k0 = old_keys[stride_*i];
+
+        if (k0 != empty_)
+        {
+            uint64_t k1 = wide_ ? old_keys[2*i + 1] : 0;
+
+            _store(_find(k0, k1), k0, k1);
+        }
+    }
+}
+
+
+bool edge_set::erase(size_t s, size_t t)
+{
+    uint64_t k0, k1;
+    _make_key(s, t, k0, k1);
+
+    size_t hole = _find(k0, k1);
+
+    if (_is_empty(hole))
+    {
+        return false;
+    }
+
+    // backward-shift deletion: move up the following entries of the probe
+    // sequence that would otherwise become unreachable
+    size_t slot = hole;
+
+    while (true)
+    {
+        slot = (slot + 1) & mask_;
+
+        if (_is_empty(slot))
+        {
+            break;
+        }
+
+        uint64_t j0 = keys_[stride_*slot];
+        uint64_t j1 = wide_ ? keys_[2*slot + 1] : 0;
+
+        size_t home = _home(j0, j1);
+
+        // keep the entry if its home lies cyclically in (hole, slot]
+        bool stays = hole <= slot ? (hole < home && home <= slot)
+                                  : (hole < home || home <= slot);
+
+        if (not stays)
+        {
+            _store(hole, j0, j1);
+            hole = slot;
+        }
+    }
+
+    keys_[stride_*hole] = empty_;
+    num_edges_--;
+
+    return true;
+}
+
+
+size_t _unique_2d(std::vector< std::vector<size_t> >& a, edge_set& hash_set)
 {
     size_t total_unique = hash_set.size();
     size_t num_edges = a[0].size();
     size_t s, t;
-    edge_t edge;
 
     for (size_t i = total_unique; i < num_edges; i++)
     {
         s = a[0][i];
         t = a[1][i];
 
-        edge = edge_t(s, t);
-
-        // check if this number is already in the set
-        if (hash_set.find(edge) == hash_set.end())
+        // add the edge if it is not already in the set
+        if (hash_set.insert(s, t))
         {
-            if (directed)
-            {
-                // it's not in there yet so add it and set the count to 1
-                hash_set.insert(edge);
-
-                a[0][total_unique] = s;
-                a[1][total_unique] = t;
-
-                total_unique += 1;
-            }
-            else if (recip_set.find(edge) == recip_set.end())
-            {
-                hash_set.insert(edge);
-                recip_set.insert(edge_t(t, s));
-
-                a[0][total_unique] = s;
-                a[1][total_unique] = t;
+            a[0][total_unique] = s;
+            a[1][total_unique] = t;
 
-                total_unique += 1;
-            }
+            total_unique += 1;
         }
     }
 
@@ -92,377 +185,2960 @@ size_t _unique_2d(std::vector< std::vector<size_t> >& a, set_t& hash_set,
 }
 
 
-size_t _unique_2d(std::vector< std::vector<size_t> >& a, set_t& hash_set,
-                  std::vector<float>& dist, const std::vector<float>& dist_tmp,
-                  set_t& recip_set, bool directed)
+size_t _unique_2d(std::vector< std::vector<size_t> >& a, edge_set& hash_set,
+                  std::vector<float>& dist, const std::vector<float>& dist_tmp)
 {
     size_t total_unique = hash_set.size();
     size_t num_edges = a[0].size();
     size_t initial_enum = total_unique;
     size_t s, t;
-    edge_t edge;
 
     for (size_t i = total_unique; i < num_edges; i++)
     {
         s = a[0][i];
         t = a[1][i];
 
-        edge = edge_t(s, t);
+        // add the edge if it is not already in the set
+        if (hash_set.insert(s, t))
+        {
+            a[0][total_unique] = s;
+            a[1][total_unique] = t;
+
+            dist.push_back(dist_tmp[i - initial_enum]);
+
+            total_unique += 1;
+        }
+    }
+
+    return total_unique;
+}
+
+
+bool _gen_edge_complement(
+  counter_rng& generator, array_view<size_t> nodes, size_t min_id,
+  size_t max_id, size_t other_end, unsigned int degree,
+  const size_t* old_begin, const size_t* old_end, bool multigraph,
+  std::vector<uint64_t>& marks, std::vector<size_t>& pool,
+  std::vector<size_t>& result)
+{
+    const size_t num_nodes = nodes.size();
+
+    result.clear();
+
+    size_t cplt;
+
+    if (multigraph)
+    {
+        // only self-loops are forbidden
+        if (degree > 0 && num_nodes == 1 && nodes[0] == other_end)
+        {
+            return false;
+        }
 
-        // check if this number is already in the set
-        if (hash_set.find(edge) == hash_set.end())
+        while (result.size() < degree)
         {
-            if (directed)
+            cplt = nodes[generator.uniform_int(num_nodes)];
+
+            if (cplt != other_end)
             {
-                // it's not in there yet so add it and set the count to 1
-                hash_set.insert(edge);
+                result.push_back(cplt);
+            }
+        }
+
+        return true;
+    }
+
+    // mark the nodes that cannot be drawn: other_end and its old neighbours
+    // (ids outside the drawn range can be ignored)
+    auto mark = [&marks, min_id, max_id](size_t n) -> bool
+    {
+        if (n < min_id || n > max_id)
+        {
+            return true;
+        }
 
-                a[0][total_unique] = s;
-                a[1][total_unique] = t;
+        size_t pos = n - min_id;
+        uint64_t bit = 1ULL << (pos & 63);
 
-                dist.push_back(dist_tmp[i - initial_enum]);
+        bool was_set = marks[pos >> 6] & bit;
 
-                total_unique += 1;
+        marks[pos >> 6] |= bit;
+
+        return was_set;
+    };
+
+    auto unmark = [&marks, min_id, max_id](size_t n)
+    {
+        if (n >= min_id && n <= max_id)
+        {
+            marks[(n - min_id) >> 6] = 0;
+        }
+    };
+
+    size_t num_excluded = not mark(other_end);
+
+    for (const size_t* it = old_begin; it < old_end; it++)
+    {
+        num_excluded += not mark(*it);
+    }
+
+    bool success = true;
+
+    if (2*(degree + num_excluded) <= num_nodes)
+    {
+        // sparse case: rejection sampling, at most half of the draws fail
+        while (result.size() < degree)
+        {
+            cplt = nodes[generator.uniform_int(num_nodes)];
+
+            if (not mark(cplt))
+            {
+                result.push_back(cplt);
             }
-            else if (recip_set.find(edge) == recip_set.end())
+        }
+    }
+    else
+    {
+        // dense case: partial Fisher-Yates shuffle of the allowed nodes
+        pool.clear();
+
+        for (size_t n : nodes)
+        {
+            size_t pos = n - min_id;
+
+            if (not (marks[pos >> 6] & (1ULL << (pos & 63))))
             {
-                hash_set.insert(edge);
-                recip_set.insert(edge_t(t, s));
+                pool.push_back(n);
+            }
+        }
 
-                a[0][total_unique] = s;
-                a[1][total_unique] = t;
+        const size_t num_draws = std::min(static_cast<size_t>(degree),
+                                          pool.size());
 
-                dist.push_back(dist_tmp[i - initial_enum]);
+        success = (num_draws == degree);
 
-                total_unique += 1;
-            }
+        for (size_t j=0; j < num_draws; j++)
+        {
+            size_t k = j + generator.uniform_int(pool.size() - j);
+
+            std::swap(pool[j], pool[k]);
+
+            result.push_back(pool[j]);
         }
     }
 
-    return total_unique;
+    // reset the bitmap (whole words, they only contain marked nodes)
+    unmark(other_end);
+
+    for (const size_t* it = old_begin; it < old_end; it++)
+    {
+        unmark(*it);
+    }
+
+    for (size_t n : result)
+    {
+        unmark(n);
+    }
+
+    return success;
 }
 
 
-std::vector<size_t> _gen_edge_complement(
-  std::mt19937& generator, const std::vector<size_t>& nodes, size_t other_end,
-  unsigned int degree,
-  const std::vector< std::vector<size_t> >* existing_edges,
-  bool multigraph, bool directed)
+/*
+ * Index the existing edges in CSR format: the old neighbours of node `n`
+ * (on the side of `first_nodes`, given by `idx`) are
+ * `neighbours[offsets[n]:offsets[n+1]]`.
+ * Only nodes up to the largest id in `first_nodes` are indexed.
+ */
+static void _old_neighbours(
+  array_view<int64_t> existing_edges,
+  array_view<size_t> first_nodes, unsigned int idx, bool directed,
+  std::vector<size_t>& offsets, std::vector<size_t>& neighbours)
 {
-    // Initialize the RNG
-    size_t min_idx = *std::min_element(nodes.begin(), nodes.end());
-    size_t max_idx = *std::max_element(nodes.begin(), nodes.end());
-    std::uniform_int_distribution<size_t> uniform_(min_idx, max_idx);
+    if (existing_edges.size() < 2 || first_nodes.empty())
+    {
+        return;
+    }
 
-    // generate the complements
-    std::vector<size_t> result;
-    size_t ecurrent = 0;
+    // linearized (E, 2) array, read in place through strided views
+    const int64_t* keys   = existing_edges.data() + idx;
+    const int64_t* others = existing_edges.data() + 1 - idx;
+    const size_t num_old  = existing_edges.size() / 2;
 
-    std::unordered_set<size_t> hash_set;
+    const size_t max_key = *std::max_element(first_nodes.begin(),
+                                             first_nodes.end());
 
-    // check the existing edges
-    const size_t num_old_edges = existing_edges ? existing_edges[0].size() : 0;
-    size_t node;
+    offsets.assign(max_key + 2, 0);
 
-    for (size_t i=0; i < num_old_edges; i++)
+    // count the neighbours of each node
+    for (size_t i=0; i < num_old; i++)
     {
-        if (existing_edges->at(0)[i] == other_end)
+        const size_t key = keys[2*i], other = others[2*i];
+
+        if (key <= max_key)
         {
-            node = existing_edges->at(1)[i];
+            offsets[key + 1]++;
+        }
 
-            result.push_back(node);
-            hash_set.insert(node);
+        // undirected edges are seen from both ends
+        if (not directed && other <= max_key)
+        {
+            offsets[other + 1]++;
         }
+    }
+
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    // fill them
+    neighbours.resize(offsets.back());
+
+    std::vector<size_t> pos(offsets.begin(), offsets.end() - 1);
+
+    for (size_t i=0; i < num_old; i++)
+    {
+        const size_t key = keys[2*i], other = others[2*i];
 
-        if (not directed and existing_edges->at(1)[i] == other_end)
+        if (key <= max_key)
         {
-            node = existing_edges->at(1)[i];
+            neighbours[pos[key]++] = other;
+        }
 
-            if (hash_set.find(node) == hash_set.end())
-            {
-                result.push_back(node);
-                hash_set.insert(node);
-            }
+        if (not directed && other <= max_key)
+        {
+            neighbours[pos[other]++] = key;
         }
     }
+}
+
+
+// approximate number of edges generated by a single task in _gen_edges
+static const size_t EDGE_TASK = 4096;
+
 
-    ecurrent = result.size();
-    result.resize(ecurrent + degree);
+/*
+ * Work unit of _gen_edge_block: nodes `start` to `stop` (excluded), or, for
+ * a multigraph hub (stop == start + 1), only its edges `first` to `last`
+ * (excluded), drawn from the `part`-th stream of the node.
+ */
+struct edge_task
+{
+    size_t start, stop;
+    size_t first, last;
+    uint64_t part;
+    size_t cost;
+};
+
+
+/*
+ * Split nodes `start` to `stop` (excluded) into tasks of about EDGE_TASK
+ * edges, hubs of multigraphs being split into several tasks.
+ * The split only depends on the degrees, so that the streams used by each
+ * node do not depend on the number of threads.
+ * Tasks are returned by decreasing cost, so the dynamic schedule can balance
+ * the load.
+ */
+static std::vector<edge_task> _edge_tasks(
+  size_t start, size_t stop, array_view<unsigned int> degrees,
+  bool multigraph)
+{
+    std::vector<edge_task> tasks;
 
-    size_t remaining = degree;
-    size_t cplt, j;
-    const size_t target_degree = ecurrent + degree;
+    size_t node = start;
 
-    while (ecurrent < target_degree)
+    while (node < stop)
     {
-        remaining = target_degree - ecurrent;
-        j = 0;
-        while (j < remaining)
+        if (multigraph && degrees[node] > EDGE_TASK)
         {
-            cplt = uniform_(generator);
-            if (cplt != other_end)
+            // split the hub
+            for (size_t first=0; first < degrees[node]; first += EDGE_TASK)
             {
-                result[ecurrent + j] = cplt;
-                j++;
+                size_t last = std::min(first + EDGE_TASK,
+                                       static_cast<size_t>(degrees[node]));
+
+                tasks.push_back({node, node + 1, first, last,
+                                 first / EDGE_TASK, last - first});
             }
+
+            node++;
+            continue;
         }
 
-        // update ecurrent and (potentially) the results
-        ecurrent = multigraph ? target_degree : _unique_1d(result, hash_set);
+        // group consecutive nodes (hubs of simple graphs stay alone since
+        // their edges must be checked for duplicates together)
+        size_t cost = 0, task_start = node;
+
+        do
+        {
+            cost += std::max(degrees[node], 1u);
+            node++;
+        } while (node < stop && cost < EDGE_TASK
+                 && not (multigraph && degrees[node] > EDGE_TASK));
+
+        tasks.push_back({task_start, node, 0, 0, 0, cost});
     }
 
-    return result;
+    std::stable_sort(tasks.begin(), tasks.end(),
+        [](const edge_task& a, const edge_task& b) { return a.cost > b.cost; });
+
+    return tasks;
 }
 
 
-void _gen_edges(
-  int64_t* ia_edges, const std::vector<size_t>& first_nodes,
-  const std::vector<unsigned int>& degrees,
-  const std::vector<size_t>& second_nodes,
-  const std::vector< std::vector<size_t> >& existing_edges, unsigned int idx,
-  bool multigraph, bool directed, std::vector<long>& seeds)
+/*
+ * Draw the `degree` neighbours of node `nid` among `second_nodes` (see
+ * _gen_edge_complement) and write the edges to `edges`, `nid` being at
+ * position `idx` of each edge.
+ * Return false if the node does not have enough possible neighbours.
+ */
+static bool _gen_node_edges(
+  int64_t* edges, size_t nid, unsigned int degree, long seed, uint64_t round,
+  array_view<size_t> second_nodes, size_t min_id, size_t max_id,
+  array_view<size_t> old_offsets, array_view<size_t> old_neighbours,
+  unsigned int idx, bool multigraph, std::vector<uint64_t>& marks,
+  std::vector<size_t>& pool, std::vector<size_t>& result)
 {
-    // compute the cumulated sum of the degrees
-    std::vector<size_t> cum_degrees(degrees.size());
-    std::partial_sum(degrees.begin(), degrees.end(), cum_degrees.begin());
+    // each node draws from its own stream(s) so that the edges do not depend
+    // on the number of threads or on the batches
+    counter_rng generator(seed, nid, round);
+
+    // old neighbours of the node (empty for multigraphs)
+    const size_t* old_begin = old_neighbours.data();
+    const size_t* old_end   = old_begin;
+
+    if (not multigraph && nid + 1 < old_offsets.size())
+    {
+        old_end    = old_begin + old_offsets[nid + 1];
+        old_begin += old_offsets[nid];
+    }
+
+    // generate the vector of complementary nodes
+    bool success = _gen_edge_complement(
+        generator, second_nodes, min_id, max_id, nid, degree, old_begin,
+        old_end, multigraph, marks, pool, result);
+
+    // fill the edges
+    for (size_t j = 0; j < result.size(); j++)
+    {
+        edges[2*j + idx]     = nid;
+        edges[2*j + 1 - idx] = result[j];
+    }
+
+    return success;
+}
+
+
+/*
+ * Generate the edges of nodes `start` to `stop` (excluded) from
+ * `first_nodes` into `ia_edges`, where `offset` is the index of the first
+ * edge of node `start`.
+ */
+static void _gen_edge_block(
+  int64_t* ia_edges, size_t start, size_t stop, size_t offset,
+  array_view<size_t> first_nodes,
+  array_view<unsigned int> degrees,
+  array_view<size_t> cum_degrees,
+  array_view<size_t> second_nodes,
+  array_view<size_t> old_offsets,
+  array_view<size_t> old_neighbours, unsigned int idx,
+  bool multigraph, long seed, unsigned int omp)
+{
+    // balance the load based on the degrees instead of the number of nodes
+    std::vector<edge_task> tasks = _edge_tasks(start, stop, degrees,
+                                               multigraph);
 
-    int omp = seeds.size();
+    const size_t num_tasks = tasks.size();
+
+    if (second_nodes.empty())
+    {
+        throw std::invalid_argument("No nodes to connect to.");
+    }
+
+    // range of the drawn ids
+    const size_t min_id = *std::min_element(second_nodes.begin(),
+                                            second_nodes.end());
+    const size_t max_id = *std::max_element(second_nodes.begin(),
+                                            second_nodes.end());
+
+    // set if a node does not have enough possible neighbours
+    bool too_few = false;
 
     // generate the edges
     #pragma omp parallel num_threads(omp)
     {
-        std::mt19937 generator_(seeds[omp_get_thread_num()]);
-        std::vector<size_t> res_tmp;
+        // thread-local buffers, reused from one node to the next
+        std::vector<size_t> res_tmp, pool;
+        // bitmap of the forbidden targets (simple graphs only)
+        std::vector<uint64_t> marks;
 
-        #pragma omp for schedule(static)
-        for (size_t node=0; node < first_nodes.size(); node++)
+        if (not multigraph)
         {
-            // generate the vector of complementary nodes
-            res_tmp = _gen_edge_complement(
-                generator_, second_nodes, node, degrees[node],
-                &existing_edges, multigraph, true);
+            marks.resize((max_id - min_id) / 64 + 1, 0);
+        }
 
-            // fill the edges
-            size_t idx_start = cum_degrees[node] - degrees[node];
+        #pragma omp for schedule(dynamic, 1)
+        for (size_t t=0; t < num_tasks; t++)
+        {
+            const edge_task& task = tasks[t];
+            const bool split = (task.last > 0);
 
-            for (unsigned int j = 0; j < degrees[node]; j++)
+            for (size_t node=task.start; node < task.stop; node++)
             {
-                ia_edges[2*(idx_start + j) + idx] = first_nodes[node];
-                ia_edges[2*(idx_start + j) + 1 - idx] = res_tmp[j];
+                unsigned int degree = split ?
+                    task.last - task.first : degrees[node];
+
+                size_t idx_start = cum_degrees[node] - degrees[node] - offset
+                                   + task.first;
+
+                if (not _gen_node_edges(
+                        ia_edges + 2*idx_start, first_nodes[node], degree,
+                        seed, task.part, second_nodes, min_id, max_id,
+                        old_offsets, old_neighbours, idx, multigraph, marks,
+                        pool, res_tmp))
+                {
+                    #pragma omp atomic write
+                    too_few = true;
+                }
             }
         }
     }
-}
 
+    if (too_few)
+    {
+        throw std::invalid_argument("Some nodes do not have enough possible "
+                                    "neighbours to reach the required "
+                                    "degree.");
+    }
+}
 
-/*
-* Distance-rule algorithms
-*/
 
-void _cdistance_rule(int64_t* ia_edges, const std::vector<size_t>& source_nodes,
-  const std::vector<std::vector<size_t>>& target_nodes,
-  const std::string& rule, float scale, float norm,
-  const std::vector<float>& x, const std::vector<float>& y, size_t num_neurons,
-  size_t num_edges, const std::vector< std::vector<size_t> >& existing_edges,
-  std::vector<float>& dist, bool multigraph, bool directed,
-  std::vector<long>& seeds)
+void _gen_edges(
+  int64_t* ia_edges, array_view<size_t> first_nodes,
+  array_view<unsigned int> degrees,
+  array_view<size_t> second_nodes,
+  array_view<int64_t> existing_edges, unsigned int idx,
+  bool multigraph, bool directed, long seed, unsigned int omp,
+  edge_sink sink, void* sink_data, size_t batch_size)
 {
-    float inv_scale = 1. / scale;
-    int num_omp = seeds.size();
+    // compute the cumulated sum of the degrees
+    std::vector<size_t> cum_degrees(degrees.size());
+    std::partial_sum(degrees.begin(), degrees.end(), cum_degrees.begin());
 
-    std::uniform_real_distribution<float> rnd_uniform(0., 1.);
+    const size_t num_nodes = first_nodes.size();
 
-    // rule into int
-    int rule_type = -1;
-    if (rule == "lin")
-    {
-        rule_type = 0;
-    }
-    else if (rule == "exp")
+    // index the existing edges once (shared by all threads)
+    std::vector<size_t> old_offsets, old_neighbours;
+
+    if (not multigraph)
     {
-        rule_type = 1;
+        _old_neighbours(existing_edges, first_nodes, idx, directed,
+                        old_offsets, old_neighbours);
     }
-    else if (rule == "gaussian")
+
+    if (sink == nullptr)
     {
-        rule_type = 2;
+        _gen_edge_block(ia_edges, 0, num_nodes, 0, first_nodes, degrees,
+                        cum_degrees, second_nodes, old_offsets,
+                        old_neighbours, idx, multigraph, seed, omp);
+        return;
     }
-    else
+
+    // streaming: generate blocks of nodes holding at most `batch_size` edges
+    // (or a single node if its degree is larger) and pass them to the sink
+    batch_size = std::max(batch_size, static_cast<size_t>(1));
+
+    std::vector<int64_t> buffer;
+    size_t start = 0, stop, offset, block_edges;
+
+    while (start < num_nodes)
     {
-        throw std::invalid_argument("`rule` must be among 'lin', 'exp', or "
-                                    "'gaussian'.");
+        offset = cum_degrees[start] - degrees[start];
+
+        stop = std::upper_bound(cum_degrees.begin() + start,
+                                cum_degrees.end(), offset + batch_size)
+               - cum_degrees.begin();
+        stop = std::max(stop, start + 1);
+
+        block_edges = cum_degrees[stop - 1] - offset;
+
+        buffer.resize(2*block_edges);
+
+        _gen_edge_block(buffer.data(), start, stop, offset, first_nodes,
+                        degrees, cum_degrees, second_nodes, old_offsets,
+                        old_neighbours, idx, multigraph, seed, omp);
+
+        if (block_edges > 0
+            && not sink(sink_data, buffer.data(), nullptr, block_edges))
+        {
+            return;
+        }
+
+        start = stop;
     }
+}
 
-    size_t initial_enum = existing_edges.empty() ?
-        0 : existing_edges[0].size();               // initial number of edges
-    size_t current_enum = initial_enum;             // current number of edges
-    size_t ecount_fill = 0;                         // tmp number of edges
-    size_t target_enum = current_enum + num_edges;  // target number of edges
-    dist.reserve(num_edges);
 
-    // set the number of tests associated to each node proportionnaly to its
-    // number of neighbours
-    size_t tot_neighbours = 0;
+void _gen_edges_batch(
+  int64_t* ia_edges, array_view<size_t> job_nodes,
+  array_view<size_t> first_nodes, array_view<unsigned int> degrees,
+  array_view<size_t> job_targets, array_view<size_t> second_nodes,
+  array_view<uint8_t> idx, array_view<int64_t> existing_edges,
+  bool multigraph, bool directed, long seed, unsigned int omp)
+{
+    const size_t num_jobs = idx.size();
 
-    for (size_t i=0; i < target_nodes.size(); i++)
+    if (job_nodes.size() != num_jobs + 1 || job_targets.size() != num_jobs + 1
+        || degrees.size() != first_nodes.size()
+        || job_nodes[num_jobs] != first_nodes.size()
+        || job_targets[num_jobs] != second_nodes.size())
     {
-        tot_neighbours += target_nodes[i].size();
+        throw std::invalid_argument("Inconsistent job descriptions.");
     }
-    double neigh_norm = 1. / tot_neighbours;
 
-    // if not using multigraph, assert that we have enough neighbours
-    if (tot_neighbours < target_enum)
+    // edges are stored job after job, in the order of the first nodes
+    std::vector<size_t> cum_degrees(degrees.size());
+    std::partial_sum(degrees.begin(), degrees.end(), cum_degrees.begin());
+
+    // split all jobs into tasks and index the existing edges once for each
+    // side (first nodes as sources or as targets)
+    struct job_task
     {
-        throw std::invalid_argument("Scale is too small: there are not enough "
-                                    "close neighbours to create the required "
-                                    "number of connections. Increase `scale` "
-                                    "or `neuron_density`.");
-    }
+        edge_task task;
+        size_t job;
+    };
 
-    // create the edges
-    if (num_edges > 0)
+    std::vector<job_task> tasks;
+    bool sides[2] = {false, false};
+
+    for (size_t j=0; j < num_jobs; j++)
     {
-        #pragma omp parallel num_threads(num_omp)
-        {
-            float distance, proba;
-            size_t src, tgt, local_tests, nln, rnd;
-            std::vector<size_t> local_tgts;
-            std::mt19937 generator_(seeds[omp_get_thread_num()]);
-            // thread local edges
-            set_t hash_set, recip_set;
-            size_t num_elocal = 0;
-            std::vector< std::vector<size_t> > local_edges(
-                2, std::vector<size_t>());
-            std::vector< std::vector<size_t> > elocal_tmp(
-                2, std::vector<size_t>());
-            std::vector< float > local_dist, dist_tmp;
-            do {
-                // reset edge number (recompute it each time)
-                #pragma omp single
-                {
-                    current_enum = initial_enum;
-                }
-                #pragma omp barrier
-                #pragma omp flush(current_enum)
+        if (job_nodes[j] == job_nodes[j + 1])
+        {
+            continue;
+        }
 
-                // the static schedule is CAPITAL: each thread must always
-                // handle the same nodes
-                #pragma omp for schedule(static)
-                for (size_t i=0; i<target_nodes.size(); i++)
-                {
-                    local_tgts = target_nodes[i];
-                    local_tests = target_nodes[i].size()
-                                  * (target_enum - current_enum) * neigh_norm;
-                    // test at least all neighbours
-                    local_tests = std::max(local_tests, local_tgts.size());
-                    elocal_tmp[0].reserve(local_tests);
-                    elocal_tmp[1].reserve(local_tests);
-                    dist_tmp.reserve(local_tests);
-                    // initialize source; set target generator
-                    src = source_nodes[i];
-                    nln = local_tgts.size();  // number of local neighbours
-                    std::uniform_int_distribution<size_t> rnd_target(
-                        0, nln - 1);
-
-                    for (size_t j=0; j<local_tests; j++)
-                    {
-                        tgt = src;
-                        while (tgt == src)
-                        {
-                            rnd = rnd_target(generator_);
-                            tgt = local_tgts[rnd];
-                        }
-                        distance = std::sqrt(
-                            (x[tgt] - x[src])*(x[tgt] - x[src]) +
-                            (y[tgt] - y[src])*(y[tgt] - y[src]));
-                        proba = _proba(rule_type, norm, inv_scale, distance);
-                        if (proba >= rnd_uniform(generator_))
-                        {
-                            elocal_tmp[0].push_back(src);
-                            elocal_tmp[1].push_back(tgt);
-                            dist_tmp.push_back(distance);
-                        }
-                    }
-                }
+        if (job_targets[j] == job_targets[j + 1])
+        {
+            throw std::invalid_argument("No nodes to connect to.");
+        }
 
-                local_edges[0].insert(local_edges[0].end(),
-                                      elocal_tmp[0].begin(),
-                                      elocal_tmp[0].end());
-                local_edges[1].insert(local_edges[1].end(),
-                                      elocal_tmp[1].begin(),
-                                      elocal_tmp[1].end());
-                num_elocal = multigraph
-                             ? local_edges[0].size()
-                             : _unique_2d(local_edges, hash_set,
-                                          local_dist, dist_tmp, recip_set);
+        if (idx[j] > 1)
+        {
+            throw std::invalid_argument("`idx` must be 0 or 1.");
+        }
 
-                local_edges[0].resize(num_elocal);
-                local_edges[1].resize(num_elocal);
+        sides[idx[j]] = true;
 
-                #pragma omp atomic
-                current_enum += num_elocal;
+        for (const edge_task& task : _edge_tasks(job_nodes[j],
+                                                 job_nodes[j + 1],
+                                                 degrees, multigraph))
+        {
+            tasks.push_back({task, j});
+        }
+    }
 
-                #pragma omp barrier              // ensure everyone is ready
-                #pragma omp flush(current_enum)  // and gets last value
-                #pragma omp barrier              // for sure
-            } while (current_enum < target_enum);
+    std::stable_sort(tasks.begin(), tasks.end(),
+        [](const job_task& a, const job_task& b)
+        { return a.task.cost > b.task.cost; });
 
-            // fill the edge container: first with the existing edges
-            #pragma omp single
+    const size_t num_tasks = tasks.size();
+
+    if (num_tasks == 0)
+    {
+        return;
+    }
+
+    std::vector<size_t> old_offsets[2], old_neighbours[2];
+
+    for (unsigned int side=0; side < 2; side++)
+    {
+        if (sides[side] && not multigraph)
+        {
+            _old_neighbours(existing_edges, first_nodes, side, directed,
+                            old_offsets[side], old_neighbours[side]);
+        }
+    }
+
+    // a single range of ids covers the second nodes of all jobs so that the
+    // thread-local bitmap is shared by all jobs
+    const size_t min_id = *std::min_element(second_nodes.begin(),
+                                            second_nodes.end());
+    const size_t max_id = *std::max_element(second_nodes.begin(),
+                                            second_nodes.end());
+
+    bool too_few = false;
+
+    #pragma omp parallel num_threads(omp)
+    {
+        std::vector<size_t> res_tmp, pool;
+        std::vector<uint64_t> marks;
+
+        if (not multigraph)
+        {
+            marks.resize((max_id - min_id) / 64 + 1, 0);
+        }
+
+        #pragma omp for schedule(dynamic, 1)
+        for (size_t t=0; t < num_tasks; t++)
+        {
+            const edge_task& task = tasks[t].task;
+            const size_t j        = tasks[t].job;
+            const bool split      = (task.last > 0);
+
+            array_view<size_t> targets(second_nodes.data() + job_targets[j],
+                                       job_targets[j + 1] - job_targets[j]);
+
+            // the job is part of the stream key so that a node present in
+            // several jobs draws independent neighbours (job 0 gives the
+            // same edges as _gen_edges)
+            uint64_t round = (static_cast<uint64_t>(j) << 32) + task.part;
+
+            for (size_t node=task.start; node < task.stop; node++)
+            {
+                unsigned int degree = split ?
+                    task.last - task.first : degrees[node];
+
+                size_t idx_start = cum_degrees[node] - degrees[node]
+                                   + task.first;
+
+                if (not _gen_node_edges(
+                        ia_edges + 2*idx_start, first_nodes[node], degree,
+                        seed, round, targets, min_id, max_id,
+                        old_offsets[idx[j]], old_neighbours[idx[j]], idx[j],
+                        multigraph, marks, pool, res_tmp))
+                {
+                    #pragma omp atomic write
+                    too_few = true;
+                }
+            }
+        }
+    }
+
+    if (too_few)
+    {
+        throw std::invalid_argument("Some nodes do not have enough possible "
+                                    "neighbours to reach the required "
+                                    "degree.");
+    }
+}
+
+
+/*
+* Edge insertion
+*/
+
+size_t _edge_status(
+  array_view<int64_t> edges, array_view<int64_t> existing_edges,
+  bool directed, bool loops, bool existing, uint8_t* status)
+{
+    const size_t num_edges = edges.size() / 2;
+    const size_t num_old   = existing ? existing_edges.size() / 2 : 0;
+
+    if (num_edges == 0)
+    {
+        return 0;
+    }
+
+    // the set must accept all node ids
+    int64_t max_node = *std::max_element(edges.begin(), edges.end());
+
+    if (num_old > 0)
+    {
+        max_node = std::max(max_node,
+                            *std::max_element(existing_edges.begin(),
+                                              existing_edges.end()));
+    }
+
+    edge_set known(max_node, directed, num_old + num_edges);
+
+    for (size_t i=0; i < num_old; i++)
+    {
+        known.insert(existing_edges[2*i], existing_edges[2*i + 1]);
+    }
+
+    // same order of the tests as the python version: known edges first,
+    // then self-loops, which are never added to the set
+    size_t num_valid = 0;
+
+    for (size_t i=0; i < num_edges; i++)
+    {
+        const size_t s = edges[2*i], t = edges[2*i + 1];
+
+        if (loops && s == t)
+        {
+            status[i] = known.contains(s, t) ? 1 : 2;
+        }
+        else
+        {
+            status[i] = known.insert(s, t) ? 0 : 1;
+        }
+
+        num_valid += (status[i] == 0);
+    }
+
+    return num_valid;
+}
+
+
+/*
+* Erdos-Renyi algorithms
+*/
+
+// number of rows per block in _gen_gnp, and of edges per stream in _gen_gnm
+static const size_t ER_BLOCK = 256;
+static const size_t ER_CHUNK = 4096;
+
+
+/*
+ * Number of possible targets of row `r` and id of its `c`-th target (see
+ * the `one_pop` and `directed` parameters of _gen_gnp).
+ */
+static inline size_t _er_row_size(size_t r, size_t num_targets, bool one_pop,
+                                  bool directed)
+{
+    if (not one_pop)
+    {
+        return num_targets;
+    }
+
+    return directed ? num_targets - 1 : num_targets - 1 - r;
+}
+
+
+static inline size_t _er_column(size_t r, size_t c, bool one_pop,
+                                bool directed)
+{
+    if (not one_pop)
+    {
+        return c;
+    }
+
+    return directed ? c + (c >= r) : r + 1 + c;
+}
+
+
+/*
+ * G(n, p) sampling of the rows into per-block edge buffers; `attempt` is
+ * used to derive new random streams when the function is called again with
+ * the same seed.
+ */
+static void _gnp_blocks(
+  std::vector< std::vector<int64_t> >& block_edges,
+  array_view<size_t> sources, array_view<size_t> targets,
+  double p, bool one_pop, bool directed, long seed, uint64_t attempt,
+  unsigned int omp)
+{
+    const size_t num_rows   = sources.size();
+    const size_t num_blocks = (num_rows + ER_BLOCK - 1) / ER_BLOCK;
+    const size_t num_tgts   = targets.size();
+
+    block_edges.assign(num_blocks, std::vector<int64_t>());
+
+    if (p <= 0. || num_tgts == 0)
+    {
+        return;
+    }
+
+    const double log_q = std::log1p(-std::min(p, 1.));
+
+    #pragma omp parallel for num_threads(omp) schedule(dynamic)
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        std::vector<int64_t>& local = block_edges[b];
+
+        size_t stop = std::min((b + 1)*ER_BLOCK, num_rows);
+
+        for (size_t r=b*ER_BLOCK; r < stop; r++)
+        {
+            size_t row_size = _er_row_size(r, num_tgts, one_pop, directed);
+
+            if (row_size == 0)
+            {
+                continue;
+            }
+
+            if (p >= 1.)
+            {
+                for (size_t c=0; c < row_size; c++)
+                {
+                    local.push_back(sources[r]);
+                    local.push_back(
+                        targets[_er_column(r, c, one_pop, directed)]);
+                }
+
+                continue;
+            }
+
+            counter_rng generator_(seed, r, attempt);
+
+            // skip a geometric number of non-edges before each edge
+            double pos = -1.;
+
+            while (true)
+            {
+                pos += 1. + std::floor(std::log(generator_.uniform_pos())
+                                       / log_q);
+
+                if (pos >= row_size)
+                {
+                    break;
+                }
+
+                size_t c = static_cast<size_t>(pos);
+
+                local.push_back(sources[r]);
+                local.push_back(targets[_er_column(r, c, one_pop, directed)]);
+            }
+        }
+    }
+}
+
+
+size_t _gen_gnp(
+  std::vector<int64_t>& edges, array_view<size_t> sources,
+  array_view<size_t> targets, double p, bool one_pop, bool directed,
+  long seed, unsigned int omp)
+{
+    std::vector< std::vector<int64_t> > block_edges;
+
+    _gnp_blocks(block_edges, sources, targets, p, one_pop, directed, seed, 0,
+                omp);
+
+    // concatenate the blocks
+    const size_t num_blocks = block_edges.size();
+
+    std::vector<size_t> offsets(num_blocks + 1, 0);
+
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        offsets[b + 1] = offsets[b] + block_edges[b].size();
+    }
+
+    edges.resize(offsets[num_blocks]);
+
+    #pragma omp parallel for num_threads(omp) schedule(dynamic)
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        std::copy(block_edges[b].begin(), block_edges[b].end(),
+                  edges.begin() + offsets[b]);
+    }
+
+    return offsets[num_blocks] / 2;
+}
+
+
+void _gen_gnm(
+  int64_t* ia_edges, array_view<size_t> sources,
+  array_view<size_t> targets, size_t num_edges, bool one_pop,
+  bool directed, bool multigraph, long seed, unsigned int omp)
+{
+    const size_t num_rows = sources.size();
+    const size_t num_tgts = targets.size();
+
+    // number of possible edges
+    double num_pairs = 0.;
+
+    for (size_t r=0; r < num_rows; r++)
+    {
+        num_pairs += _er_row_size(r, num_tgts, one_pop, directed);
+    }
+
+    if (num_edges == 0)
+    {
+        return;
+    }
+
+    if (num_pairs == 0. || (not multigraph && num_edges > num_pairs))
+    {
+        throw std::invalid_argument("Required number of edges is too high.");
+    }
+
+    if (multigraph)
+    {
+        // draw the edges by chunks, each with its own stream
+        const size_t num_chunks = (num_edges + ER_CHUNK - 1) / ER_CHUNK;
+        const size_t row_size = one_pop ? num_tgts - 1 : num_tgts;
+
+        #pragma omp parallel for num_threads(omp) schedule(static)
+        for (size_t k=0; k < num_chunks; k++)
+        {
+            counter_rng generator_(seed, k);
+
+            size_t stop = std::min((k + 1)*ER_CHUNK, num_edges);
+
+            for (size_t e=k*ER_CHUNK; e < stop; e++)
+            {
+                size_t r = generator_.uniform_int(num_rows);
+                size_t c = generator_.uniform_int(row_size);
+
+                // undirected edges can be drawn from both ends
+                ia_edges[2*e]     = sources[r];
+                ia_edges[2*e + 1] = targets[_er_column(r, c, one_pop, true)];
+            }
+        }
+
+        return;
+    }
+
+    // generate a G(n, p) graph with a few more edges than required (six
+    // standard deviations) and retry with a higher probability if needed
+    double p = std::min(
+        1., (num_edges + 6.*std::sqrt(num_edges) + 10.) / num_pairs);
+
+    std::vector< std::vector<int64_t> > block_edges;
+    size_t num_generated = 0;
+    uint64_t attempt = 0;
+
+    while (num_generated < num_edges)
+    {
+        _gnp_blocks(block_edges, sources, targets, p, one_pop, directed, seed,
+                    attempt, omp);
+
+        num_generated = 0;
+
+        for (const auto& local : block_edges)
+        {
+            num_generated += local.size() / 2;
+        }
+
+        p = std::min(1., 1.1*p);
+        attempt++;
+    }
+
+    // remove random extra edges (Floyd's algorithm)
+    const size_t num_remove = num_generated - num_edges;
+
+    std::unordered_set<size_t> removed;
+    counter_rng generator_(seed, std::numeric_limits<uint64_t>::max(),
+                           attempt);
+
+    for (size_t j=num_generated - num_remove; j < num_generated; j++)
+    {
+        size_t t = generator_.uniform_int(j + 1);
+
+        if (not removed.insert(t).second)
+        {
+            removed.insert(j);
+        }
+    }
+
+    std::vector<size_t> sorted_removed(removed.begin(), removed.end());
+    std::sort(sorted_removed.begin(), sorted_removed.end());
+
+    // offset of each block in the output
+    const size_t num_blocks = block_edges.size();
+
+    std::vector<size_t> first(num_blocks + 1, 0), offsets(num_blocks + 1, 0);
+
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        first[b + 1] = first[b] + block_edges[b].size() / 2;
+
+        size_t num_removed =
+            std::lower_bound(sorted_removed.begin(), sorted_removed.end(),
+                             first[b + 1])
+            - std::lower_bound(sorted_removed.begin(), sorted_removed.end(),
+                               first[b]);
+
+        offsets[b + 1] = offsets[b] + (first[b + 1] - first[b]) - num_removed;
+    }
+
+    #pragma omp parallel for num_threads(omp) schedule(dynamic)
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        const std::vector<int64_t>& local = block_edges[b];
+
+        auto it = std::lower_bound(sorted_removed.begin(),
+                                   sorted_removed.end(), first[b]);
+
+        size_t out = offsets[b];
+
+        for (size_t e=0; e < local.size() / 2; e++)
+        {
+            if (it != sorted_removed.end() && *it == first[b] + e)
+            {
+                it++;
+                continue;
+            }
+
+            ia_edges[2*out]     = local[2*e];
+            ia_edges[2*out + 1] = local[2*e + 1];
+            out++;
+        }
+    }
+}
+
+
+/*
+* Degree sequence (configuration model)
+*/
+
+bool _is_graphical(array_view<size_t> degrees, unsigned int omp)
+{
+    const size_t n = degrees.size();
+
+    size_t total = 0;
+
+    // counting sort of the degrees (in decreasing order)
+    std::vector<size_t> counts(n + 1, 0);
+
+    for (size_t d : degrees)
+    {
+        if (d >= n)
+        {
+            return false;
+        }
+
+        counts[d]++;
+        total += d;
+    }
+
+    if (total % 2)
+    {
+        return false;
+    }
+
+    // at_least[k]: number of nodes with degree >= k
+    std::vector<size_t> at_least(n + 2, 0);
+
+    for (size_t k = n + 1; k > 0; k--)
+    {
+        at_least[k - 1] = at_least[k] + counts[k - 1];
+    }
+
+    // prefix sums of the sorted degrees
+    std::vector<size_t> psum(n + 1, 0);
+    size_t pos = 0;
+
+    for (size_t d = n; d > 0; d--)
+    {
+        for (size_t j=0; j < counts[d - 1]; j++)
+        {
+            psum[pos + 1] = psum[pos] + d - 1;
+            pos++;
+        }
+    }
+
+    // Erdos-Gallai inequalities: sum_{i <= k} d_i must be smaller than
+    // k(k - 1) + sum_{i > k} min(d_i, k); the nodes i > k with d_i >= k are
+    // the ranks in (k, max(k, at_least[k])]
+    bool graphical = true;
+
+    #pragma omp parallel for num_threads(omp) schedule(static) \
+      reduction(&&:graphical)
+    for (size_t k=1; k <= n; k++)
+    {
+        size_t m   = std::max(k, at_least[k]);
+        size_t rhs = k*(k - 1) + k*(m - k) + psum[n] - psum[m];
+
+        graphical = graphical && psum[k] <= rhs;
+    }
+
+    return graphical;
+}
+
+
+/*
+ * Try to rewire the edge `e` so that it absorbs the stubs of `u` and `v`:
+ * (x, y) becomes (u, x) and (v, y) is added (or (u, y) and (v, x)).
+ */
+static bool _absorb_stubs(
+  counter_rng& rng, size_t u, size_t v, size_t e, std::vector<size_t>& src,
+  std::vector<size_t>& tgt, edge_set& hash, bool directed, bool multigraph)
+{
+    size_t x = src[e], y = tgt[e];
+
+    if (rng.uniform_int(2))
+    {
+        std::swap(x, y);
+    }
+
+    if (u == x || v == y)
+    {
+        return false;
+    }
+
+    size_t s0 = u, t0 = x, s1 = v, t1 = y;
+
+    if (directed)
+    {
+        if (rng.uniform_int(2)) { std::swap(s0, t0); }
+        if (rng.uniform_int(2)) { std::swap(s1, t1); }
+    }
+
+    if (not multigraph)
+    {
+        if (not hash.insert(s0, t0))
+        {
+            return false;
+        }
+
+        if (not hash.insert(s1, t1))
+        {
+            hash.erase(s0, t0);
+            return false;
+        }
+
+        hash.erase(src[e], tgt[e]);
+    }
+
+    src[e] = s0;
+    tgt[e] = t0;
+
+    src.push_back(s1);
+    tgt.push_back(t1);
+
+    return true;
+}
+
+
+/*
+ * Degree-preserving swap of two random edges: (a, b), (c, d) become
+ * (a, d), (c, b).
+ */
+static void _swap_edges(
+  counter_rng& rng, std::vector<size_t>& src, std::vector<size_t>& tgt,
+  edge_set& hash, bool multigraph)
+{
+    size_t e0 = rng.uniform_int(src.size());
+    size_t e1 = rng.uniform_int(src.size());
+
+    size_t a = src[e0], b = tgt[e0], c = src[e1], d = tgt[e1];
+
+    if (rng.uniform_int(2))
+    {
+        std::swap(c, d);
+    }
+
+    if (e0 == e1 || a == d || c == b)
+    {
+        return;
+    }
+
+    if (not multigraph)
+    {
+        if (not hash.insert(a, d))
+        {
+            return;
+        }
+
+        if (not hash.insert(c, b))
+        {
+            hash.erase(a, d);
+            return;
+        }
+
+        hash.erase(src[e0], tgt[e0]);
+        hash.erase(src[e1], tgt[e1]);
+    }
+
+    src[e0] = a;
+    tgt[e0] = d;
+    src[e1] = c;
+    tgt[e1] = b;
+}
+
+
+void _gen_degree_sequence(
+  int64_t* ia_edges, array_view<size_t> nodes,
+  array_view<size_t> degrees, bool directed, bool multigraph,
+  size_t max_rounds, long seed, unsigned int omp)
+{
+    const size_t num_nodes = nodes.size();
+
+    size_t total = 0;
+    size_t max_degree = 0;
+
+    for (size_t d : degrees)
+    {
+        total     += d;
+        max_degree = std::max(max_degree, d);
+    }
+
+    if (total % 2)
+    {
+        throw std::invalid_argument("The sum of the degrees must be even.");
+    }
+
+    const size_t num_edges = total / 2;
+
+    if (multigraph)
+    {
+        // only self-loops are forbidden
+        if (max_degree > total - max_degree)
+        {
+            throw std::invalid_argument(
+                "The degree sequence provided cannot be realized without "
+                "self-loops.");
+        }
+    }
+    else if (not _is_graphical(degrees, omp))
+    {
+        throw std::invalid_argument("The degree sequence provided is not "
+                                    "graphical and cannot be realized.");
+    }
+
+    // one stub per edge end
+    std::vector<size_t> stubs, leftover;
+    stubs.reserve(total);
+
+    for (size_t i=0; i < num_nodes; i++)
+    {
+        stubs.insert(stubs.end(), degrees[i], i);
+    }
+
+    std::vector<size_t> src, tgt;
+    src.reserve(num_edges);
+    tgt.reserve(num_edges);
+
+    edge_set hash(num_nodes, directed, multigraph ? 0 : num_edges);
+
+    size_t round = 0, stalls = 0;
+
+    while (not stubs.empty())
+    {
+        if (max_rounds && round >= max_rounds)
+        {
+            throw std::runtime_error("Graph generation did not converge.");
+        }
+
+        counter_rng rng(seed, 0, round);
+
+        // match the stubs randomly (this also orients the directed edges)
+        _shuffle(rng, stubs.size(), stubs.data());
+
+        leftover.clear();
+
+        for (size_t i=0; i < stubs.size(); i += 2)
+        {
+            size_t s = stubs[i], t = stubs[i + 1];
+
+            if (s != t && (multigraph || hash.insert(s, t)))
+            {
+                src.push_back(s);
+                tgt.push_back(t);
+            }
+            else
+            {
+                leftover.push_back(s);
+                leftover.push_back(t);
+            }
+        }
+
+        // when random matching stalls, rewire existing edges to absorb the
+        // remaining stubs, trying more and more edges if it keeps failing
+        if (2*leftover.size() > stubs.size() && not src.empty())
+        {
+            size_t effort = std::min<size_t>(
+                src.size(), 1ul << std::min<size_t>(stalls, 20));
+
+            stubs.clear();
+
+            for (size_t i=0; i < leftover.size(); i += 2)
+            {
+                bool absorbed = false;
+
+                for (size_t j=0; j < effort && not absorbed; j++)
+                {
+                    size_t e = rng.uniform_int(src.size());
+
+                    absorbed = _absorb_stubs(
+                        rng, leftover[i], leftover[i + 1], e, src, tgt, hash,
+                        directed, multigraph);
+                }
+
+                if (not absorbed)
+                {
+                    stubs.push_back(leftover[i]);
+                    stubs.push_back(leftover[i + 1]);
+                }
+            }
+
+            // the current edges cannot absorb the stubs: randomize them
+            if (stubs.size() == leftover.size())
+            {
+                for (size_t i=0; i < effort; i++)
+                {
+                    _swap_edges(rng, src, tgt, hash, multigraph);
+                }
+
+                stalls++;
+            }
+            else
+            {
+                stalls = 0;
+            }
+        }
+        else
+        {
+            std::swap(stubs, leftover);
+        }
+
+        round++;
+    }
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t e=0; e < num_edges; e++)
+    {
+        ia_edges[2*e]     = nodes[src[e]];
+        ia_edges[2*e + 1] = nodes[tgt[e]];
+    }
+}
+
+
+/*
+* Small-world algorithms
+*/
+
+// number of edges per random stream in the small-world generators
+static const size_t SW_BLOCK = 4096;
+// maximum number of shortcut rounds (as MAXTESTS in the python algorithms)
+static const uint64_t SW_MAX_ROUNDS = 1000;
+
+
+size_t _circular_edge_nb(size_t num_nodes, unsigned int coord_nb,
+                         double reciprocity, bool directed)
+{
+    const size_t dist = coord_nb / 2;
+
+    if (not directed)
+    {
+        return num_nodes*dist;
+    }
+
+    if (reciprocity >= 1.)
+    {
+        return num_nodes*coord_nb;
+    }
+
+    // same rounding as numpy (half to even)
+    return static_cast<size_t>(std::nearbyint(
+        0.5*num_nodes*coord_nb*(1. + reciprocity / (2. - reciprocity))));
+}
+
+
+/*
+ * Ring lattice between node positions (ids are set afterwards): edge
+ * j*N + i goes from i to the j-th neighbour of i, so edges are sorted by
+ * distance.
+ */
+static void _ring(size_t* sources, size_t* targets, size_t num_nodes,
+                  unsigned int coord_nb, bool directed, unsigned int omp)
+{
+    const size_t dist    = coord_nb / 2;
+    const size_t out_deg = directed ? coord_nb : dist;
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t j=0; j < out_deg; j++)
+    {
+        // neighbours -dist, ..., -1, 1, ..., dist if directed, else 1..dist
+        size_t step = (directed && j < dist) ? num_nodes - dist + j
+                                              : j - (directed ? dist : 0) + 1;
+
+        for (size_t i=0; i < num_nodes; i++)
+        {
+            size_t t = i + step;
+
+            sources[j*num_nodes + i] = i;
+            targets[j*num_nodes + i] = t >= num_nodes ? t - num_nodes : t;
+        }
+    }
+}
+
+
+/*
+ * Circular graph in node positions, see _gen_circular.
+ */
+static void _circular_positions(
+  std::vector<size_t>& sources, std::vector<size_t>& targets,
+  size_t num_nodes, unsigned int coord_nb, double reciprocity,
+  bool closest, bool directed, long seed, unsigned int omp)
+{
+    const size_t num_edges = _circular_edge_nb(num_nodes, coord_nb,
+                                               reciprocity, directed);
+
+    sources.resize(num_edges);
+    targets.resize(num_edges);
+
+    if (not directed || reciprocity >= 1.)
+    {
+        _ring(sources.data(), targets.data(), num_nodes, coord_nb, directed,
+              omp);
+
+        return;
+    }
+
+    // undirected ring with random orientations
+    const size_t num_init = num_nodes*(coord_nb / 2);
+
+    _ring(sources.data(), targets.data(), num_nodes, coord_nb, false, omp);
+
+    const size_t num_blocks = (num_init + SW_BLOCK - 1) / SW_BLOCK;
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        counter_rng rng(seed, b, 0);
+
+        size_t stop = std::min(num_init, (b + 1)*SW_BLOCK);
+
+        for (size_t e=b*SW_BLOCK; e < stop; e++)
+        {
+            if (rng.uniform_int(2))
+            {
+                std::swap(sources[e], targets[e]);
+            }
+        }
+    }
+
+    // reciprocal edges
+    const size_t num_recip = num_edges - num_init;
+
+    if (num_recip == 0)
+    {
+        return;
+    }
+
+    counter_rng rng(seed, 0, 1);
+
+    // edges that get a reciprocal connection: with "closest", we take all
+    // the shortest ones, then pick the remaining ones randomly among the
+    // edges of the next distance
+    size_t first = closest ? num_recip - num_recip % num_nodes : 0;
+    size_t stop  = closest ? std::min(first + num_nodes, num_init) : num_init;
+
+    std::vector<size_t> pool(stop - first);
+    std::iota(pool.begin(), pool.end(), first);
+
+    for (size_t k=0; k < num_recip - first; k++)
+    {
+        std::swap(pool[k], pool[k + rng.uniform_int(pool.size() - k)]);
+    }
+
+    for (size_t k=0; k < num_recip; k++)
+    {
+        size_t e = k < first ? k : pool[k - first];
+
+        sources[num_init + k] = targets[e];
+        targets[num_init + k] = sources[e];
+    }
+}
+
+
+static inline void _to_ids(int64_t* ia_edges, array_view<size_t> nodes,
+                           array_view<size_t> sources,
+                           array_view<size_t> targets,
+                           unsigned int omp)
+{
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t e=0; e < sources.size(); e++)
+    {
+        ia_edges[2*e]     = nodes[sources[e]];
+        ia_edges[2*e + 1] = nodes[targets[e]];
+    }
+}
+
+
+void _gen_circular(
+  int64_t* ia_edges, array_view<size_t> nodes, unsigned int coord_nb,
+  double reciprocity, bool closest, bool directed, long seed,
+  unsigned int omp)
+{
+    std::vector<size_t> sources, targets;
+
+    _circular_positions(sources, targets, nodes.size(), coord_nb, reciprocity,
+                        closest, directed, seed, omp);
+
+    _to_ids(ia_edges, nodes, sources, targets, omp);
+}
+
+
+void _gen_newman_watts(
+  int64_t* ia_edges, array_view<size_t> nodes, unsigned int coord_nb,
+  double reciprocity, bool closest, size_t num_edges, bool directed,
+  bool multigraph, long seed, unsigned int omp)
+{
+    const size_t num_nodes = nodes.size();
+
+    std::vector<size_t> sources, targets;
+
+    _circular_positions(sources, targets, num_nodes, coord_nb, reciprocity,
+                        closest, directed, seed, omp);
+
+    if (num_edges < sources.size())
+    {
+        throw std::invalid_argument(
+            "`num_edges` is smaller than the number of edges of the "
+            "circular graph.");
+    }
+
+    // duplicates are only checked if not using multigraph
+    edge_set hash(num_nodes, directed, multigraph ? 0 : num_edges);
+
+    for (size_t e=0; e < sources.size() && not multigraph; e++)
+    {
+        hash.insert(sources[e], targets[e]);
+    }
+
+    // shortcuts: random pairs drawn by blocks, then filtered in block order
+    std::vector< std::vector<size_t> > candidates;
+    uint64_t round = 0;
+
+    while (sources.size() < num_edges)
+    {
+        if (round == SW_MAX_ROUNDS)
+        {
+            throw std::runtime_error("Algorithm did not converge.");
+        }
+
+        const size_t todo       = num_edges - sources.size();
+        const size_t num_blocks = (todo + SW_BLOCK - 1) / SW_BLOCK;
+
+        candidates.assign(num_blocks, std::vector<size_t>());
+
+        #pragma omp parallel for num_threads(omp) schedule(static)
+        for (size_t b=0; b < num_blocks; b++)
+        {
+            counter_rng rng(seed, b, SW_MAX_ROUNDS + round);
+
+            size_t size = std::min(todo - b*SW_BLOCK, SW_BLOCK);
+
+            candidates[b].resize(2*size);
+
+            for (size_t k=0; k < 2*size; k++)
+            {
+                candidates[b][k] = rng.uniform_int(num_nodes);
+            }
+        }
+
+        for (const auto& block : candidates)
+        {
+            for (size_t k=0; k < block.size(); k += 2)
+            {
+                size_t s = block[k], t = block[k + 1];
+
+                if (s != t && (multigraph || hash.insert(s, t)))
+                {
+                    sources.push_back(s);
+                    targets.push_back(t);
+                }
+            }
+        }
+
+        round++;
+    }
+
+    _to_ids(ia_edges, nodes, sources, targets, omp);
+}
+
+
+void _gen_watts_strogatz(
+  int64_t* ia_edges, array_view<size_t> nodes, unsigned int coord_nb,
+  double proba, double reciprocity, bool closest, int shuffle, bool directed,
+  long seed, unsigned int omp)
+{
+    const size_t num_nodes = nodes.size();
+
+    std::vector<size_t> sources, targets;
+
+    _circular_positions(sources, targets, num_nodes, coord_nb, reciprocity,
+                        closest, directed, seed, omp);
+
+    const size_t num_edges  = sources.size();
+    const size_t num_blocks = (num_edges + SW_BLOCK - 1) / SW_BLOCK;
+
+    // select the edges to rewire and which end is kept (0 for the source)
+    std::vector< std::vector<size_t> > rewired(num_blocks);
+
+    #pragma omp parallel for num_threads(omp) schedule(static)
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        counter_rng rng(seed, b, 3);
+
+        size_t stop = std::min(num_edges, (b + 1)*SW_BLOCK);
+
+        for (size_t e=b*SW_BLOCK; e < stop; e++)
+        {
+            if (rng.uniform() < proba)
+            {
+                size_t keep = shuffle < 0 ? rng.uniform_int(2) : shuffle;
+
+                rewired[b].push_back(2*e + keep);
+            }
+        }
+    }
+
+    edge_set hash(num_nodes, directed, num_edges);
+
+    for (size_t e=0; e < num_edges; e++)
+    {
+        hash.insert(sources[e], targets[e]);
+    }
+
+    // rewire sequentially, each edge drawing from its own stream
+    const size_t max_tests = 50*num_nodes;
+
+    for (const auto& block : rewired)
+    {
+        for (size_t code : block)
+        {
+            size_t e    = code / 2;
+            bool   keep = code % 2;
+
+            counter_rng rng(seed, e, 4);
+
+            size_t s = keep ? targets[e] : sources[e];
+            size_t new_s = s, new_t = s;
+
+            for (size_t n=0; new_s == new_t || hash.contains(new_s, new_t);
+                 n++)
+            {
+                if (n == max_tests)
+                {
+                    throw std::runtime_error("Algorithm did not converge.");
+                }
+
+                size_t t = rng.uniform_int(num_nodes);
+
+                new_s = keep ? t : s;
+                new_t = keep ? s : t;
+            }
+
+            hash.erase(sources[e], targets[e]);
+            hash.insert(new_s, new_t);
+
+            sources[e] = new_s;
+            targets[e] = new_t;
+        }
+    }
+
+    _to_ids(ia_edges, nodes, sources, targets, omp);
+}
+
+
+/*
+* Degree-preserving rewiring
+*/
+
+// maximum number of swaps proposed per batch
+static const size_t SWAP_BATCH = 4096;
+
+
+/*
+ * Swap proposal: edges e0 = (a, b) and e1 = (c, d) become (a, d) and (c, b)
+ * (or (a, c) and (b, d) if `flip` is true, for undirected graphs only).
+ */
+struct swap_proposal
+{
+    size_t e0;
+    size_t e1;
+    bool flip;
+    bool valid;
+};
+
+
+static inline void _swap_ends(const int64_t* ia_edges, const swap_proposal& p,
+                              int64_t& a, int64_t& d, int64_t& c, int64_t& b)
+{
+    a = ia_edges[2*p.e0];
+    b = ia_edges[2*p.e0 + 1];
+    c = ia_edges[2*p.e1];
+    d = ia_edges[2*p.e1 + 1];
+
+    if (p.flip)
+    {
+        std::swap(c, d);
+    }
+}
+
+
+size_t _gen_edge_swaps(
+  int64_t* ia_edges, size_t num_edges, size_t num_nodes, size_t num_swaps,
+  bool directed, const int64_t* groups, long seed, unsigned int omp)
+{
+    if (num_edges < 2)
+    {
+        return 0;
+    }
+
+    edge_set hash(num_nodes, directed, num_edges);
+
+    for (size_t e=0; e < num_edges; e++)
+    {
+        hash.insert(ia_edges[2*e], ia_edges[2*e + 1]);
+    }
+
+    // batches are small compared to the number of edges so that most
+    // proposals of a batch touch different edges
+    const size_t batch_size = std::max<size_t>(
+        1, std::min(SWAP_BATCH, num_edges / 16));
+
+    std::vector<swap_proposal> proposals(batch_size);
+
+    // last batch in which each edge was swapped
+    std::vector<size_t> touched(num_edges, 0);
+
+    size_t accepted = 0;
+
+    for (size_t first=0; first < num_swaps; first += batch_size)
+    {
+        const size_t batch = first / batch_size + 1;
+        const size_t size  = std::min(batch_size, num_swaps - first);
+
+        // draw the proposals and test them against the current edges
+        #pragma omp parallel for num_threads(omp) schedule(static)
+        for (size_t k=0; k < size; k++)
+        {
+            counter_rng rng(seed, first + k);
+
+            swap_proposal& p = proposals[k];
+
+            p.e0   = rng.uniform_int(num_edges);
+            p.e1   = rng.uniform_int(num_edges);
+            p.flip = not directed && rng.uniform_int(2);
+
+            int64_t a, b, c, d;
+            _swap_ends(ia_edges, p, a, d, c, b);
+
+            p.valid = p.e0 != p.e1 && a != d && c != b
+                      && (groups == nullptr || groups[b] == groups[d])
+                      && not hash.contains(a, d) && not hash.contains(c, b);
+        }
+
+        // apply them in order, skipping those that conflict with a previous
+        // swap of the batch
+        for (size_t k=0; k < size; k++)
+        {
+            const swap_proposal& p = proposals[k];
+
+            if (not p.valid || touched[p.e0] == batch
+                || touched[p.e1] == batch)
+            {
+                continue;
+            }
+
+            int64_t a, b, c, d;
+            _swap_ends(ia_edges, p, a, d, c, b);
+
+            // new edges may have been created earlier in the batch
+            if (hash.contains(a, d) || hash.contains(c, b))
+            {
+                continue;
+            }
+
+            hash.erase(a, b);
+            hash.erase(c, d);
+            hash.insert(a, d);
+            hash.insert(c, b);
+
+            ia_edges[2*p.e0]     = a;
+            ia_edges[2*p.e0 + 1] = d;
+            ia_edges[2*p.e1]     = c;
+            ia_edges[2*p.e1 + 1] = b;
+
+            touched[p.e0] = batch;
+            touched[p.e1] = batch;
+
+            accepted++;
+        }
+    }
+
+    return accepted;
+}
+
+
+/*
+* Preferential attachment
+*/
+
+/*
+ * Fenwick tree storing positive weights, from which indices can be drawn
+ * proportionally to their weight in O(log n).
+ */
+class weight_tree
+{
+  public:
+    weight_tree(size_t size) : tree_(size + 1, 0.), weights_(size, 0.)
+    {
+        top_ = 1;
+
+        while (2*top_ <= size)
+        {
+            top_ *= 2;
+        }
+    }
+
+    //! Set the weight of element `i`.
+    void set(size_t i, double w)
+    {
+        double delta = w - weights_[i];
+
+        weights_[i] = w;
+
+        for (size_t k = i + 1; k < tree_.size(); k += k & (~k + 1))
+        {
+            tree_[k] += delta;
+        }
+    }
+
+    double weight(size_t i) const
+    {
+        return weights_[i];
+    }
+
+    double total() const
+    {
+        double t = 0.;
+
+        for (size_t k = tree_.size() - 1; k > 0; k -= k & (~k + 1))
+        {
+            t += tree_[k];
+        }
+
+        return t;
+    }
+
+    //! Index `i` such that the cumulated weight before `i` is <= `u` and
+    //! the cumulated weight including `i` is larger than `u`.
+    size_t find(double u) const
+    {
+        size_t pos = 0;
+
+        for (size_t step = top_; step > 0; step /= 2)
+        {
+            if (pos + step < tree_.size() && tree_[pos + step] <= u)
+            {
+                pos += step;
+                u   -= tree_[pos];
+            }
+        }
+
+        // guard against rounding errors: never return a zero weight, the
+        // closest positive one can be before or after `pos`
+        pos = std::min(pos, weights_.size() - 1);
+
+        size_t before = pos, after = pos;
+
+        while (weights_[before] <= 0. && before > 0)
+        {
+            before--;
+        }
+
+        if (weights_[before] > 0.)
+        {
+            return before;
+        }
+
+        while (weights_[after] <= 0. && after + 1 < weights_.size())
+        {
+            after++;
+        }
+
+        return weights_[after] > 0. ? after : pos;
+    }
+
+  private:
+    std::vector<double> tree_;
+    std::vector<double> weights_;
+    size_t top_;
+};
+
+
+size_t _gen_price(
+  std::vector<int64_t>& edges, array_view<size_t> nodes,
+  unsigned int m, double c, double gamma, double reciprocity, bool directed,
+  long seed)
+{
+    const size_t num_nodes = nodes.size();
+
+    edges.clear();
+
+    if (num_nodes < 2 || m == 0)
+    {
+        return 0;
+    }
+
+    edges.reserve(2*m*num_nodes*(1 + (directed ? reciprocity : 0.)));
+
+    // in-degree (directed) or degree (undirected) of each node
+    std::vector<double> degrees(num_nodes, 0.);
+
+    // attachment weights of the nodes that are already in the graph
+    weight_tree tree(num_nodes);
+
+    auto kernel = [c, gamma](double degree) -> double
+    {
+        return std::pow(degree, gamma) + c;
+    };
+
+    counter_rng generator_(seed, 0);
+
+    std::vector<size_t> chosen;
+
+    for (size_t i=1; i < num_nodes; i++)
+    {
+        // node i - 1 can now receive edges
+        tree.set(i - 1, kernel(degrees[i - 1]));
+
+        size_t m_i = std::min(i, static_cast<size_t>(m));
+
+        // draw m_i different targets, proportionally to their weight
+        chosen.clear();
+
+        for (size_t j=0; j < m_i; j++)
+        {
+            size_t t = i == 1 ? 0 : tree.find(generator_.uniform_pos()
+                                                * tree.total());
+
+            chosen.push_back(t);
+
+            // remove it from the targets until all are drawn
+            tree.set(t, 0.);
+        }
+
+        for (size_t t : chosen)
+        {
+            edges.push_back(nodes[i]);
+            edges.push_back(nodes[t]);
+
+            degrees[t] += 1;
+
+            if (not directed)
+            {
+                degrees[i] += 1;
+            }
+        }
+
+        // reciprocal edges
+        if (directed && reciprocity > 0)
+        {
+            for (size_t t : chosen)
+            {
+                if (generator_.uniform_pos() <= reciprocity)
+                {
+                    edges.push_back(nodes[t]);
+                    edges.push_back(nodes[i]);
+
+                    degrees[i] += 1;
+                }
+            }
+        }
+
+        // restore the weights with the new degrees
+        for (size_t t : chosen)
+        {
+            tree.set(t, kernel(degrees[t]));
+        }
+    }
+
+    return edges.size() / 2;
+}
+
+
+/*
+* Spatial neighbours
+*/
+
+spatial_grid::spatial_grid(array_view<size_t> nodes,
+                           array_view<float> x,
+                           array_view<float> y, float lim)
+  : nodes_(nodes), x_(x), y_(y), xmin_(0.), ymin_(0.), inv_cell_(1.),
+    nx_(1), ny_(1)
+{
+    const size_t num_nodes = nodes.size();
+
+    float xmax = 0., ymax = 0.;
+
+    if (num_nodes > 0)
+    {
+        xmin_ = xmax = x[nodes[0]];
+        ymin_ = ymax = y[nodes[0]];
+    }
+
+    for (size_t i=1; i < num_nodes; i++)
+    {
+        xmin_ = std::min(xmin_, x[nodes[i]]);
+        xmax  = std::max(xmax, x[nodes[i]]);
+        ymin_ = std::min(ymin_, y[nodes[i]]);
+        ymax  = std::max(ymax, y[nodes[i]]);
+    }
+
+    // cells are at least `lim` wide but we keep at most ~4 cells per node
+    float extent = std::max(xmax - xmin_, ymax - ymin_);
+    float max_cells = 2*std::ceil(std::sqrt(static_cast<float>(num_nodes)));
+    float cell = std::max(lim, extent / std::max(max_cells, 1.f));
+
+    if (not (cell > 0.) or std::isinf(cell))
+    {
+        // degenerate cases: everyone in a single cell
+        cell = std::isinf(cell) ? std::numeric_limits<float>::max() : 1.;
+    }
+
+    inv_cell_ = 1. / cell;
+    nx_       = static_cast<long>((xmax - xmin_) * inv_cell_) + 1;
+    ny_       = static_cast<long>((ymax - ymin_) * inv_cell_) + 1;
+
+    // counting sort of the nodes into the cells; the order of the nodes is
+    // preserved inside each cell
+    std::vector<size_t> cell_ids(num_nodes);
+    cell_start_.assign(nx_*ny_ + 1, 0);
+
+    for (size_t i=0; i < num_nodes; i++)
+    {
+        long cx = static_cast<long>((x[nodes[i]] - xmin_) * inv_cell_);
+        long cy = static_cast<long>((y[nodes[i]] - ymin_) * inv_cell_);
+
+        cell_ids[i] = std::min(cy, ny_ - 1)*nx_ + std::min(cx, nx_ - 1);
+        cell_start_[cell_ids[i] + 1] += 1;
+    }
+
+    std::partial_sum(cell_start_.begin(), cell_start_.end(),
+                     cell_start_.begin());
+
+    std::vector<size_t> fill(cell_start_.begin(), cell_start_.end() - 1);
+    cell_items_.resize(num_nodes);
+
+    for (size_t i=0; i < num_nodes; i++)
+    {
+        cell_items_[fill[cell_ids[i]]++] = i;
+    }
+}
+
+
+size_t spatial_grid::box_query(float xc, float yc, float lim, size_t exclude,
+                               size_t* neighbours) const
+{
+    size_t num_neighbours = 0;
+
+    // index range of the cells overlapping the box
+    long cx_min = std::max(
+        static_cast<long>(std::floor((xc - lim - xmin_) * inv_cell_)), 0L);
+    long cx_max = std::min(
+        static_cast<long>(std::floor((xc + lim - xmin_) * inv_cell_)),
+        nx_ - 1);
+    long cy_min = std::max(
+        static_cast<long>(std::floor((yc - lim - ymin_) * inv_cell_)), 0L);
+    long cy_max = std::min(
+        static_cast<long>(std::floor((yc + lim - ymin_) * inv_cell_)),
+        ny_ - 1);
+
+    size_t idx, node;
+
+    for (long cy=cy_min; cy <= cy_max; cy++)
+    {
+        for (long cx=cx_min; cx <= cx_max; cx++)
+        {
+            size_t cell = cy*nx_ + cx;
+
+            for (size_t k=cell_start_[cell]; k < cell_start_[cell + 1]; k++)
+            {
+                idx  = cell_items_[k];
+                node = nodes_[idx];
+
+                if (node != exclude && std::abs(x_[node] - xc) < lim
+                    && std::abs(y_[node] - yc) < lim)
+                {
+                    if (neighbours != nullptr)
+                    {
+                        neighbours[num_neighbours] = idx;
+                    }
+
+                    num_neighbours++;
+                }
+            }
+        }
+    }
+
+    if (neighbours != nullptr)
+    {
+        // return the neighbours in the same order as a linear scan would
+        std::sort(neighbours, neighbours + num_neighbours);
+
+        for (size_t k=0; k < num_neighbours; k++)
+        {
+            neighbours[k] = nodes_[neighbours[k]];
+        }
+    }
+
+    return num_neighbours;
+}
+
+
+void _box_neighbours(
+  array_view<size_t> source_nodes,
+  array_view<size_t> target_nodes, array_view<float> x,
+  array_view<float> y, float lim, bool exclude_self,
+  size_t* tgt_offsets, size_t* tgt_indices, unsigned int omp)
+{
+    const spatial_grid grid(target_nodes, x, y, lim);
+    const size_t num_sources = source_nodes.size();
+
+    // id that can never be found among the targets
+    const size_t no_node = std::numeric_limits<size_t>::max();
+
+    if (tgt_indices == nullptr)
+    {
+        // count the neighbours then compute the offsets
+        tgt_offsets[0] = 0;
+
+        #pragma omp parallel for num_threads(omp) schedule(dynamic, 64)
+        for (size_t i=0; i < num_sources; i++)
+        {
+            size_t src = source_nodes[i];
+
+            tgt_offsets[i + 1] = grid.box_query(
+                x[src], y[src], lim, exclude_self ? src : no_node, nullptr);
+        }
+
+        std::partial_sum(tgt_offsets, tgt_offsets + num_sources + 1,
+                         tgt_offsets);
+    }
+    else
+    {
+        // fill each neighbour list in place
+        #pragma omp parallel for num_threads(omp) schedule(dynamic, 64)
+        for (size_t i=0; i < num_sources; i++)
+        {
+            size_t src = source_nodes[i];
+
+            grid.box_query(x[src], y[src], lim, exclude_self ? src : no_node,
+                           tgt_indices + tgt_offsets[i]);
+        }
+    }
+}
+
+
+/*
+* Distance-rule algorithms
+*/
+
+// number of sources per block in _cdistance_rule
+static const size_t DIST_BLOCK = 256;
+// maximum number of test rounds in _cdistance_rule
+static const uint64_t DIST_MAX_ROUNDS = 1000;
+
+/*
+ * Split `num_keep` among groups containing `counts` elements, proportionally
+ * to their size (largest remainder method, ties are broken by index).
+ *
+ * \return offsets - Cumulated number of elements kept in each group (the
+ *                   size of the vector is the number of groups + 1).
+ */
+static std::vector<size_t> _apportion(const std::vector<size_t>& counts,
+                                      size_t num_keep)
+{
+    const size_t num_groups = counts.size();
+    const size_t total = std::accumulate(counts.begin(), counts.end(),
+                                         static_cast<size_t>(0));
+
+    std::vector<size_t> offsets(num_groups + 1, 0);
+    std::vector<size_t> quotas(counts);
+
+    if (total > num_keep)
+    {
+        std::vector<double> remainders(num_groups);
+        size_t num_assigned = 0;
+
+        for (size_t i=0; i < num_groups; i++)
+        {
+            double exact  = counts[i] * (num_keep / static_cast<double>(total));
+            quotas[i]     = std::min(static_cast<size_t>(exact), counts[i]);
+            remainders[i] = exact - quotas[i];
+            num_assigned += quotas[i];
+        }
+
+        // give the remaining elements to the largest remainders
+        std::vector<size_t> order(num_groups);
+        std::iota(order.begin(), order.end(), 0);
+
+        std::stable_sort(order.begin(), order.end(),
+            [&remainders](size_t a, size_t b)
+            { return remainders[a] > remainders[b]; });
+
+        for (size_t k=0; num_assigned < num_keep; k = (k + 1) % num_groups)
+        {
+            size_t i = order[k];
+
+            if (quotas[i] < counts[i])
+            {
+                quotas[i]++;
+                num_assigned++;
+            }
+        }
+    }
+
+    std::partial_sum(quotas.begin(), quotas.end(), offsets.begin() + 1);
+
+    return offsets;
+}
+
+
+/*
+ * Registry of the user-defined rules, with their cutoff.
+ */
+static std::map<std::string, std::pair<distance_kernel, float> >&
+_rule_registry()
+{
+    static std::map<std::string, std::pair<distance_kernel, float> > registry;
+
+    return registry;
+}
+
+
+void _register_distance_rule(const std::string& name, distance_kernel kernel,
+                             float cutoff)
+{
+    if (name == "lin" || name == "exp" || name == "gaussian")
+    {
+        throw std::invalid_argument("Built-in rule '" + name + "' cannot be "
+                                    "replaced.");
+    }
+
+    if (kernel == nullptr)
+    {
+        _rule_registry().erase(name);
+    }
+    else if (not (cutoff > 0))
+    {
+        throw std::invalid_argument("`cutoff` must be strictly positive.");
+    }
+    else
+    {
+        _rule_registry()[name] = std::make_pair(kernel, cutoff);
+    }
+}
+
+
+distance_kernel _get_distance_rule(const std::string& name)
+{
+    auto it = _rule_registry().find(name);
+
+    return it == _rule_registry().end() ? nullptr : it->second.first;
+}
+
+
+float _distance_rule_cutoff(const std::string& rule)
+{
+    if (rule == "lin")
+    {
+        return 1.;
+    }
+    else if (rule == "exp" || rule == "gaussian")
+    {
+        return 10.;
+    }
+
+    auto it = _rule_registry().find(rule);
+
+    if (it == _rule_registry().end())
+    {
+        throw std::invalid_argument("`rule` must be among 'lin', 'exp', "
+                                    "'gaussian', or a registered rule.");
+    }
+
+    return it->second.second;
+}
+
+
+/*
+ * Convert `rule` into an int (0: lin, 1: exp, 2: gaussian, 3: user-defined,
+ * in which case `kernel` is set).
+ */
+static int _rule_type(const std::string& rule, distance_kernel& kernel)
+{
+    kernel = nullptr;
+
+    if (rule == "lin")
+    {
+        return 0;
+    }
+    else if (rule == "exp")
+    {
+        return 1;
+    }
+    else if (rule == "gaussian")
+    {
+        return 2;
+    }
+
+    kernel = _get_distance_rule(rule);
+
+    if (kernel == nullptr)
+    {
+        throw std::invalid_argument("`rule` must be among 'lin', 'exp', "
+                                    "'gaussian', or a registered rule.");
+    }
+
+    return 3;
+}
+
+
+/*
+ * Run `num_tests` connection tests from `src` to random targets among its
+ * `nln` neighbours `local_tgts`, by batches of DIST_BATCH, and append the
+ * accepted edges to `sources`/`targets`/`distances`.
+ */
+template <class Rule>
+static void _dr_tests(
+  counter_rng& generator, size_t src, const size_t* local_tgts, size_t nln,
+  size_t num_tests, const float* positions, unsigned int ndim,
+  size_t num_positions, const Rule& rule, std::vector<size_t>& sources,
+  std::vector<size_t>& targets, std::vector<float>& distances)
+{
+    size_t candidates[DIST_BATCH], accepted[DIST_BATCH];
+    float uniforms[DIST_BATCH], dist[DIST_BATCH];
+
+    size_t tgt, n, num_accepted;
+
+    for (size_t start=0; start < num_tests; start += DIST_BATCH)
+    {
+        n = std::min(DIST_BATCH, num_tests - start);
+
+        // draw the candidates, then the numbers used to test them
+        for (size_t i=0; i < n; i++)
+        {
+            tgt = src;
+            while (tgt == src)
+            {
+                tgt = local_tgts[generator.uniform_int(nln)];
+            }
+
+            candidates[i] = tgt;
+        }
+
+        for (size_t i=0; i < n; i++)
+        {
+            uniforms[i] = generator.uniform();
+        }
+
+        num_accepted = _proba_batch(
+            positions, ndim, num_positions, src, candidates, uniforms, n,
+            rule, accepted, dist);
+
+        sources.insert(sources.end(), num_accepted, src);
+        targets.insert(targets.end(), accepted, accepted + num_accepted);
+        distances.insert(distances.end(), dist, dist + num_accepted);
+    }
+}
+
+
+/*
+ * Generate `num_edges` edges from the sources of blocks [first, last) of
+ * _cdistance_rule, by rounds of tests until enough edges are found, then
+ * keep a random subset of `num_edges` edges, apportioned among the blocks.
+ *
+ * The edges of each block are stored in `block_sources`, `block_targets`
+ * and `block_dist`; `global_set` holds the undirected edges of the previous
+ * calls that could be generated again (the edges that are not kept are
+ * removed from it).
+ *
+ * \return offsets - Cumulated number of edges kept in each block of the
+ *                   range (the size of the vector is last - first + 1).
+ */
+static std::vector<size_t> _dr_blocks(
+  size_t first, size_t last, size_t num_edges, array_view<size_t> source_nodes,
+  const size_t* tgt_offsets, const size_t* tgt_indices, int rule_type,
+  const lin_rule& lin, const exp_rule& expo, const gaussian_rule& gauss,
+  const kernel_rule& custom, const float* positions, unsigned int ndim,
+  size_t num_positions, bool multigraph, bool directed, long seed,
+  unsigned int omp, std::vector< std::vector<size_t> >& block_sources,
+  std::vector< std::vector<size_t> >& block_targets,
+  std::vector< std::vector<float> >& block_dist, edge_set& global_set)
+{
+    const size_t num_sources = source_nodes.size();
+    const size_t num_blocks  = last - first;
+
+    const size_t first_source = first*DIST_BLOCK;
+    const size_t last_source  = std::min(last*DIST_BLOCK, num_sources);
+
+    // set the number of tests associated to each node proportionnaly to its
+    // number of neighbours
+    const double neigh_norm =
+        1. / (tgt_offsets[last_source] - tgt_offsets[first_source]);
+
+    std::vector<size_t> block_counts(num_blocks, 0);
+    std::vector<size_t> block_offsets(num_blocks + 1, 0);
+
+    // directed edges from a block can only be duplicated inside that block;
+    // undirected edges are checked against all previous blocks
+    std::vector<edge_set> block_sets;
+
+    if (not multigraph and directed)
+    {
+        block_sets.assign(num_blocks, edge_set(num_positions, directed));
+    }
+
+    size_t current_enum = 0;
+    uint64_t iteration  = 0;
+
+    while (num_edges > 0 && current_enum < num_edges)
+    {
+        // the pairs with a non-zero probability can be too few to provide
+        // the edges
+        if (iteration == DIST_MAX_ROUNDS)
+        {
+            throw std::runtime_error("Algorithm did not converge.");
+        }
+
+        const size_t missing = num_edges - current_enum;
+
+        #pragma omp parallel for num_threads(omp) schedule(dynamic)
+        for (size_t k=0; k < num_blocks; k++)
+        {
+            const size_t b = first + k;
+
+            size_t src, local_tests, nln;
+            const size_t* local_tgts;
+
+            std::vector<size_t>& sources = block_sources[b];
+            std::vector<size_t>& targets = block_targets[b];
+            std::vector<float>& distances = block_dist[b];
+
+            size_t round_start = sources.size();
+
+            size_t stop = std::min((b + 1)*DIST_BLOCK, num_sources);
+
+            for (size_t i=b*DIST_BLOCK; i < stop; i++)
             {
-                for (size_t i=0; i<initial_enum; i++)
+                // neighbours are accessed in place (no copy)
+                local_tgts = tgt_indices + tgt_offsets[i];
+                nln = tgt_offsets[i + 1] - tgt_offsets[i];
+
+                if (nln == 0)
+                {
+                    continue;
+                }
+
+                local_tests = nln * missing * neigh_norm;
+                // test at least all neighbours
+                local_tests = std::max(local_tests, nln);
+
+                src = source_nodes[i];
+
+                counter_rng generator_(seed, src, iteration);
+
+                switch (rule_type)
                 {
-                    ia_edges[2*i]     = existing_edges[0][i];
-                    ia_edges[2*i + 1] = existing_edges[1][i];
+                    case 0:
+                        _dr_tests(generator_, src, local_tgts, nln,
+                                  local_tests, positions, ndim,
+                                  num_positions, lin, sources, targets,
+                                  distances);
+                        break;
+                    case 1:
+                        _dr_tests(generator_, src, local_tgts, nln,
+                                  local_tests, positions, ndim,
+                                  num_positions, expo, sources, targets,
+                                  distances);
+                        break;
+                    case 2:
+                        _dr_tests(generator_, src, local_tgts, nln,
+                                  local_tests, positions, ndim,
+                                  num_positions, gauss, sources, targets,
+                                  distances);
+                        break;
+                    default:
+                        _dr_tests(generator_, src, local_tgts, nln,
+                                  local_tests, positions, ndim,
+                                  num_positions, custom, sources, targets,
+                                  distances);
                 }
-                ecount_fill += initial_enum;
             }
-            // then, once this is done
-            #pragma omp barrier
-            // each thread successively adds its local edges
-            #pragma omp critical
+
+            if (not multigraph and directed)
             {
-                if (current_enum > num_edges)
+                // keep only the new edges of this round
+                size_t kept = round_start;
+
+                for (size_t k=round_start; k < sources.size(); k++)
                 {
-                    // more connections than needed, we need to randomize the
-                    // generated edges and keep only a fraction
-                    size_t keep = ceil(
-                        local_edges[0].size() * num_edges /
-                        static_cast<double>(current_enum - initial_enum));
-                    // randomize (first copy MT generator
-                    auto rng_copy  = generator_;
-                    auto rng_copy2 = generator_;
-                    std::shuffle(local_edges[0].begin(), local_edges[0].end(), generator_);
-                    std::shuffle(local_edges[1].begin(), local_edges[1].end(), rng_copy);
-                    std::shuffle(local_dist.begin(), local_dist.end(), rng_copy2);
-                    // keep only chosen ones
-                    local_edges[0].resize(keep);
-                    local_edges[1].resize(keep);
-                    local_dist.resize(keep);
-                    num_elocal = keep;
+                    if (block_sets[b - first].insert(sources[k], targets[k]))
+                    {
+                        sources[kept]   = sources[k];
+                        targets[kept]   = targets[k];
+                        distances[kept] = distances[k];
+                        kept++;
+                    }
                 }
-                size_t i = 0;
-                #pragma omp flush(ecount_fill)
-                if (ecount_fill + num_elocal <= target_enum)
+
+                sources.resize(kept);
+                targets.resize(kept);
+                distances.resize(kept);
+            }
+
+            block_counts[k] = round_start;
+        }
+
+        // undirected duplicates can come from any block, remove them in
+        // block order
+        if (not multigraph and not directed)
+        {
+            for (size_t k=0; k < num_blocks; k++)
+            {
+                std::vector<size_t>& sources = block_sources[first + k];
+                std::vector<size_t>& targets = block_targets[first + k];
+                std::vector<float>& distances = block_dist[first + k];
+
+                size_t kept = block_counts[k];
+
+                for (size_t i=kept; i < sources.size(); i++)
                 {
-                    dist.insert(dist.begin() + ecount_fill, local_dist.begin(),
-                                local_dist.end());
+                    if (global_set.insert(sources[i], targets[i]))
+                    {
+                        sources[kept]   = sources[i];
+                        targets[kept]   = targets[i];
+                        distances[kept] = distances[i];
+                        kept++;
+                    }
                 }
-                else
+
+                sources.resize(kept);
+                targets.resize(kept);
+                distances.resize(kept);
+            }
+        }
+
+        current_enum = 0;
+
+        for (size_t k=0; k < num_blocks; k++)
+        {
+            block_counts[k] = block_sources[first + k].size();
+            current_enum   += block_counts[k];
+        }
+
+        iteration++;
+    }
+
+    // compute how many edges each block keeps
+    if (num_edges > 0)
+    {
+        block_offsets = _apportion(block_counts, num_edges);
+    }
+
+    #pragma omp parallel for num_threads(omp) schedule(dynamic)
+    for (size_t k=0; k < num_blocks; k++)
+    {
+        const size_t b = first + k;
+
+        size_t keep = block_offsets[k + 1] - block_offsets[k];
+
+        std::vector<size_t>& sources = block_sources[b];
+        std::vector<size_t>& targets = block_targets[b];
+        std::vector<float>& distances = block_dist[b];
+
+        if (keep < sources.size())
+        {
+            // more connections than needed, we need to randomize the
+            // generated edges and keep only a fraction
+            counter_rng generator_(seed, b, iteration);
+
+            _shuffle(generator_, sources.size(), sources.data(),
+                     targets.data(), distances.data());
+        }
+    }
+
+    for (size_t k=0; k < num_blocks; k++)
+    {
+        const size_t b    = first + k;
+        const size_t keep = block_offsets[k + 1] - block_offsets[k];
+
+        if (not multigraph and not directed)
+        {
+            // the dropped edges can still be drawn by the next calls
+            for (size_t i=keep; i < block_sources[b].size(); i++)
+            {
+                global_set.erase(block_sources[b][i], block_targets[b][i]);
+            }
+        }
+
+        block_sources[b].resize(keep);
+        block_targets[b].resize(keep);
+        block_dist[b].resize(keep);
+    }
+
+    return block_offsets;
+}
+
+
+void _cdistance_rule(int64_t* ia_edges, array_view<size_t> source_nodes,
+  const size_t* tgt_offsets, const size_t* tgt_indices,
+  const std::string& rule, float scale, float norm, const float* positions,
+  unsigned int ndim, size_t num_positions, size_t num_neurons,
+  size_t num_edges, array_view<int64_t> existing_edges,
+  float* dist, bool multigraph, bool directed,
+  long seed, unsigned int omp, edge_sink sink, void* sink_data,
+  size_t batch_size)
+{
+    // rule into int
+    distance_kernel kernel;
+    const int rule_type = _rule_type(rule, kernel);
+
+    const lin_rule lin(norm, scale);
+    const exp_rule expo(norm, scale);
+    const gaussian_rule gauss(norm, scale);
+    const kernel_rule custom(kernel, norm, scale);
+
+    const size_t initial_enum = existing_edges.size() / 2;
+
+    const size_t num_sources = source_nodes.size();
+
+    // the sources are split into fixed blocks which do not depend on the
+    // number of threads: each block stores its own edges and each source
+    // draws from its own (seed, source, round) stream, so the result is the
+    // same whatever the number of threads or the schedule
+    const size_t num_blocks = (num_sources + DIST_BLOCK - 1) / DIST_BLOCK;
+
+    size_t num_pairs = tgt_offsets[num_sources];
+
+    // for undirected simple graphs, store the block of each source
+    // (num_blocks for the other nodes) and which nodes are targets
+    std::vector<size_t> source_block;
+    std::vector<bool> is_target;
+
+    if (not multigraph and not directed)
+    {
+        source_block.assign(num_positions, num_blocks);
+        is_target.assign(num_positions, false);
+
+        for (size_t i=0; i < num_sources; i++)
+        {
+            source_block[source_nodes[i]] = i / DIST_BLOCK;
+        }
+
+        for (size_t j=0; j < num_pairs; j++)
+        {
+            is_target[tgt_indices[j]] = true;
+        }
+
+        // a source which is also the target of another source appears in
+        // the neighbours of that source and conversely: count it once
+        size_t num_twice = 0;
+
+        for (size_t i=0; i < num_sources; i++)
+        {
+            if (is_target[source_nodes[i]])
+            {
+                for (size_t j=tgt_offsets[i]; j < tgt_offsets[i + 1]; j++)
                 {
-                    dist.insert(dist.begin() + ecount_fill, local_dist.begin(),
-                                local_dist.begin() + target_enum
-                                - ecount_fill);
+                    num_twice += (source_block[tgt_indices[j]] < num_blocks);
                 }
-                while (i < num_elocal && ecount_fill < target_enum)
+            }
+        }
+
+        num_pairs -= num_twice / 2;
+    }
+
+    // if not using multigraph, assert that we have enough neighbours
+    if (num_pairs < initial_enum + num_edges)
+    {
+        throw std::invalid_argument("Scale is too small: there are not enough "
+                                    "close neighbours to create the required "
+                                    "number of connections. Increase `scale` "
+                                    "or `neuron_density`.");
+    }
+
+    std::vector< std::vector<size_t> > block_sources(num_blocks);
+    std::vector< std::vector<size_t> > block_targets(num_blocks);
+    std::vector< std::vector<float> > block_dist(num_blocks);
+
+    edge_set global_set(num_positions, directed);
+
+    if (sink == nullptr)
+    {
+        std::vector<size_t> block_offsets = _dr_blocks(
+            0, num_blocks, num_edges, source_nodes, tgt_offsets, tgt_indices,
+            rule_type, lin, expo, gauss, custom, positions, ndim,
+            num_positions, multigraph, directed, seed, omp, block_sources,
+            block_targets, block_dist, global_set);
+
+        // each block copies its edges at its own offset
+        #pragma omp parallel for num_threads(omp) schedule(dynamic)
+        for (size_t b=0; b < num_blocks; b++)
+        {
+            const size_t offset = initial_enum + block_offsets[b];
+            const size_t keep   = block_sources[b].size();
+
+            for (size_t i=0; i < keep; i++)
+            {
+                ia_edges[2*(offset + i)]     = block_sources[b][i];
+                ia_edges[2*(offset + i) + 1] = block_targets[b][i];
+            }
+
+            if (dist != nullptr)
+            {
+                std::copy(block_dist[b].begin(), block_dist[b].end(),
+                          dist + block_offsets[b]);
+            }
+        }
+
+        // copy the existing edges in front of the new ones
+        std::copy(existing_edges.begin(), existing_edges.end(), ia_edges);
+
+        return;
+    }
+
+    // streaming: the edges are split among the blocks proportionally to
+    // their number of neighbours, then consecutive blocks are generated
+    // together until about `batch_size` edges are expected, so that only one
+    // such group of blocks is stored before being passed to the sink
+    batch_size = std::max(batch_size, static_cast<size_t>(1));
+
+    std::vector<size_t> block_neighbours(num_blocks);
+
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        block_neighbours[b] =
+            tgt_offsets[std::min((b + 1)*DIST_BLOCK, num_sources)]
+            - tgt_offsets[b*DIST_BLOCK];
+    }
+
+    const std::vector<size_t> quotas = _apportion(block_neighbours,
+                                                  num_edges);
+
+    edge_emitter emitter(ia_edges, sink, sink_data, batch_size, true);
+
+    size_t first = 0;
+
+    while (first < num_blocks && not emitter.aborted())
+    {
+        size_t last = first + 1;
+
+        while (last < num_blocks
+               && quotas[last + 1] - quotas[first] <= batch_size)
+        {
+            last++;
+        }
+
+        _dr_blocks(first, last, quotas[last] - quotas[first], source_nodes,
+                   tgt_offsets, tgt_indices, rule_type, lin, expo, gauss,
+                   custom, positions, ndim, num_positions, multigraph,
+                   directed, seed, omp, block_sources, block_targets,
+                   block_dist, global_set);
+
+        for (size_t b=first; b < last && not emitter.aborted(); b++)
+        {
+            for (size_t i=0; i < block_sources[b].size(); i++)
+            {
+                emitter.push(block_sources[b][i], block_targets[b][i],
+                             block_dist[b][i]);
+            }
+
+            // free memory as we go
+            std::vector<size_t>().swap(block_sources[b]);
+            std::vector<size_t>().swap(block_targets[b]);
+            std::vector<float>().swap(block_dist[b]);
+        }
+
+        if (not multigraph and not directed)
+        {
+            // forget the edges that cannot be drawn again: only the edges
+            // towards the sources of the next groups (from nodes that they
+            // can reach) are kept, and they are removed once the group of
+            // their target has been generated
+            const size_t stop = std::min(last*DIST_BLOCK, num_sources);
+
+            for (size_t i=first*DIST_BLOCK; i < stop; i++)
+            {
+                const size_t src = source_nodes[i];
+
+                for (size_t j=tgt_offsets[i]; j < tgt_offsets[i + 1]; j++)
                 {
-                    ia_edges[2*ecount_fill]     = local_edges[0][i];
-                    ia_edges[2*ecount_fill + 1] = local_edges[1][i];
-                    ecount_fill += 1;
-                    i += 1;
+                    const size_t tgt = tgt_indices[j];
+
+                    if (source_block[tgt] < last
+                        || source_block[tgt] == num_blocks
+                        || not is_target[src])
+                    {
+                        global_set.erase(src, tgt);
+                    }
                 }
             }
         }
+
+        first = last;
+    }
+
+    emitter.flush();
+}
+
+
+/*
+ * Test each neighbour of `src` once and append the accepted edges to
+ * `sources`/`targets`/`distances` (if `pairs_once`, only targets with a
+ * larger id are tested).
+ */
+template <class Rule>
+static void _dr_proba_tests(
+  counter_rng& generator, size_t src, const size_t* local_tgts, size_t nln,
+  bool pairs_once, const float* positions, unsigned int ndim,
+  size_t num_positions, const Rule& rule, std::vector<size_t>& sources,
+  std::vector<size_t>& targets, std::vector<float>& distances)
+{
+    size_t candidates[DIST_BATCH], accepted[DIST_BATCH];
+    float uniforms[DIST_BATCH], dist[DIST_BATCH];
+
+    size_t n, num_accepted, j = 0;
+
+    while (j < nln)
+    {
+        // collect the next batch of candidates
+        n = 0;
+
+        while (j < nln && n < DIST_BATCH)
+        {
+            candidates[n] = local_tgts[j];
+            n += (local_tgts[j] != src
+                  && (not pairs_once || local_tgts[j] > src));
+            j++;
+        }
+
+        for (size_t i=0; i < n; i++)
+        {
+            uniforms[i] = generator.uniform();
+        }
+
+        num_accepted = _proba_batch(
+            positions, ndim, num_positions, src, candidates, uniforms, n,
+            rule, accepted, dist);
+
+        sources.insert(sources.end(), num_accepted, src);
+        targets.insert(targets.end(), accepted, accepted + num_accepted);
+        distances.insert(distances.end(), dist, dist + num_accepted);
+    }
+}
+
+
+size_t _cdistance_rule_proba(
+  std::vector<int64_t>& edges, array_view<size_t> source_nodes,
+  const size_t* tgt_offsets, const size_t* tgt_indices,
+  const std::string& rule, float scale, float max_proba,
+  const float* positions, unsigned int ndim, size_t num_positions,
+  bool pairs_once, std::vector<float>& dist, long seed, unsigned int omp,
+  edge_sink sink, void* sink_data, size_t batch_size)
+{
+    // rule into int
+    distance_kernel kernel;
+    const int rule_type = _rule_type(rule, kernel);
+
+    const lin_rule lin(max_proba, scale);
+    const exp_rule expo(max_proba, scale);
+    const gaussian_rule gauss(max_proba, scale);
+    const kernel_rule custom(kernel, max_proba, scale);
+
+    // each block of sources fills its own buffers
+    const size_t num_sources = source_nodes.size();
+    const size_t num_blocks  = (num_sources + DIST_BLOCK - 1) / DIST_BLOCK;
+
+    std::vector< std::vector<size_t> > block_sources(num_blocks);
+    std::vector< std::vector<size_t> > block_targets(num_blocks);
+    std::vector< std::vector<float> > block_dist(num_blocks);
+    std::vector<size_t> block_offsets(num_blocks + 1, 0);
+
+    #pragma omp parallel for num_threads(omp) schedule(dynamic)
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        std::vector<size_t>& sources = block_sources[b];
+        std::vector<size_t>& targets = block_targets[b];
+        std::vector<float>& distances = block_dist[b];
+
+        size_t stop = std::min((b + 1)*DIST_BLOCK, num_sources);
+
+        // reserve for the expected number of edges (at most max_proba per
+        // neighbour)
+        size_t expected = (tgt_offsets[stop] - tgt_offsets[b*DIST_BLOCK])
+                          * std::min(max_proba, 1.f);
+
+        sources.reserve(expected);
+        targets.reserve(expected);
+        distances.reserve(expected);
+
+        for (size_t i=b*DIST_BLOCK; i < stop; i++)
+        {
+            const size_t* local_tgts = tgt_indices + tgt_offsets[i];
+            size_t nln = tgt_offsets[i + 1] - tgt_offsets[i];
+            size_t src = source_nodes[i];
+
+            counter_rng generator_(seed, src);
+
+            switch (rule_type)
+            {
+                case 0:
+                    _dr_proba_tests(generator_, src, local_tgts, nln,
+                                    pairs_once, positions, ndim,
+                                    num_positions, lin, sources, targets,
+                                    distances);
+                    break;
+                case 1:
+                    _dr_proba_tests(generator_, src, local_tgts, nln,
+                                    pairs_once, positions, ndim,
+                                    num_positions, expo, sources, targets,
+                                    distances);
+                    break;
+                case 2:
+                    _dr_proba_tests(generator_, src, local_tgts, nln,
+                                    pairs_once, positions, ndim,
+                                    num_positions, gauss, sources, targets,
+                                    distances);
+                    break;
+                default:
+                    _dr_proba_tests(generator_, src, local_tgts, nln,
+                                    pairs_once, positions, ndim,
+                                    num_positions, custom, sources, targets,
+                                    distances);
+            }
+        }
+    }
+
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        block_offsets[b + 1] = block_offsets[b] + block_sources[b].size();
+    }
+
+    const size_t num_edges = block_offsets[num_blocks];
+
+    if (sink == nullptr)
+    {
+        // concatenate the blocks
+        edges.resize(2*num_edges);
+        dist.resize(num_edges);
+
+        #pragma omp parallel for num_threads(omp) schedule(dynamic)
+        for (size_t b=0; b < num_blocks; b++)
+        {
+            size_t offset = block_offsets[b];
+
+            for (size_t i=0; i < block_sources[b].size(); i++)
+            {
+                edges[2*(offset + i)]     = block_sources[b][i];
+                edges[2*(offset + i) + 1] = block_targets[b][i];
+            }
+
+            std::copy(block_dist[b].begin(), block_dist[b].end(),
+                      dist.begin() + offset);
+        }
+
+        return num_edges;
+    }
+
+    // streaming: send the edges of each block by batches
+    edge_emitter emitter(nullptr, sink, sink_data, batch_size, true);
+
+    for (size_t b=0; b < num_blocks && not emitter.aborted(); b++)
+    {
+        for (size_t i=0; i < block_sources[b].size(); i++)
+        {
+            emitter.push(block_sources[b][i], block_targets[b][i],
+                         block_dist[b][i]);
+        }
+
+        // free memory as we go
+        std::vector<size_t>().swap(block_sources[b]);
+        std::vector<size_t>().swap(block_targets[b]);
+        std::vector<float>().swap(block_dist[b]);
     }
+
+    emitter.flush();
+
+    return num_edges;
 }
 
 }
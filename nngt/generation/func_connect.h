@@ -9,7 +9,9 @@
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <functional>
+#include <limits>
 #include <string>
 #include <vector>
 #include <tuple>
@@ -19,32 +21,434 @@
 namespace generation {
 
 /*
- * Typedefs and struct for edge unordered set definition.
+ * 64-bit mixing function (finalizer of the SplitMix64 generator).
  */
+static inline uint64_t _mix64(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+
+    return z ^ (z >> 31);
+}
 
-typedef std::tuple<size_t, size_t> edge_t;
 
-struct key_hash
+/*
+ * Counter-based random number generator.
+ *
+ * Each stream is identified by a key (master seed, stream id, round), e.g.
+ * the id of the node for which random numbers are drawn, so that the numbers
+ * obtained do not depend on the thread which uses the stream, making the
+ * generated graphs independent from the number of threads and from the
+ * OpenMP schedule.
+ * Numbers are generated by a SplitMix64 sequence starting from a hash of the
+ * key; `uniform_int` and `uniform` do not rely on the implementation-defined
+ * <random> distributions so results are identical on all platforms.
+ *
+ * The class satisfies the UniformRandomBitGenerator requirements.
+ */
+class counter_rng
 {
-    std::size_t operator()(const edge_t& k) const
+  public:
+    typedef uint64_t result_type;
+
+    counter_rng(uint64_t seed, uint64_t stream, uint64_t round=0)
+    {
+        state_ = _mix64(seed + 0x9e3779b97f4a7c15ULL);
+        state_ = _mix64(state_ ^ (stream + 0xd1b54a32d192ed03ULL));
+        state_ = _mix64(state_ ^ (round + 0x8cb92ba72f3d8dd7ULL));
+    }
+
+    static constexpr result_type min() { return 0; }
+
+    static constexpr result_type max()
+    {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    inline result_type operator()()
     {
-        std::size_t h1 = std::hash<size_t>{}(std::get<0>(k));
-        std::size_t h2 = std::hash<size_t>{}(std::get<1>(k));
+        state_ += 0x9e3779b97f4a7c15ULL;
 
-        return h1 ^ (h2 + 0x9e3779b9 + (h1 << 6) + (h1 >> 2));
+        return _mix64(state_);
     }
+
+    //! Unbiased integer in [0, n) (n must be strictly positive).
+    inline uint64_t uniform_int(uint64_t n)
+    {
+        // reject the lowest (2^64 mod n) values to remove the modulo bias
+        const uint64_t threshold = (0 - n) % n;
+
+        uint64_t r = (*this)();
+
+        while (r < threshold)
+        {
+            r = (*this)();
+        }
+
+        return r % n;
+    }
+
+    //! Uniform number in [0, 1) with single-precision resolution.
+    inline float uniform()
+    {
+        return ((*this)() >> 40) * (1.f / 16777216.f);
+    }
+
+    //! Uniform number in (0, 1] with double-precision resolution.
+    inline double uniform_pos()
+    {
+        return (((*this)() >> 11) + 1) * (1. / 9007199254740992.);
+    }
+
+  private:
+    uint64_t state_;
 };
 
-struct key_equal
+
+/*
+ * Randomly permute the `n` first elements of `a` and, in the same way, of
+ * each of the `b` arrays (Fisher-Yates shuffle).
+ */
+template <typename T, typename... Others>
+void _shuffle(counter_rng& rng, size_t n, T* a, Others*... b)
+{
+    for (size_t i = n; i > 1; i--)
+    {
+        size_t j = rng.uniform_int(i);
+
+        std::swap(a[i - 1], a[j]);
+
+        // swap the other arrays the same way
+        int unused[] = {0, (std::swap(b[i - 1], b[j]), 0)...};
+        (void) unused;
+    }
+}
+
+
+/*
+ * Read-only view on a contiguous array, e.g. the buffer of a NumPy array or
+ * a std::vector, so that the entry points can read their inputs in place,
+ * without copying them into temporary vectors.
+ * The view does not own the data, which must outlive it.
+ */
+template <typename T>
+class array_view
 {
-   bool operator()(const edge_t& v0, const edge_t& v1) const
-   {
-      return ( std::get<0>(v0) == std::get<0>(v1) &&
-               std::get<1>(v0) == std::get<1>(v1) );
-   }
+  public:
+    typedef T value_type;
+    typedef const T* const_iterator;
+
+    array_view() : data_(nullptr), size_(0) {}
+
+    array_view(const T* data, size_t size) : data_(data), size_(size) {}
+
+    array_view(const std::vector<T>& vec)
+      : data_(vec.data()), size_(vec.size()) {}
+
+    const T& operator[](size_t i) const { return data_[i]; }
+
+    const T* data() const { return data_; }
+
+    size_t size() const { return size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    const T* begin() const { return data_; }
+
+    const T* end() const { return data_ + size_; }
+
+  private:
+    const T* data_;
+    size_t size_;
 };
 
-typedef std::unordered_set<edge_t, key_hash, key_equal> set_t;
+
+/*
+ * Flat set of edges using open addressing with linear probing.
+ *
+ * When all node ids fit in 32 bits, each edge is packed into a single 64-bit
+ * key, otherwise two 64-bit words are used per edge.
+ * Undirected edges are stored canonically as (min, max) so that (s, t) and
+ * (t, s) are the same entry.
+ */
+class edge_set
+{
+  public:
+    /*
+     * Create an empty set.
+     *
+     * \param max_node - upper bound on the node ids that will be inserted.
+     * \param directed - whether (s, t) and (t, s) are different edges.
+     * \param capacity - expected number of edges (avoids rehashing).
+     */
+    edge_set(size_t max_node, bool directed=true, size_t capacity=0);
+
+    /*
+     * Insert an edge.
+     *
+     * \return inserted - false if the edge was already in the set.
+     */
+    inline bool insert(size_t s, size_t t)
+    {
+        if (2*(num_edges_ + 1) > capacity())
+        {
+            rehash(2*capacity());
+        }
+
+        uint64_t k0, k1;
+        _make_key(s, t, k0, k1);
+
+        size_t slot = _find(k0, k1);
+
+        if (_is_empty(slot))
+        {
+            _store(slot, k0, k1);
+            num_edges_++;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    //! Check whether an edge is present in the set.
+    inline bool contains(size_t s, size_t t) const
+    {
+        uint64_t k0, k1;
+        _make_key(s, t, k0, k1);
+
+        return not _is_empty(_find(k0, k1));
+    }
+
+    /*
+     * Remove an edge.
+     *
+     * \return removed - false if the edge was not in the set.
+     */
+    bool erase(size_t s, size_t t);
+
+    //! Number of edges in the set.
+    inline size_t size() const { return num_edges_; }
+
+    //! Make sure that `num_edges` can be stored without rehashing.
+    void reserve(size_t num_edges);
+
+    //! Remove all edges (keeps the allocated memory).
+    void clear();
+
+  private:
+    inline size_t capacity() const { return mask_ + 1; }
+
+    inline void _make_key(size_t s, size_t t, uint64_t& k0,
+                          uint64_t& k1) const
+    {
+        if (not directed_ && t < s)
+        {
+            std::swap(s, t);
+        }
+
+        if (wide_)
+        {
+            k0 = s;
+            k1 = t;
+        }
+        else
+        {
+            k0 = (static_cast<uint64_t>(s) << 32) | static_cast<uint64_t>(t);
+            k1 = 0;
+        }
+    }
+
+    inline size_t _home(uint64_t k0, uint64_t k1) const
+    {
+        return (wide_ ? _mix64(k0 ^ _mix64(k1)) : _mix64(k0)) & mask_;
+    }
+
+    inline size_t _find(uint64_t k0, uint64_t k1) const
+    {
+        size_t slot = _home(k0, k1);
+
+        while (not _is_empty(slot))
+        {
+            if (keys_[stride_*slot] == k0
+                && (not wide_ || keys_[2*slot + 1] == k1))
+            {
+                break;
+            }
+
+            slot = (slot + 1) & mask_;
+        }
+
+        return slot;
+    }
+
+    inline bool _is_empty(size_t slot) const
+    {
+        return keys_[stride_*slot] == empty_;
+    }
+
+    inline void _store(size_t slot, uint64_t k0, uint64_t k1)
+    {
+        keys_[stride_*slot] = k0;
+
+        if (wide_)
+        {
+            keys_[2*slot + 1] = k1;
+        }
+    }
+
+    void rehash(size_t new_capacity);
+
+    static const uint64_t empty_ = std::numeric_limits<uint64_t>::max();
+
+    bool directed_;
+    bool wide_;               // two words per key
+    size_t stride_;           // number of words per key
+    size_t num_edges_;
+    size_t mask_;             // capacity - 1 (capacity is a power of 2)
+    std::vector<uint64_t> keys_;
+};
+
+
+/*
+ * Function receiving the edges produced by the generators in batches.
+ *
+ * \param data      - User data given to the generator along with the sink.
+ * \param edges     - Linearized (num_edges, 2) array containing the edges.
+ * \param dist      - Distances associated to the edges (NULL if undefined).
+ * \param num_edges - Number of edges in the batch.
+ *
+ * .. note::
+ *   The arrays are only valid during the call and are reused afterwards.
+ *
+ * \return keep_going - Whether the generation should continue.
+ */
+typedef bool (*edge_sink)(void* data, const int64_t* edges, const float* dist,
+                          size_t num_edges);
+
+
+/*
+ * Output of the generators: edges are either written directly into a
+ * preallocated (E, 2) array or, if a sink is provided, accumulated into a
+ * buffer which is passed to the sink each time it contains `batch_size`
+ * edges.
+ */
+class edge_emitter
+{
+  public:
+    edge_emitter(int64_t* ia_edges, edge_sink sink, void* sink_data,
+                 size_t batch_size, bool with_dist=false)
+      : ia_edges_(ia_edges), sink_(sink), sink_data_(sink_data),
+        batch_size_(std::max(batch_size, static_cast<size_t>(1))),
+        with_dist_(with_dist), aborted_(false), num_edges_(0)
+    {
+        if (sink_ != nullptr)
+        {
+            buffer_.resize(2*batch_size_);
+            dist_buffer_.resize(with_dist ? batch_size_ : 0);
+        }
+    }
+
+    //! Add an edge (the distance is ignored unless a sink is used).
+    inline void push(size_t s, size_t t, float d=0.)
+    {
+        if (sink_ == nullptr)
+        {
+            ia_edges_[2*num_edges_]     = s;
+            ia_edges_[2*num_edges_ + 1] = t;
+
+            num_edges_++;
+        }
+        else if (not aborted_)
+        {
+            buffer_[2*num_edges_]     = s;
+            buffer_[2*num_edges_ + 1] = t;
+
+            if (with_dist_)
+            {
+                dist_buffer_[num_edges_] = d;
+            }
+
+            if (++num_edges_ == batch_size_)
+            {
+                flush();
+            }
+        }
+    }
+
+    //! Send the remaining edges to the sink.
+    void flush()
+    {
+        if (sink_ != nullptr && num_edges_ > 0 && not aborted_)
+        {
+            aborted_ = not sink_(sink_data_, buffer_.data(),
+                                 with_dist_ ? dist_buffer_.data() : nullptr,
+                                 num_edges_);
+            num_edges_ = 0;
+        }
+    }
+
+    //! Whether the sink asked to stop the generation.
+    inline bool aborted() const { return aborted_; }
+
+  private:
+    int64_t* ia_edges_;
+    edge_sink sink_;
+    void* sink_data_;
+    size_t batch_size_;
+    bool with_dist_;
+    bool aborted_;
+    size_t num_edges_;
+    std::vector<int64_t> buffer_;
+    std::vector<float> dist_buffer_;
+};
+
+
+/*
+ * Uniform grid (cell list) used to find the spatial neighbours of a node.
+ *
+ * The nodes are binned once into square cells, stored contiguously cell by
+ * cell (counting sort), so that a box query only visits the cells which
+ * overlap the box instead of all the nodes.
+ * The grid is read-only after construction and can be queried concurrently.
+ */
+struct spatial_grid
+{
+    /*
+     * Build the grid.
+     *
+     * \param nodes - ids of the nodes that will be stored in the grid.
+     * \param x     - x coordinate of all the neurons' positions.
+     * \param y     - y coordinate of all the neurons' positions.
+     * \param lim   - half-width of the boxes that will be queried.
+     */
+    spatial_grid(array_view<size_t> nodes, array_view<float> x,
+                 array_view<float> y, float lim);
+
+    /*
+     * Get the nodes located strictly inside the square box centered on
+     * (`xc`, `yc`) with half-width `lim`.
+     *
+     * \param xc, yc    - center of the box.
+     * \param lim       - half-width of the box.
+     * \param exclude   - node id that should not be returned (e.g. source).
+     * \param neighbours - array that is filled with the node ids, in the
+     *                     order of `nodes`; if NULL, the neighbours are only
+     *                     counted.
+     *
+     * \return num_neighbours - Number of nodes inside the box.
+     */
+    size_t box_query(float xc, float yc, float lim, size_t exclude,
+                     size_t* neighbours) const;
+
+    array_view<size_t> nodes_;
+    array_view<float> x_;
+    array_view<float> y_;
+    float xmin_, ymin_, inv_cell_;
+    long nx_, ny_;
+    std::vector<size_t> cell_start_;  // offset of each cell in cell_items_
+    std::vector<size_t> cell_items_;  // index of the nodes in `nodes_`
+};
 
 
 /*
@@ -63,6 +467,7 @@ size_t _unique_1d(std::vector<size_t>& a,
 
 /*
  * Sort a 2-D vector to move the N unique pairs in the N first columns.
+ * Whether (s, t) and (t, s) are considered identical depends on `hash_set`.
  *
  * \param a - Source array.
  *
@@ -71,32 +476,67 @@ size_t _unique_1d(std::vector<size_t>& a,
  *
  * \return num_unique - Number of unique entries.
  */
-size_t _unique_2d(std::vector< std::vector<size_t> >& a, set_t& hash_set,
-                  set_t& recip_set, bool directed=true);
+size_t _unique_2d(std::vector< std::vector<size_t> >& a, edge_set& hash_set);
+
 
+size_t _unique_2d(std::vector< std::vector<size_t> >& a, edge_set& hash_set,
+                  std::vector<float>& dist, const std::vector<float>& dist_tmp);
 
-size_t _unique_2d(std::vector< std::vector<size_t> >& a, set_t& hash_set,
-                  std::vector<float>& dist, const std::vector<float>& dist_tmp,
-                  set_t& recip_set, bool directed=true);
+
+/*
+ * Status of the edges that are about to be added to a graph, using the flat
+ * edge set instead of Python tuples and sets.
+ *
+ * \param edges          - linearized (E, 2) array of the new edges
+ * \param existing_edges - linearized (M, 2) array of the edges of the graph
+ *                         (only used if `existing` is true)
+ * \param directed       - whether the graph is directed
+ * \param loops          - whether self-loops are invalid
+ * \param existing       - whether edges of the graph are invalid
+ * \param status         - array of size E, filled with 0 for valid edges,
+ *                         1 for edges that are already in the graph or
+ *                         appeared earlier in `edges`, 2 for self-loops
+ *
+ * \return num_valid     - number of valid edges
+ */
+size_t _edge_status(
+  array_view<int64_t> edges, array_view<int64_t> existing_edges,
+  bool directed, bool loops, bool existing, uint8_t* status);
 
 
 /*
  * Generate the complementary nodes for desired edges.
  *
- * \param seed           - Seed for the random number generator.
- * \param nodes          - Population from whch to draw the complementary end of the edges.
+ * \param generator      - Random stream of node `other_end`.
+ * \param nodes          - Population from which to draw the complementary end of the edges.
+ * \param min_id         - Smallest id in `nodes`.
+ * \param max_id         - Largest id in `nodes`.
  * \param other_end      - Node at the other end of the edges.
- * \param degree         - Degree of node `other_end` (length of the returned array)
- * \param existing_edges - 2D-array containing the existing edges.
+ * \param degree         - Degree of node `other_end` (length of `result`)
+ * \param old_begin      - Start of the existing neighbours of `other_end`.
+ * \param old_end        - End of the existing neighbours of `other_end`.
  * \param multigraph     - Whether multiple edges are allowed.
+ * \param marks          - Bitmap of (max_id - min_id) / 64 + 1 words set to
+ *                         zero, used to exclude the nodes that cannot be
+ *                         drawn (zeroed again on return, unused for
+ *                         multigraphs).
+ * \param pool           - Buffer for the allowed nodes when the degree is
+ *                         close to the population size.
+ * \param result         - Filled with the complementary nodes.
  *
- * \return result        - The desired vecotr of complementary nodes.
+ * Nodes are drawn by rejection when at most half of the population is
+ * excluded, otherwise by a partial Fisher-Yates shuffle of the allowed
+ * nodes, so the cost is at most O(degree + size of `nodes`).
+ *
+ * \return success       - False if there were not enough nodes to draw
+ *                         `degree` of them (`result` is then shorter).
  */
-std::vector<size_t> _gen_edge_complement(
-  long seed, const std::vector<size_t>& nodes, const size_t other_end,
-  const unsigned int degree,
-  const std::vector< std::vector<size_t> >* existing_edges,
-  bool multigraph, bool directed);
+bool _gen_edge_complement(
+  counter_rng& generator, array_view<size_t> nodes, size_t min_id,
+  size_t max_id, size_t other_end, unsigned int degree,
+  const size_t* old_begin, const size_t* old_end, bool multigraph,
+  std::vector<uint64_t>& marks, std::vector<size_t>& pool,
+  std::vector<size_t>& result);
 
 
 /*
@@ -107,19 +547,59 @@ std::vector<size_t> _gen_edge_complement(
  * \param first_nodes    - Population the degree of which is known.
  * \param degrees        - Degree of each node in `first_nodes`.
  * \param second_nodes   - Population from whch to draw the complementary end of the edges.
- * \param existing_edges - 2D-array containing the existing edges.
+ * \param existing_edges - Linearized (E, 2) array of the existing edges.
  * \param multigraph     - Whether multiple edges are allowed.
  * \param idx            - Index determining source/target from first/second nodes
  * \param directed       - Whether the edges are directed or not.
- * \param msd            - Master seed.
+ * \param seed           - Random seed (each node then uses its own stream).
  * \param omp            - Number of OpenMP threads.
+ * \param sink           - Function receiving the edges by batches; if NULL
+ *                         the edges are written in `ia_edges`.
+ * \param sink_data      - User data passed to the sink.
+ * \param batch_size     - Maximum number of edges passed to each sink call.
  */
 void _gen_edges(
-  int64_t* ia_edges, const std::vector<size_t>& first_nodes,
-  const std::vector<unsigned int>& degrees,
-  const std::vector<size_t>& second_nodes,
-  const std::vector< std::vector<size_t> >& existing_edges, unsigned int idx,
-  bool multigraph, bool directed, std::vector<long>& seeds);
+  int64_t* ia_edges, array_view<size_t> first_nodes,
+  array_view<unsigned int> degrees,
+  array_view<size_t> second_nodes,
+  array_view<int64_t> existing_edges, unsigned int idx,
+  bool multigraph, bool directed, long seed, unsigned int omp,
+  edge_sink sink=nullptr, void* sink_data=nullptr, size_t batch_size=0);
+
+
+/*
+ * Generate the edges of several jobs in a single parallel region, job `j`
+ * connecting its first nodes, with their degrees, to its second nodes as in
+ * _gen_edges.
+ * The nodes of all jobs are split into tasks of similar cost which are
+ * scheduled dynamically across the threads and the existing edges are only
+ * indexed once.
+ * Duplicates between jobs with overlapping populations are not excluded.
+ *
+ * \param ia_edges       - Linearized (E, 2) array that will contain the
+ *                         edges, job after job, in the order of the first
+ *                         nodes.
+ * \param job_nodes      - Offsets (size J + 1) of the first nodes of each job
+ *                         in `first_nodes` and `degrees`.
+ * \param first_nodes    - First nodes of all jobs.
+ * \param degrees        - Degree of each node in `first_nodes`.
+ * \param job_targets    - Offsets (size J + 1) of the second nodes of each
+ *                         job in `second_nodes`.
+ * \param second_nodes   - Second nodes of all jobs.
+ * \param idx            - For each job, 0 if the first nodes are the sources
+ *                         of the edges, 1 if they are the targets.
+ * \param existing_edges - Linearized (E, 2) array of the existing edges.
+ * \param multigraph     - Whether multiple edges are allowed.
+ * \param directed       - Whether the edges are directed or not.
+ * \param seed           - Random seed (each node then uses its own stream).
+ * \param omp            - Number of OpenMP threads.
+ */
+void _gen_edges_batch(
+  int64_t* ia_edges, array_view<size_t> job_nodes,
+  array_view<size_t> first_nodes, array_view<unsigned int> degrees,
+  array_view<size_t> job_targets, array_view<size_t> second_nodes,
+  array_view<uint8_t> idx, array_view<int64_t> existing_edges,
+  bool multigraph, bool directed, long seed, unsigned int omp);
 
 
 /*
@@ -127,28 +607,429 @@ void _gen_edges(
  *
  * \param ia_edges       - array that will contain the edges
  * \param source_nodes   - array containing the ids of the source nodes
- * \param target_nodes   - array containing the ids of the target nodes
- * \param rule           - rule for prabability computation ("exp" or "lin")
+ * \param tgt_offsets    - offsets of each source's targets in `tgt_indices`
+ *                         (CSR format, size: number of sources + 1)
+ * \param tgt_indices    - ids of the potential targets of all sources
+ * \param rule           - rule for prabability computation ("lin", "exp",
+ *                         "gaussian", or a rule registered through
+ *                         _register_distance_rule)
  * \param scale          - typical distance for probability computation
- * \param x              - x coordinate of the neurons' positions
- * \param y              - y coordinate of the neurons' positions
- * \param area           - total area of the spatial environment
+ * \param norm           - probability at zero distance
+ * \param positions      - positions of the neurons, as a contiguous
+ *                         (`ndim`, `num_positions`) array
+ * \param ndim           - number of spatial dimensions
+ * \param num_positions  - number of neurons in `positions` (all node ids must
+ *                         be smaller)
  * \param num_neurons    - total number of neurons
  * \param num_edges      - desired number of edges
- * \param existing_edges - array containing the edges that are already present
- *                         in the graph
+ * \param existing_edges - linearized (E, 2) array containing the edges that
+ *                         are already present in the graph
+ * \param dist           - array of size `num_edges` receiving the distances
+ *                         of the new edges if `sink` is NULL (not recorded
+ *                         if NULL)
  * \param multigraph     - whether the graph can have duplicate edges
- * \param msd            - master seed given by numpy in the cython function
+ * \param seed           - random seed (the result does not depend on `omp`)
  * \param omp            - number of OpenMP threads
+ * \param sink           - function receiving the edges and their distances
+ *                         by batches; if NULL the edges are written in
+ *                         `ia_edges` and the distances in `dist`.
+ * \param sink_data      - user data passed to the sink
+ * \param batch_size     - maximum number of edges passed to each sink call
  */
 void _cdistance_rule(
-  int64_t* ia_edges,const std::vector<size_t>& source_nodes,
-  const std::vector<std::vector<size_t>>& target_nodes,
-  const std::string& rule, float scale, float norm,
-  const std::vector<float>& x, const std::vector<float>& y, size_t num_neurons,
-  size_t num_edges, const std::vector< std::vector<size_t> >& existing_edges,
-  std::vector<float>& dist, bool multigraph, bool directed,
-  std::vector<long>& seeds);
+  int64_t* ia_edges, array_view<size_t> source_nodes,
+  const size_t* tgt_offsets, const size_t* tgt_indices,
+  const std::string& rule, float scale, float norm, const float* positions,
+  unsigned int ndim, size_t num_positions, size_t num_neurons,
+  size_t num_edges, array_view<int64_t> existing_edges,
+  float* dist, bool multigraph, bool directed,
+  long seed, unsigned int omp, edge_sink sink=nullptr,
+  void* sink_data=nullptr, size_t batch_size=0);
+
+
+/*
+ * Parallel distance-rule generator with a fixed probability at zero
+ * distance: each (source, neighbour) pair is tested once.
+ *
+ * \param edges          - filled with the new edges, linearized (E, 2) array
+ *                         (if `sink` is NULL)
+ * \param source_nodes   - array containing the ids of the source nodes
+ * \param tgt_offsets    - offsets of each source's targets in `tgt_indices`
+ *                         (CSR format, size: number of sources + 1)
+ * \param tgt_indices    - ids of the potential targets of all sources
+ * \param rule           - rule for prabability computation (see
+ *                         _cdistance_rule)
+ * \param scale          - typical distance for probability computation
+ * \param max_proba      - probability at zero distance
+ * \param positions      - positions of the neurons, as a contiguous
+ *                         (`ndim`, `num_positions`) array
+ * \param ndim           - number of spatial dimensions
+ * \param num_positions  - number of neurons in `positions`
+ * \param pairs_once     - for undirected graphs where sources and targets
+ *                         are the same population: only test each pair once
+ *                         (from the source with the smallest id)
+ * \param dist           - distances of the new edges (filled if `sink` is
+ *                         NULL)
+ * \param seed           - random seed (the result does not depend on `omp`)
+ * \param omp            - number of OpenMP threads
+ * \param sink           - function receiving the edges and their distances
+ *                         by batches; if NULL the edges are written in
+ *                         `edges` and the distances in `dist`.
+ * \param sink_data      - user data passed to the sink
+ * \param batch_size     - maximum number of edges passed to each sink call
+ *
+ * \return num_edges     - number of edges created
+ */
+size_t _cdistance_rule_proba(
+  std::vector<int64_t>& edges, array_view<size_t> source_nodes,
+  const size_t* tgt_offsets, const size_t* tgt_indices,
+  const std::string& rule, float scale, float max_proba,
+  const float* positions, unsigned int ndim, size_t num_positions,
+  bool pairs_once, std::vector<float>& dist, long seed, unsigned int omp,
+  edge_sink sink=nullptr, void* sink_data=nullptr, size_t batch_size=0);
+
+
+/*
+ * Erdos-Renyi G(n, p) generator: each possible edge between `sources` and
+ * `targets` exists independently with probability `p`.
+ *
+ * Edges are drawn by geometric skipping over each row of the adjacency
+ * matrix (Batagelj & Brandes, 2005), so the cost is proportional to the
+ * number of edges and no duplicate check is needed.
+ *
+ * \param edges          - filled with the new edges, linearized (E, 2) array
+ * \param sources        - ids of the source nodes
+ * \param targets        - ids of the target nodes
+ * \param p              - connection probability
+ * \param one_pop        - whether `sources` and `targets` are the same array
+ *                         (self-loops are then excluded)
+ * \param directed       - for undirected graphs with `one_pop`, each pair is
+ *                         only considered once
+ * \param seed           - random seed (the result does not depend on `omp`)
+ * \param omp            - number of OpenMP threads
+ *
+ * \return num_edges     - number of edges created
+ */
+size_t _gen_gnp(
+  std::vector<int64_t>& edges, array_view<size_t> sources,
+  array_view<size_t> targets, double p, bool one_pop, bool directed,
+  long seed, unsigned int omp);
+
+
+/*
+ * Erdos-Renyi G(n, m) generator: `num_edges` edges are drawn uniformly among
+ * all the possible edges between `sources` and `targets`.
+ *
+ * Simple graphs are generated from a slightly denser G(n, p) graph from
+ * which the extra edges are removed at random.
+ *
+ * \param ia_edges       - (`num_edges`, 2) array that will contain the edges
+ * \param sources        - ids of the source nodes
+ * \param targets        - ids of the target nodes
+ * \param num_edges      - number of edges
+ * \param one_pop        - whether `sources` and `targets` are the same array
+ *                         (self-loops are then excluded)
+ * \param directed       - whether the graph is directed
+ * \param multigraph     - whether the graph can have duplicate edges
+ * \param seed           - random seed (the result does not depend on `omp`)
+ * \param omp            - number of OpenMP threads
+ */
+void _gen_gnm(
+  int64_t* ia_edges, array_view<size_t> sources,
+  array_view<size_t> targets, size_t num_edges, bool one_pop,
+  bool directed, bool multigraph, long seed, unsigned int omp);
+
+
+/*
+ * Check whether a degree sequence is graphical, i.e. whether it can be
+ * realized by a simple undirected graph, using the Erdos-Gallai theorem.
+ *
+ * The degrees are sorted by counting sort and the inequalities are tested
+ * for all k from prefix sums, so the check is O(N).
+ *
+ * \param degrees        - degree of each node
+ * \param omp            - number of OpenMP threads
+ */
+bool _is_graphical(array_view<size_t> degrees, unsigned int omp);
+
+
+/*
+ * Generate a graph with a given (total) degree sequence, by random matching
+ * of the edge stubs (configuration model).
+ *
+ * Stubs that would create a self-loop or a duplicate edge are matched again
+ * at the next round; when matching stalls, existing edges are rewired to
+ * absorb the remaining stubs.
+ * Directed edges get a random orientation.
+ *
+ * \param ia_edges       - (E, 2) array, filled with the edges
+ * \param nodes          - ids of the nodes
+ * \param degrees        - degree of each node (E is half their sum)
+ * \param directed       - whether the graph is directed
+ * \param multigraph     - whether duplicate edges are allowed
+ * \param max_rounds     - maximum number of matching rounds before giving
+ *                         up (0 for no limit)
+ * \param seed           - random seed
+ * \param omp            - number of OpenMP threads
+ */
+void _gen_degree_sequence(
+  int64_t* ia_edges, array_view<size_t> nodes,
+  array_view<size_t> degrees, bool directed, bool multigraph,
+  size_t max_rounds, long seed, unsigned int omp);
+
+
+/*
+ * Number of edges of a circular graph.
+ *
+ * \param num_nodes      - number of nodes
+ * \param coord_nb       - coordination number (even)
+ * \param reciprocity    - fraction of reciprocal edges (directed graphs)
+ * \param directed       - whether the graph is directed
+ */
+size_t _circular_edge_nb(size_t num_nodes, unsigned int coord_nb,
+                         double reciprocity, bool directed);
+
+
+/*
+ * Circular graph: each node is connected to its `coord_nb` closest
+ * neighbours on a ring. The edges come sorted by distance.
+ *
+ * For directed graphs with `reciprocity` < 1, the ring is first built with
+ * random orientations, then the reciprocal edges are added after it.
+ *
+ * \param ia_edges       - (E, 2) array, filled with the edges, where E is
+ *                         given by _circular_edge_nb
+ * \param nodes          - ids of the nodes, in ring order
+ * \param coord_nb       - coordination number (even)
+ * \param reciprocity    - fraction of reciprocal edges (directed graphs)
+ * \param closest        - whether the reciprocal edges are the shortest ones
+ *                         (otherwise they are chosen randomly)
+ * \param directed       - whether the graph is directed
+ * \param seed           - random seed
+ * \param omp            - number of OpenMP threads
+ */
+void _gen_circular(
+  int64_t* ia_edges, array_view<size_t> nodes, unsigned int coord_nb,
+  double reciprocity, bool closest, bool directed, long seed,
+  unsigned int omp);
+
+
+/*
+ * Newman-Watts graph: circular graph (see _gen_circular) plus random
+ * shortcuts, without self-loops.
+ *
+ * \param num_edges      - total number of edges (circular and shortcuts),
+ *                         size of `ia_edges`
+ * \param multigraph     - whether shortcuts can duplicate existing edges
+ *
+ * Other parameters are the same as in _gen_circular.
+ */
+void _gen_newman_watts(
+  int64_t* ia_edges, array_view<size_t> nodes, unsigned int coord_nb,
+  double reciprocity, bool closest, size_t num_edges, bool directed,
+  bool multigraph, long seed, unsigned int omp);
+
+
+/*
+ * Watts-Strogatz graph: each edge of a circular graph (see _gen_circular) is
+ * rewired with probability `proba`, keeping one of its ends and drawing the
+ * other one randomly, without creating duplicate edges or self-loops.
+ *
+ * \param ia_edges       - (E, 2) array, filled with the edges, where E is
+ *                         given by _circular_edge_nb
+ * \param proba          - rewiring probability
+ * \param shuffle        - end that is rewired: 0 for the targets, 1 for the
+ *                         sources, -1 for a random end
+ *
+ * Other parameters are the same as in _gen_circular.
+ */
+void _gen_watts_strogatz(
+  int64_t* ia_edges, array_view<size_t> nodes, unsigned int coord_nb,
+  double proba, double reciprocity, bool closest, int shuffle, bool directed,
+  long seed, unsigned int omp);
+
+
+/*
+ * Degree-preserving randomization of a graph through double edge swaps:
+ * (a, b) and (c, d) become (a, d) and (c, b), which preserves the in- and
+ * out-degrees, unless this creates a self-loop or a duplicate edge.
+ *
+ * Swaps are proposed by batches: the proposals of a batch are drawn and
+ * tested in parallel, then applied in order, skipping those which conflict
+ * with a previous swap of the batch.
+ *
+ * \param ia_edges       - (E, 2) array of edges, rewired in place
+ * \param num_edges      - number of edges E
+ * \param num_nodes      - upper bound on the node ids
+ * \param num_swaps      - number of proposed swaps
+ * \param directed       - whether the graph is directed
+ * \param groups         - group of each node (or nullptr): swaps only exchange
+ *                         targets from the same group, which preserves the
+ *                         number of edges between each pair of groups
+ * \param seed           - random seed
+ * \param omp            - number of OpenMP threads
+ *
+ * \return accepted      - number of swaps that were performed
+ */
+size_t _gen_edge_swaps(
+  int64_t* ia_edges, size_t num_edges, size_t num_nodes, size_t num_swaps,
+  bool directed, const int64_t* groups, long seed, unsigned int omp);
+
+
+/*
+ * Price (preferential attachment) network: nodes are added one after the
+ * other and each new node creates `m` edges (or as many as there are nodes
+ * already) towards different existing nodes, chosen with a probability
+ * proportional to ``degree^gamma + c``, where degree is the in-degree for
+ * directed graphs and the total degree otherwise.
+ *
+ * The attachment weights are stored in a Fenwick tree so that each target is
+ * drawn in O(log N). The growth is intrinsically sequential.
+ *
+ * \param edges          - filled with the edges, linearized (E, 2) array
+ * \param nodes          - ids of the nodes, in the order in which they are
+ *                         added
+ * \param m              - number of edges created by each new node
+ * \param c              - constant term of the attachment kernel
+ * \param gamma          - exponent of the attachment kernel
+ * \param reciprocity    - probability for each new directed edge to be
+ *                         reciprocated
+ * \param directed       - whether the graph is directed
+ * \param seed           - random seed
+ *
+ * \return num_edges     - number of edges created
+ */
+size_t _gen_price(
+  std::vector<int64_t>& edges, array_view<size_t> nodes,
+  unsigned int m, double c, double gamma, double reciprocity, bool directed,
+  long seed);
+
+
+/*
+ * Find the nodes that can be connected to each source, i.e. the targets which
+ * are located inside a square box of half-width `lim` around the source.
+ *
+ * The neighbours are stored in CSR format: the neighbours of source `i` are
+ * ``tgt_indices[tgt_offsets[i]:tgt_offsets[i+1]]``.
+ * Since the total number of neighbours is not known in advance, the function
+ * is usually called twice: first with `tgt_indices` set to NULL to compute
+ * the offsets, then with an array of size ``tgt_offsets[num_sources]``.
+ *
+ * \param source_nodes - array containing the ids of the source nodes
+ * \param target_nodes - array containing the ids of the target nodes
+ * \param x            - x coordinate of the neurons' positions
+ * \param y            - y coordinate of the neurons' positions
+ * \param lim          - half-width of the box around each source
+ * \param exclude_self - whether a source can be its own neighbour
+ * \param tgt_offsets  - (num_sources + 1) offsets of the neighbour lists
+ * \param tgt_indices  - neighbours of each source (NULL to only count)
+ * \param omp          - number of OpenMP threads
+ */
+void _box_neighbours(
+  array_view<size_t> source_nodes,
+  array_view<size_t> target_nodes, array_view<float> x,
+  array_view<float> y, float lim, bool exclude_self,
+  size_t* tgt_offsets, size_t* tgt_indices, unsigned int omp);
+
+
+/*
+ * Connection probability as a function of distance, one class per rule.
+ * They are used as template parameters so that the rule is chosen once,
+ * outside of the loops over the candidates.
+ *
+ * \param norm  - probability at zero distance
+ * \param scale - typical distance of the rule
+ */
+struct lin_rule
+{
+    lin_rule(float norm, float scale) : norm_(norm), inv_scale_(1. / scale) {}
+
+    inline float operator()(float distance) const
+    {
+        return norm_*std::max(0.f, 1.f - distance * inv_scale_);
+    }
+
+    float norm_, inv_scale_;
+};
+
+
+struct exp_rule
+{
+    exp_rule(float norm, float scale) : norm_(norm), inv_scale_(1. / scale) {}
+
+    inline float operator()(float distance) const
+    {
+        return norm_*std::exp(-distance * inv_scale_);
+    }
+
+    float norm_, inv_scale_;
+};
+
+
+struct gaussian_rule
+{
+    gaussian_rule(float norm, float scale)
+      : norm_(norm), inv_scale_(1. / scale) {}
+
+    inline float operator()(float distance) const
+    {
+        return norm_*std::exp(-0.5f*distance*distance*inv_scale_*inv_scale_);
+    }
+
+    float norm_, inv_scale_;
+};
+
+
+/*
+ * User-defined rule: returns the connection probability for a `distance`
+ * given the `scale` and `norm` (probability at zero distance) of the rule.
+ */
+typedef float (*distance_kernel)(float distance, float scale, float norm);
+
+
+struct kernel_rule
+{
+    kernel_rule(distance_kernel kernel, float norm, float scale)
+      : kernel_(kernel), norm_(norm), scale_(scale) {}
+
+    inline float operator()(float distance) const
+    {
+        return kernel_(distance, scale_, norm_);
+    }
+
+    distance_kernel kernel_;
+    float norm_, scale_;
+};
+
+
+/*
+ * Register a new rule that can then be used by _cdistance_rule through its
+ * `name` (the built-in rules "lin", "exp", and "gaussian" cannot be
+ * replaced).
+ * Rules must be registered before the generation and the kernel must be
+ * thread-safe.
+ *
+ * \param name   - name of the rule
+ * \param kernel - connection probability, NULL to remove the rule
+ * \param cutoff - distance, in units of the scale, beyond which the kernel
+ *                 is considered null: only the targets inside the square box
+ *                 of half-width cutoff*scale around each source are tested
+ */
+void _register_distance_rule(const std::string& name, distance_kernel kernel,
+                             float cutoff=10.);
+
+
+/*
+ * Return the kernel registered for `name`, or NULL.
+ */
+distance_kernel _get_distance_rule(const std::string& name);
+
+
+/*
+ * Cutoff of `rule` in units of the scale: 1 for "lin", 10 for "exp" and
+ * "gaussian", or the value given when the rule was registered.
+ */
+float _distance_rule_cutoff(const std::string& rule);
 
 
 static inline float _proba(
@@ -159,20 +1040,97 @@ static inline float _proba(
     switch (rule)
     {
         case 0:  // linear
-            p = norm*std::max(0., 1. - distance * inv_scale);
+            p = lin_rule(norm, 1. / inv_scale)(distance);
             break;
         case 1:  // exponential
-            p = norm*std::exp(-distance * inv_scale);
+            p = exp_rule(norm, 1. / inv_scale)(distance);
             break;
         case 2:  // gaussian
-            p = norm*std::exp(
-                -0.5* distance*distance * inv_scale*inv_scale);
+            p = gaussian_rule(norm, 1. / inv_scale)(distance);
             break;
     }
 
     return p;
 };
 
+
+// maximum number of candidates tested by one call to _proba_batch
+static const size_t DIST_BATCH = 64;
+
+
+/*
+ * Test a batch of candidate targets for a source.
+ *
+ * Positions are stored as a structure of arrays: coordinate `d` of node `n`
+ * is ``positions[d*num_positions + n]``.
+ * The coordinates of the candidates are first gathered into contiguous
+ * arrays, then distances and probabilities are computed in loops without
+ * branches that the compiler can vectorize, and the accepted candidates are
+ * finally compacted at the beginning of the output arrays.
+ *
+ * \param positions     - positions of the neurons (`ndim` x `num_positions`)
+ * \param ndim          - number of spatial dimensions
+ * \param num_positions - number of positions per dimension
+ * \param src           - source node
+ * \param candidates    - candidate targets (at most DIST_BATCH)
+ * \param uniforms      - one uniform random number in [0, 1) per candidate
+ * \param n             - number of candidates
+ * \param rule          - rule giving the probability for a distance
+ * \param accepted      - filled with the accepted targets
+ * \param distances     - filled with the distances of the accepted targets
+ *
+ * \return num_accepted
+ */
+template <class Rule>
+size_t _proba_batch(
+  const float* positions, unsigned int ndim, size_t num_positions,
+  size_t src, const size_t* candidates, const float* uniforms, size_t n,
+  const Rule& rule, size_t* accepted, float* distances)
+{
+    float delta[DIST_BATCH], dist[DIST_BATCH];
+    unsigned char keep[DIST_BATCH];
+
+    std::fill(dist, dist + n, 0.f);
+
+    // gather and accumulate the squared distances, one dimension at a time
+    for (unsigned int d=0; d < ndim; d++)
+    {
+        const float* coord = positions + d*num_positions;
+        const float cs     = coord[src];
+
+        for (size_t i=0; i < n; i++)
+        {
+            delta[i] = coord[candidates[i]] - cs;
+        }
+
+        #pragma omp simd
+        for (size_t i=0; i < n; i++)
+        {
+            dist[i] += delta[i]*delta[i];
+        }
+    }
+
+    // compute the distances and test the probabilities
+    #pragma omp simd
+    for (size_t i=0; i < n; i++)
+    {
+        dist[i] = std::sqrt(dist[i]);
+        keep[i] = rule(dist[i]) >= uniforms[i];
+    }
+
+    // compact (without branches)
+    size_t num_accepted = 0;
+
+    for (size_t i=0; i < n; i++)
+    {
+        accepted[num_accepted]  = candidates[i];
+        distances[num_accepted] = dist[i];
+        num_accepted += keep[i];
+    }
+
+    return num_accepted;
+}
+
 }
 
 #endif // FUNC_CONNECT_H
@@ -0,0 +1,579 @@
+// SPDX-FileCopyrightText: 2015-2023 Tanguy Fardet
+// SPDX-License-Identifier: GPL-3.0-or-later
+// nngt/generation/func_io.cpp
+//
+// Accelerated reading and writing of text graph files
+
+#include "func_io.h"
+
+#include <omp.h>
+
+#include <cstdio>   // snprintf
+#include <cstdlib>  // strtod
+#include <cstring>  // memchr
+#include <numeric>  // partial_sum
+#include <stdexcept>
+
+
+namespace generation {
+
+// minimal number of bytes in each chunk of a parsed file
+const size_t MIN_CHUNK_BYTES = 1 << 20;
+
+// longest number that is parsed from a stack buffer
+const size_t MAX_NUMBER_CHARS = 63;
+
+
+/*
+ * Parsing
+ */
+
+typedef std::pair<const char*, const char*> token;
+
+
+// options which are common to all the lines of a file
+struct _line_format
+{
+    bool neighbour;
+    char separator;
+    char secondary;
+    std::string notifier;
+    std::string ignore;
+    size_t num_attributes;
+};
+
+
+// error in a line, converted to an exception with the line number
+struct _line_error
+{
+    const char* line;
+    std::string what;
+};
+
+
+static inline bool _is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\v'
+           || c == '\f';
+}
+
+
+static inline void _strip(const char*& first, const char*& last)
+{
+    while (first != last && _is_space(*first))
+    {
+        first++;
+    }
+
+    while (last != first && _is_space(*(last - 1)))
+    {
+        last--;
+    }
+}
+
+
+static inline bool _starts_with(const char* first, const char* last,
+                                const std::string& prefix)
+{
+    return (size_t) (last - first) >= prefix.size()
+           && std::equal(prefix.begin(), prefix.end(), first);
+}
+
+
+/*
+ * Split [first, last) at each `sep`; empty tokens are skipped if
+ * `collapse` is true, like repeated separators in the Python parser.
+ */
+static inline void _split(const char* first, const char* last, char sep,
+                          bool collapse, std::vector<token>& tokens)
+{
+    tokens.clear();
+
+    while (true)
+    {
+        const char* end = static_cast<const char*>(
+            memchr(first, sep, last - first));
+
+        if (end == nullptr)
+        {
+            end = last;
+        }
+
+        if (!collapse || end != first)
+        {
+            tokens.push_back(token(first, end));
+        }
+
+        if (end == last)
+        {
+            return;
+        }
+
+        first = end + 1;
+    }
+}
+
+
+static int64_t _parse_int(token tok)
+{
+    const char* first = tok.first;
+    const char* last  = tok.second;
+
+    _strip(first, last);
+
+    bool negative = false;
+
+    if (first != last && (*first == '-' || *first == '+'))
+    {
+        negative = (*first == '-');
+        first++;
+    }
+
+    if (first == last)
+    {
+        throw std::invalid_argument("missing node.");
+    }
+
+    uint64_t value = 0;
+
+    const uint64_t limit = std::numeric_limits<int64_t>::max();
+
+    for (; first != last; first++)
+    {
+        const unsigned digit = *first - '0';
+
+        if (digit > 9)
+        {
+            throw std::invalid_argument("invalid node '"
+                                        + std::string(tok.first, tok.second)
+                                        + "'.");
+        }
+
+        if (value > (limit - digit) / 10)
+        {
+            throw std::invalid_argument("node out of range.");
+        }
+
+        value = 10*value + digit;
+    }
+
+    return negative ? -static_cast<int64_t>(value)
+                    : static_cast<int64_t>(value);
+}
+
+
+static double _parse_double(token tok)
+{
+    const char* first = tok.first;
+    const char* last  = tok.second;
+
+    _strip(first, last);
+
+    const size_t length = last - first;
+
+    // strtod needs a null-terminated string: the token is copied since the
+    // buffer may end right after it
+    char local[MAX_NUMBER_CHARS + 1];
+    std::string large;
+
+    char* str = local;
+
+    if (length > MAX_NUMBER_CHARS)
+    {
+        large.assign(first, last);
+        str = &large[0];
+    }
+    else
+    {
+        std::copy(first, last, local);
+        local[length] = '\0';
+    }
+
+    char* end = nullptr;
+
+    double value = strtod(str, &end);
+
+    if (length == 0 || end != str + length)
+    {
+        throw std::invalid_argument("invalid attribute value '"
+                                    + std::string(tok.first, tok.second)
+                                    + "'.");
+    }
+
+    return value;
+}
+
+
+/*
+ * Process the line [first, last) and return its number of edges, which are
+ * parsed into `edges` and `attr` if `fill` is true.
+ */
+template <bool fill>
+static size_t _process_line(const char* first, const char* last,
+                            const _line_format& fmt, int64_t* edges,
+                            double* attr, std::vector<token>& tokens,
+                            std::vector<token>& values)
+{
+    _strip(first, last);
+
+    if (first == last || _starts_with(first, last, fmt.notifier)
+        || _starts_with(first, last, fmt.ignore))
+    {
+        return 0;
+    }
+
+    const size_t num_attr = fmt.num_attributes;
+
+    if (fmt.neighbour)
+    {
+        const char* delim = static_cast<const char*>(
+            memchr(first, fmt.separator, last - first));
+
+        // nodes without neighbours
+        if (delim == nullptr || delim == first)
+        {
+            return 0;
+        }
+
+        _split(delim + 1, last, fmt.separator, true, tokens);
+
+        if (fill)
+        {
+            const int64_t source = _parse_int(token(first, delim));
+
+            for (size_t i=0; i < tokens.size(); i++)
+            {
+                _split(tokens[i].first, tokens[i].second, fmt.secondary,
+                       false, values);
+
+                if (values.size() < num_attr + 1)
+                {
+                    throw std::invalid_argument("missing attributes.");
+                }
+
+                edges[2*i]     = source;
+                edges[2*i + 1] = _parse_int(values[0]);
+
+                for (size_t j=0; j < num_attr; j++)
+                {
+                    attr[i*num_attr + j] = _parse_double(values[j + 1]);
+                }
+            }
+        }
+
+        return tokens.size();
+    }
+
+    if (fill)
+    {
+        _split(first, last, fmt.separator, true, tokens);
+
+        if (tokens.size() < 2)
+        {
+            throw std::invalid_argument("missing target.");
+        }
+
+        edges[0] = _parse_int(tokens[0]);
+        edges[1] = _parse_int(tokens[1]);
+
+        if (num_attr == 0)
+        {
+            return 1;
+        }
+
+        if (tokens.size() == 3 && memchr(tokens[2].first, fmt.secondary,
+                                         tokens[2].second - tokens[2].first))
+        {
+            // attributes separated by the secondary separator
+            _split(tokens[2].first, tokens[2].second, fmt.secondary, false,
+                   values);
+
+            if (values.size() < num_attr)
+            {
+                throw std::invalid_argument("missing attributes.");
+            }
+        }
+        else if (tokens.size() == num_attr + 2)
+        {
+            // one column per attribute
+            values.assign(tokens.begin() + 2, tokens.end());
+        }
+        else
+        {
+            throw std::invalid_argument("wrong number of attributes.");
+        }
+
+        for (size_t j=0; j < num_attr; j++)
+        {
+            attr[j] = _parse_double(values[j]);
+        }
+    }
+
+    return 1;
+}
+
+
+template <bool fill>
+static size_t _process_chunk(const char* first, const char* last,
+                             const _line_format& fmt, int64_t* edges,
+                             double* attr)
+{
+    std::vector<token> tokens, values;
+
+    size_t count = 0;
+
+    while (first < last)
+    {
+        const char* eol = static_cast<const char*>(
+            memchr(first, '\n', last - first));
+
+        if (eol == nullptr)
+        {
+            eol = last;
+        }
+
+        try
+        {
+            count += _process_line<fill>(
+                first, eol, fmt, fill ? edges + 2*count : nullptr,
+                fill ? attr + fmt.num_attributes*count : nullptr, tokens,
+                values);
+        }
+        catch (std::invalid_argument& e)
+        {
+            throw _line_error({first, e.what()});
+        }
+
+        first = eol + 1;
+    }
+
+    return count;
+}
+
+
+size_t _parse_edges(const char* buffer, size_t size, bool neighbour,
+                    char separator, char secondary,
+                    const std::string& notifier, const std::string& ignore,
+                    size_t num_attributes, std::vector<int64_t>& edges,
+                    std::vector<double>& attributes, unsigned int omp)
+{
+    const _line_format fmt = {
+        neighbour, separator, secondary, notifier, ignore, num_attributes
+    };
+
+    // newline-aligned chunks
+    const size_t num_chunks = std::max(
+        (size_t) 1, std::min((size_t) 4*omp, size / MIN_CHUNK_BYTES));
+
+    std::vector<size_t> bounds(num_chunks + 1, size);
+
+    bounds[0] = 0;
+
+    for (size_t c=1; c < num_chunks; c++)
+    {
+        size_t start = std::max(c*(size / num_chunks), bounds[c - 1]);
+
+        const char* eol = static_cast<const char*>(
+            memchr(buffer + start, '\n', size - start));
+
+        bounds[c] = (eol == nullptr) ? size : eol - buffer + 1;
+    }
+
+    // count the edges of each chunk to get their offset in the outputs
+    std::vector<size_t> offsets(num_chunks + 1, 0);
+
+    #pragma omp parallel for num_threads(omp) schedule(dynamic, 1)
+    for (size_t c=0; c < num_chunks; c++)
+    {
+        offsets[c + 1] = _process_chunk<false>(
+            buffer + bounds[c], buffer + bounds[c + 1], fmt, nullptr,
+            nullptr);
+    }
+
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+    const size_t num_edges = offsets[num_chunks];
+
+    edges.resize(2*num_edges);
+    attributes.resize(num_attributes*num_edges);
+
+    // parse, keeping the first error of each chunk
+    std::vector<_line_error> errors(num_chunks, _line_error({nullptr, ""}));
+
+    #pragma omp parallel for num_threads(omp) schedule(dynamic, 1)
+    for (size_t c=0; c < num_chunks; c++)
+    {
+        try
+        {
+            _process_chunk<true>(
+                buffer + bounds[c], buffer + bounds[c + 1], fmt,
+                edges.data() + 2*offsets[c],
+                attributes.data() + num_attributes*offsets[c]);
+        }
+        catch (_line_error& err)
+        {
+            errors[c] = err;
+        }
+    }
+
+    for (const _line_error& err : errors)
+    {
+        if (err.line != nullptr)
+        {
+            const size_t line = 1 + std::count(buffer, err.line, '\n');
+
+            throw std::invalid_argument(
+                "Line " + std::to_string(line) + ": " + err.what);
+        }
+    }
+
+    return num_edges;
+}
+
+
+/*
+ * Formatting
+ */
+
+static inline void _append_int(std::string& out, int64_t value)
+{
+    // digits are written backwards from the end of the buffer
+    char buf[24];
+    char* pos = buf + sizeof(buf);
+
+    uint64_t mag = value < 0 ? -static_cast<uint64_t>(value) : value;
+
+    do
+    {
+        *--pos = '0' + mag % 10;
+        mag   /= 10;
+    }
+    while (mag);
+
+    if (value < 0)
+    {
+        *--pos = '-';
+    }
+
+    out.append(pos, buf + sizeof(buf) - pos);
+}
+
+
+static inline void _append_double(std::string& out, double value)
+{
+    if (std::isnan(value))
+    {
+        out += "nan";
+        return;
+    }
+
+    if (std::isinf(value))
+    {
+        out += value > 0 ? "inf" : "-inf";
+        return;
+    }
+
+    // shortest precision that reads back to the same value
+    char buf[32];
+    int length = 0;
+
+    for (int precision=15; precision <= 17; precision++)
+    {
+        length = snprintf(buf, sizeof(buf), "%.*g", precision, value);
+
+        if (precision == 17 || strtod(buf, nullptr) == value)
+        {
+            break;
+        }
+    }
+
+    out.append(buf, length);
+
+    // keep real numbers distinct from integers, as in Python
+    if (std::find_if(buf, buf + length,
+                     [](char c) { return c == '.' || c == 'e'; })
+        == buf + length)
+    {
+        out += ".0";
+    }
+}
+
+
+void _format_edges(array_view<int64_t> edges, array_view<double> attributes,
+                   array_view<uint8_t> integer, const std::string& separator,
+                   const std::string& secondary, size_t first, size_t last,
+                   std::string& out, unsigned int omp)
+{
+    const size_t num_edges = edges.size() / 2;
+    const size_t num_attr  = integer.size();
+
+    if (attributes.size() != num_attr*num_edges)
+    {
+        throw std::invalid_argument("`attributes` must contain one value per "
+                                    "edge and attribute.");
+    }
+
+    last = std::min(last, num_edges);
+
+    if (first >= last)
+    {
+        return;
+    }
+
+    // one contiguous block of lines per thread
+    const size_t num_blocks = std::min((size_t) omp, last - first);
+
+    std::vector<std::string> blocks(num_blocks);
+
+    #pragma omp parallel for num_threads(omp) schedule(static, 1)
+    for (size_t b=0; b < num_blocks; b++)
+    {
+        const size_t lo = first + (last - first)*b / num_blocks;
+        const size_t hi = first + (last - first)*(b + 1) / num_blocks;
+
+        std::string& text = blocks[b];
+
+        text.reserve((hi - lo)*(16 + 12*num_attr));
+
+        for (size_t e=lo; e < hi; e++)
+        {
+            _append_int(text, edges[2*e]);
+            text += separator;
+            _append_int(text, edges[2*e + 1]);
+
+            for (size_t j=0; j < num_attr; j++)
+            {
+                text += (j == 0) ? separator : secondary;
+
+                const double value = attributes[e*num_attr + j];
+
+                if (integer[j])
+                {
+                    _append_int(text, static_cast<int64_t>(value));
+                }
+                else
+                {
+                    _append_double(text, value);
+                }
+            }
+
+            text += '\n';
+        }
+    }
+
+    size_t total = out.size();
+
+    for (const std::string& text : blocks)
+    {
+        total += text.size();
+    }
+
+    out.reserve(total);
+
+    for (const std::string& text : blocks)
+    {
+        out += text;
+    }
+}
+
+}
@@ -0,0 +1,77 @@
+// SPDX-FileCopyrightText: 2015-2023 Tanguy Fardet
+// SPDX-License-Identifier: GPL-3.0-or-later
+// nngt/generation/func_io.h
+//
+// Accelerated reading and writing of text graph files
+
+#ifndef FUNC_IO_H
+#define FUNC_IO_H
+
+#include "func_connect.h"
+
+
+namespace generation {
+
+/*
+ * Parse the edges of an "edge_list" or "neighbour" file.
+ *
+ * The buffer (usually a memory-mapped file) is split into newline-aligned
+ * chunks which are processed in parallel: the edges of each chunk are first
+ * counted, then parsed directly at their final position in the outputs.
+ * Lines follow the rules of the Python parser: repeated separators are
+ * collapsed, surrounding whitespace is ignored and empty lines, as well as
+ * lines starting with the notifier or the ignore string, are skipped.
+ *
+ * \param buffer         - content of the file
+ * \param size           - number of bytes in `buffer`
+ * \param neighbour      - whether the file uses the "neighbour" format
+ *                         (``source target;attr... target;attr...``) or the
+ *                         "edge_list" one (``source target attrs``, with the
+ *                         attributes separated by `secondary` or given as
+ *                         additional columns)
+ * \param separator      - separator between the entries of a line
+ * \param secondary      - separator between the attributes of an edge
+ * \param notifier       - prefix of the lines containing graph information
+ * \param ignore         - prefix of the lines that should be ignored
+ * \param num_attributes - number of (numeric) attributes of each edge
+ * \param edges          - filled with the linearized (E, 2) edges
+ * \param attributes     - filled with the linearized (E, num_attributes)
+ *                         attribute values
+ * \param omp            - number of OpenMP threads
+ *
+ * \return num_edges     - number of edges
+ */
+size_t _parse_edges(const char* buffer, size_t size, bool neighbour,
+                    char separator, char secondary,
+                    const std::string& notifier, const std::string& ignore,
+                    size_t num_attributes, std::vector<int64_t>& edges,
+                    std::vector<double>& attributes, unsigned int omp);
+
+
+/*
+ * Format edges [first, last) as lines of an "edge_list" file:
+ * ``source{separator}target{separator}attr1{secondary}attr2...\n``.
+ *
+ * Real values are written with the shortest representation that reads back
+ * to the same number, integer attributes as integers; each thread formats a
+ * contiguous block of lines.
+ *
+ * \param edges          - linearized (E, 2) array of the edges
+ * \param attributes     - linearized (E, k) array of the attribute values
+ * \param integer        - array of size k, whether each attribute is an
+ *                         integer (nonzero) or a real number (0)
+ * \param separator      - separator between the entries of a line
+ * \param secondary      - separator between the attributes of an edge
+ * \param first          - first edge to format
+ * \param last           - edge after the last one to format
+ * \param out            - string to which the lines are appended
+ * \param omp            - number of OpenMP threads
+ */
+void _format_edges(array_view<int64_t> edges, array_view<double> attributes,
+                   array_view<uint8_t> integer, const std::string& separator,
+                   const std::string& secondary, size_t first, size_t last,
+                   std::string& out, unsigned int omp);
+
+}
+
+#endif // FUNC_IO_H
@@ -13,6 +13,7 @@ import numpy as np
 import nngt
 from nngt.geometry.geom_utils import conversion_magnitude
 from nngt.lib.connect_tools import (_set_options, _connect_ccs,
+                                    _connected_components,
                                     _independent_edges)
 from nngt.lib.logger import _log_message
 from nngt.lib.test_functions import (mpi_checker, mpi_random, deprecated,
@@ -97,6 +98,28 @@ if nngt.get_config("mpi"):
         raise e
 
 
+# -------------- #
+# Edge streaming #
+# -------------- #
+
+def _streaming_kwargs(graph):
+    '''
+    Arguments making the multithreaded generators add the edges to `graph`
+    by batches as they are generated instead of returning them all at once
+    (empty if the C++ algorithms are not used).
+    '''
+    if not using_mt_algorithms:
+        return {}
+
+    def add_edges(edges, distances):
+        attr = {} if distances is None else {"distance": distances}
+
+        graph.new_edges(edges, attributes=attr, check_duplicates=False,
+                        check_self_loops=False, check_existing=False)
+
+    return {"edge_callback": add_edges}
+
+
 # ----------------------------- #
 # Specific degree distributions #
 # ----------------------------- #
@@ -164,7 +187,7 @@ def all_to_all(nodes=0, weighted=True, directed=True, multigraph=False,
 def from_degree_list(degrees, degree_type='in', weighted=True,
                      directed=True, multigraph=False, name="DL",
                      shape=None, positions=None, population=None,
-                     from_graph=None, **kwargs):
+                     from_graph=None, max_rounds=1000, **kwargs):
     """
     Generate a random graph from a given list of degrees.
 
@@ -193,6 +216,10 @@ def from_degree_list(degrees, degree_type='in', weighted=True,
         :class:`~nngt.Network`).
     from_graph : :class:`Graph` or subclass, optional (default: None)
         Initial graph whose nodes are to be connected.
+    max_rounds : int, optional (default: 1000)
+        For undirected graphs or ``'total'`` degrees, maximum number of
+        random matching rounds before the generation is aborted with a
+        :class:`RuntimeError` (use None to remove the limit).
 
     Returns
     -------
@@ -225,8 +252,10 @@ def from_degree_list(degrees, degree_type='in', weighted=True,
     if nodes > 1:
         ids = np.arange(nodes, dtype=np.uint)
         ia_edges = _from_degree_list(ids, ids, degrees, degree_type,
-                                     directed=directed, multigraph=multigraph)
-        # check for None if MPI
+                                     directed=directed, multigraph=multigraph,
+                                     max_rounds=max_rounds,
+                                     **_streaming_kwargs(graph_dl))
+        # check for None if MPI or if the edges were streamed
         if ia_edges is not None:
             graph_dl.new_edges(ia_edges, check_duplicates=False,
                                check_self_loops=False, check_existing=False)
@@ -307,8 +336,9 @@ def fixed_degree(degree, degree_type='in', nodes=0, reciprocity=-1.,
         ids = np.arange(nodes, dtype=np.uint)
         ia_edges = _fixed_degree(
             ids, ids, degree, degree_type, reciprocity=reciprocity,
-            directed=directed, multigraph=multigraph)
-        # check for None if MPI
+            directed=directed, multigraph=multigraph,
+            **_streaming_kwargs(graph_fd))
+        # check for None if MPI or if the edges were streamed
         if ia_edges is not None:
             graph_fd.new_edges(ia_edges, check_duplicates=False,
                                check_self_loops=False, check_existing=False)
@@ -392,8 +422,9 @@ def gaussian_degree(avg, std, degree_type='in', nodes=0, reciprocity=-1.,
         ids = np.arange(nodes, dtype=np.uint)
         ia_edges = _gaussian_degree(
             ids, ids, avg, std, degree_type, reciprocity=reciprocity,
-            directed=directed, multigraph=multigraph)
-        # check for None if MPI
+            directed=directed, multigraph=multigraph,
+            **_streaming_kwargs(graph_gd))
+        # check for None if MPI or if the edges were streamed
         if ia_edges is not None:
             graph_gd.new_edges(ia_edges, check_duplicates=False,
                                check_self_loops=False, check_existing=False)
@@ -410,7 +441,8 @@ def gaussian_degree(avg, std, degree_type='in', nodes=0, reciprocity=-1.,
 def erdos_renyi(density=None, nodes=0, edges=None, avg_deg=None,
                 reciprocity=-1., weighted=True, directed=True,
                 multigraph=False, name="ER", shape=None, positions=None,
-                population=None, from_graph=None, **kwargs):
+                population=None, from_graph=None, exact_edge_nb=True,
+                **kwargs):
     """
     Generate a random graph as defined by Erdos and Renyi but with a
     reciprocity that can be chosen.
@@ -418,8 +450,10 @@ def erdos_renyi(density=None, nodes=0, edges=None, avg_deg=None,
     Parameters
     ----------
     density : double, optional (default: -1.)
-        Structural density given by `edges / nodes`:math:`^2`. It is also the
-        probability for each possible edge in the graph to exist.
+        Structural density given by `edges / nodes`:math:`^2`, which sets the
+        number of edges of the default :math:`G(n, m)` model, for directed
+        and undirected graphs alike. If `exact_edge_nb` is False, it is
+        instead the probability for each possible edge to exist (see below).
     nodes : int, optional (default: None)
         The number of nodes in the graph.
     edges : int (optional)
@@ -448,6 +482,15 @@ def erdos_renyi(density=None, nodes=0, edges=None, avg_deg=None,
         :class:`~nngt.Network`).
     from_graph : :class:`Graph` or subclass, optional (default: None)
         Initial graph whose nodes are to be connected.
+    exact_edge_nb : bool, optional (default: True)
+        Whether the number of edges is fixed (:math:`G(n, m)` model). If
+        False and `density` is provided, each possible edge exists
+        independently with probability `density` (:math:`G(n, p)` model), so
+        the number of edges is only fixed on average.
+        For :math:`N` nodes, there are :math:`N(N - 1)` possible edges in a
+        directed graph but only :math:`N(N - 1)/2` in an undirected one,
+        which therefore gets about half the :math:`density N^2` edges of the
+        :math:`G(n, m)` model.
 
     Returns
     -------
@@ -479,7 +522,8 @@ def erdos_renyi(density=None, nodes=0, edges=None, avg_deg=None,
     if nodes > 1:
         ids = range(nodes)
         ia_edges = _erdos_renyi(ids, ids, density, edges, avg_deg, reciprocity,
-                                directed, multigraph)
+                                directed, multigraph,
+                                exact_edge_nb=exact_edge_nb)
         graph_er.new_edges(ia_edges, check_duplicates=False,
                            check_self_loops=False, check_existing=False)
 
@@ -1266,7 +1310,7 @@ def sparse_clustered(c, nodes=0, edges=None, avg_deg=None, connected=True,
             disconnected = True
 
             while disconnected:
-                cids, hist = nngt.analysis.connected_components(graph_fc)
+                cids, hist = _connected_components(graph_fc)
 
                 disconnected = len(hist) > 1
 
@@ -1547,9 +1591,10 @@ def distance_rule(scale, rule="exp", shape=None, neuron_density=1000.,
         ids = np.arange(0, nodes, dtype=np.uint)
         ia_edges = _distance_rule(
             ids, ids, density, edges, avg_deg, scale, rule, max_proba, shape,
-            positions, directed, multigraph, distance=distance, **kwargs)
+            positions, directed, multigraph, distance=distance,
+            **_streaming_kwargs(graph_dr), **kwargs)
         attr = {'distance': distance}
-        # check for None if MPI
+        # check for None if MPI or if the edges were streamed
         if ia_edges is not None:
             graph_dr.new_edges(ia_edges, attributes=attr,
                                check_duplicates=False, check_self_loops=False,
@@ -19,6 +19,17 @@ from nngt.lib.connect_tools import *
 from . import connect_algorithms
 from .connect_algorithms import *
 
+try:
+    from .cconnect import _spatial_neighbours, _neighbour_number, _rule_cutoff
+    from .cconnect import _distance_rule as _compiled_distance_rule
+    from .cconnect import _from_degree_list as _compiled_degree_list
+except ImportError:
+    _spatial_neighbours     = None
+    _neighbour_number       = None
+    _rule_cutoff            = None
+    _compiled_distance_rule = None
+    _compiled_degree_list   = None
+
 
 __all__ = connect_algorithms.__all__
 
@@ -65,6 +76,39 @@ def _from_degree_list(source_ids, target_ids, degrees, degree_type="in",
     b_one_pop = _check_num_edges(
         source_ids, target_ids, edges, directed, multigraph)
 
+    if _compiled_degree_list is not None:
+        # C++ generation of the local edges (multithreaded); nodes use their
+        # own random streams from a seed shared by all processes, so their
+        # edges do not depend on the number of processes
+        ia_edges = _compiled_degree_list(
+            source_ids.astype(np.uint), target_ids.astype(np.uint), degrees,
+            degree_type=degree_type, directed=True, multigraph=multigraph,
+            existing_edges=existing_edges, seed=_shared_seed(comm))
+    else:
+        ia_edges = _py_degree_list(source_ids, target_ids, degrees, b_out,
+                                   multigraph, existing_edges)
+
+    comm.Barrier()
+
+    _finalize_random(rank)
+
+    # the 'nngt' backend is made to be distributed, but the others are not
+    if nngt.get_config("backend") == "nngt":
+        return ia_edges
+    else:
+        # all the data is gather on the root processus
+        ia_edges  = comm.gather(ia_edges, root=0)
+        if rank == 0:
+            ia_edges = np.concatenate(ia_edges, axis=0)
+            return ia_edges
+        else:
+            return None
+
+
+def _py_degree_list(source_ids, target_ids, degrees, b_out, multigraph,
+                    existing_edges):
+    ''' Local edges of `_from_degree_list` without the compiled module '''
+    edges      = np.sum(degrees)
     num_etotal = 0
     ia_edges   = np.zeros((edges, 2), dtype=int)
     idx        = 0 if b_out else 1  # differenciate source / target
@@ -101,21 +145,7 @@ def _from_degree_list(source_ids, target_ids, degrees, degree_type="in",
         ia_edges[num_etotal:num_etotal+ecurrent, int(not idx)] = variables_i
         num_etotal += ecurrent
 
-    comm.Barrier()
-
-    _finalize_random(rank)
-
-    # the 'nngt' backend is made to be distributed, but the others are not
-    if nngt.get_config("backend") == "nngt":
-        return ia_edges
-    else:
-        # all the data is gather on the root processus
-        ia_edges  = comm.gather(ia_edges, root=0)
-        if rank == 0:
-            ia_edges = np.concatenate(ia_edges, axis=0)
-            return ia_edges
-        else:
-            return None
+    return ia_edges
 
 
 def _fixed_degree(source_ids, target_ids, degree, degree_type="in",
@@ -182,7 +212,18 @@ def _distance_rule(source_ids, target_ids, density=-1, edges=-1, avg_deg=-1,
                    distance=None, **kwargs):
     '''
     Returns a distance-rule graph
+
+    Directed graphs are generated by spatial tiles with the compiled
+    algorithms (see :func:`_tiled_distance_rule`), otherwise the sources are
+    distributed in a round-robin fashion and the edges are filtered on the
+    root process.
     '''
+    if directed and _compiled_distance_rule is not None:
+        return _tiled_distance_rule(
+            source_ids, target_ids, density=density, edges=edges,
+            avg_deg=avg_deg, scale=scale, rule=rule, max_proba=max_proba,
+            positions=positions, multigraph=multigraph, distance=distance)
+
     assert max_proba <= 0, "MPI distance_rule cannot use `max_proba` yet."
 
     distance     = [] if distance is None else distance
@@ -206,16 +247,10 @@ def _distance_rule(source_ids, target_ids, density=-1, edges=-1, avg_deg=-1,
     # for each node, check the neighbours that are in an area where
     # connections can be made: ± scale for lin, ± 10*scale for exp.
     # Get the sources and associated targets for each MPI process
-    sources = []
-    targets = []
-    lim = scale if rule == 'lin' else 10*scale
-    for s in source_ids[rank::size]:
-        keep  = (np.abs(positions[0, target_ids] - positions[0, s]) < lim)
-        keep *= (np.abs(positions[1, target_ids] - positions[1, s]) < lim)
-        if b_one_pop:
-            keep[s] = 0
-        sources.append(s)
-        targets.append(target_ids[keep])
+    lim = _rule_limit(rule, scale)
+
+    sources = source_ids[rank::size]
+    targets = _local_neighbours(sources, target_ids, positions, lim, b_one_pop)
 
     # the number of trials should be done depending on total number of
     # neighbours available, so we compute this number
@@ -317,6 +352,107 @@ def _distance_rule(source_ids, target_ids, density=-1, edges=-1, avg_deg=-1,
             return None
 
 
+def _tiled_distance_rule(source_ids, target_ids, density=None, edges=None,
+                         avg_deg=None, scale=-1, rule="exp", max_proba=-1.,
+                         positions=None, multigraph=False, distance=None):
+    '''
+    Directed distance-rule graph generated by spatial domain decomposition.
+
+    Each process gets a tile of sources containing about the same number of
+    nodes, together with the targets in a halo around it, and generates the
+    edges of these sources with the C++ algorithm (multithreaded inside each
+    process).
+    For a fixed number of edges, the share of each process is proportional
+    to its number of neighbours, so that all neighbours are tested the same
+    way as in the sequential algorithm; these shares are computed on all
+    processes from an allreduce of the local counts.
+    Since each source is owned by a single process, no edges need to be
+    checked across processes.
+
+    Edges are then balanced across processes by a single all-to-all exchange
+    and kept distributed with the 'nngt' backend, or gathered on the root
+    process for the other backends.
+    '''
+    distance = [] if distance is None else distance
+
+    comm, size, rank = _mpi_and_random_init()
+
+    source_ids = np.asarray(source_ids, dtype=np.uint)
+    target_ids = np.asarray(target_ids, dtype=np.uint)
+    positions  = np.asarray(positions, dtype=np.float32)
+
+    num_edges = 0
+
+    if max_proba <= 0:
+        num_edges, _ = _compute_connections(
+            len(source_ids), len(target_ids), density, edges, avg_deg, True,
+            reciprocity=-1)
+
+    b_one_pop = _check_num_edges(
+        source_ids, target_ids, num_edges, True, multigraph)
+
+    num_neurons = len(set(np.concatenate((source_ids, target_ids))))
+
+    # local sources and the targets that they can reach
+    lim = _rule_limit(rule, scale)
+
+    sources = _spatial_tiles(source_ids, positions, size)[rank]
+    targets = _halo(sources, target_ids, positions, lim)
+
+    kwargs = {
+        "scale": scale, "rule": rule, "max_proba": max_proba,
+        "positions": positions, "directed": True, "multigraph": multigraph,
+        "num_neurons": num_neurons, "exclude_self": b_one_pop,
+    }
+
+    generate = len(sources) > 0
+
+    if max_proba <= 0:
+        # local number of edges, proportional to the local neighbours
+        counts = np.zeros(size, dtype=np.int64)
+
+        if generate:
+            counts[rank] = _neighbour_number(
+                sources, targets, positions, lim, exclude_self=b_one_pop)
+
+        comm.Allreduce(MPI.IN_PLACE, counts, op=MPI.SUM)
+
+        assert counts.sum() > num_edges, \
+            "Scale is too small: there are not enough close neighbours to " +\
+            "create the required number of connections. Increase `scale` " +\
+            "or `neuron_density`."
+
+        kwargs["edges"] = _quotas(counts, num_edges)[rank]
+
+        generate = kwargs["edges"] > 0
+
+    local_dist  = []
+    local_edges = np.zeros((0, 2), dtype=np.int64)
+
+    if generate:
+        local_edges = _compiled_distance_rule(
+            sources, targets, distance=local_dist, **kwargs)
+
+    _finalize_random(rank)
+
+    local_edges, local_dist = _exchange_edges(comm, local_edges, local_dist)
+
+    # the 'nngt' backend is made to be distributed, but the others are not
+    if nngt.get_config("backend") == "nngt":
+        distance.extend(local_dist)
+        return local_edges
+
+    # all the data is gathered on the root process
+    local_edges = comm.gather(local_edges, root=0)
+    local_dist  = comm.gather(local_dist, root=0)
+
+    if rank == 0:
+        distance.extend(np.concatenate(local_dist))
+        return np.concatenate(local_edges, axis=0)
+
+    return None
+
+
 # --------------------- #
 # Unavailable functions #
 # --------------------- #
@@ -374,6 +510,154 @@ def _mpi_and_random_init():
     return comm, size, rank
 
 
+def _shared_seed(comm):
+    '''
+    Seed drawn on the root process (after _mpi_and_random_init) and
+    broadcast to all processes.
+    '''
+    seed = np.random.randint(0, 2**31 - 1) if comm.Get_rank() == 0 else None
+
+    return comm.bcast(seed, root=0)
+
+
+def _rule_limit(rule, scale):
+    '''
+    Half-width of the box where connections can be made for `rule`, using
+    the cutoff declared in the C++ rule registry if it was compiled.
+    '''
+    if _rule_cutoff is not None:
+        return _rule_cutoff(rule)*scale
+
+    return scale if rule == 'lin' else 10*scale
+
+
+def _local_neighbours(sources, target_ids, positions, lim, exclude_self):
+    '''
+    Return the list of targets that are inside the box of half-width `lim`
+    around each source, using the C++ spatial grid if it was compiled.
+    '''
+    if _spatial_neighbours is not None:
+        return _spatial_neighbours(
+            np.asarray(sources, dtype=np.uint),
+            np.asarray(target_ids, dtype=np.uint),
+            np.asarray(positions, dtype=np.float32), lim,
+            exclude_self=exclude_self)
+
+    targets = []
+
+    for s in sources:
+        keep  = (np.abs(positions[0, target_ids] - positions[0, s]) < lim)
+        keep *= (np.abs(positions[1, target_ids] - positions[1, s]) < lim)
+
+        if exclude_self:
+            keep *= (target_ids != s)
+
+        targets.append(target_ids[keep])
+
+    return targets
+
+
+def _spatial_tiles(source_ids, positions, size):
+    '''
+    Split `source_ids` into `size` tiles containing about the same number of
+    sources: the plane is cut into vertical strips which are then cut into
+    rectangles.
+    The split is deterministic, so all processes compute the same one.
+    '''
+    # nx * ny = size strips and rectangles per strip, as square as possible
+    nx = int(np.sqrt(size))
+
+    while size % nx:
+        nx -= 1
+
+    ny = size // nx
+
+    x = positions[0, source_ids]
+    y = positions[1, source_ids] if len(positions) > 1 else np.zeros(len(x))
+
+    tiles = []
+
+    for strip in np.array_split(np.argsort(x, kind="stable"), nx):
+        strip = strip[np.argsort(y[strip], kind="stable")]
+
+        tiles.extend(source_ids[np.sort(t)] for t in np.array_split(strip, ny))
+
+    return tiles
+
+
+def _halo(sources, target_ids, positions, lim):
+    '''
+    Targets inside the bounding box of `sources`, extended by `lim`, on the
+    first two coordinates (i.e. all the targets that the sources can reach).
+    '''
+    if len(sources) == 0:
+        return target_ids[:0]
+
+    keep = np.ones(len(target_ids), dtype=bool)
+
+    for coord in positions[:2]:
+        src = coord[sources]
+        tgt = coord[target_ids]
+
+        keep &= (tgt > src.min() - lim) & (tgt < src.max() + lim)
+
+    return target_ids[keep]
+
+
+def _quotas(counts, total):
+    '''
+    Split `total` proportionally to `counts`, using the largest remainders
+    so that the quotas sum to `total`.
+    '''
+    exact  = counts * (total / counts.sum())
+    quotas = np.floor(exact).astype(np.int64)
+
+    missing = int(total - quotas.sum())
+
+    quotas[np.argsort(quotas - exact, kind="stable")[:missing]] += 1
+
+    return quotas
+
+
+def _exchange_edges(comm, edges, distances):
+    '''
+    Redistribute the edges and their distances so that process `i` gets the
+    edges ``i*E // size`` to ``(i + 1)*E // size`` of the concatenation of
+    the local edges of all processes (single all-to-all exchange).
+    '''
+    size, rank = comm.Get_size(), comm.Get_rank()
+
+    edges     = np.ascontiguousarray(edges, dtype=np.int64).reshape(-1, 2)
+    distances = np.ascontiguousarray(distances, dtype=np.float64)
+
+    counts = np.zeros(size, dtype=np.int64)
+    counts[rank] = len(edges)
+
+    comm.Allreduce(MPI.IN_PLACE, counts, op=MPI.SUM)
+
+    # current and final positions of the blocks of each process
+    have = np.concatenate(([0], np.cumsum(counts)))
+    want = np.array([i*have[-1] // size for i in range(size + 1)])
+
+    send = np.diff(np.clip(want, have[rank], have[rank + 1]))
+    recv = np.diff(np.clip(have, want[rank], want[rank + 1]))
+
+    sdispl = np.concatenate(([0], np.cumsum(send)[:-1]))
+    rdispl = np.concatenate(([0], np.cumsum(recv)[:-1]))
+
+    new_edges = np.empty((recv.sum(), 2), dtype=np.int64)
+    new_dist  = np.empty(recv.sum(), dtype=np.float64)
+
+    comm.Alltoallv(
+        [edges, (2*send, 2*sdispl), MPI.INT64_T],
+        [new_edges, (2*recv, 2*rdispl), MPI.INT64_T])
+
+    comm.Alltoallv([distances, (send, sdispl), MPI.DOUBLE],
+                   [new_dist, (recv, rdispl), MPI.DOUBLE])
+
+    return new_edges, new_dist
+
+
 def _finalize_random(rank):
     '''
     Make sure everyone gets same seed back.
@@ -163,7 +163,7 @@ def lattice_rewire(g, target_reciprocity=1., node_attr_constraints=None,
 
                 if num_recip:
                     last_edges[first_recip:first_recip + num_recip] = \
-                        [(i, (i + dist) % num_nodes) for i in range(num_recip)]
+                        _ring_step(0, num_recip, dist, num_nodes)
 
                     start = first_recip + num_recip
                     stop  = first_recip + 2*num_recip
@@ -176,13 +176,13 @@ def lattice_rewire(g, target_reciprocity=1., node_attr_constraints=None,
 
                 if e_final:
                     last_edges[first_recip + 2*num_recip:] = \
-                        [(i, (i + dist) % num_nodes)
-                         for i in range(num_recip, num_recip + e_final)]
+                        _ring_step(num_recip, num_recip + e_final, dist,
+                                   num_nodes)
         else:
             # new connections are one step above the max regular lattice
             # distance
             dist = int(0.5*coord_nb) + 1
-            last_edges[:] = [(i, i + dist) for i in range(e_remaining)]
+            last_edges[:] = _ring_step(0, e_remaining, dist, num_nodes)
 
         # put nodes back into [0, num_nodes[
         last_edges[last_edges >= num_nodes] -= num_nodes
@@ -233,6 +233,8 @@ def random_rewire(g, constraints=None, node_attr_constraints=None,
         graph. By default, the graph is completely rewired into an Erdos-Renyi
         model. Available constraints are "in-degree", "out-degree",
         "total-degree", "all-degrees", and "clustering".
+        With "all-degrees", both the in- and out-degrees of every node are
+        preserved by randomly swapping the targets of pairs of edges.
     node_attr_constraints : str, optional (default: randomize all attributes)
         Whether attribute randomization is constrained: either "preserve",
         where all nodes keep their attributes, or "together", where attributes
@@ -250,6 +252,18 @@ def random_rewire(g, constraints=None, node_attr_constraints=None,
         sent to the same new edge). By default, attributes are completely and
         separately randomized.
     **kwargs : optional keyword arguments
+        If `constraints` is "all-degrees", the user can provide:
+
+        * `swaps` : float, optional (default: 10)
+          Number of proposed swaps per edge.
+        * `groups` : str or array, optional (default: None)
+          Name of a node attribute or array containing a label for each node:
+          swaps only exchange targets with the same label, which preserves
+          the number of edges between each pair of labels.
+        * `stats` : dict, optional (default: None)
+          Dictionary, which will be filled with the number of "attempted" and
+          "accepted" swaps as well as the "acceptance" rate.
+
         These are optional arguments in the case `constraints` is "clustering".
         In that case, the user can provide both:
 
@@ -300,8 +314,7 @@ def random_rewire(g, constraints=None, node_attr_constraints=None,
         new_graph = gc.erdos_renyi(edges=num_edges, nodes=num_nodes,
                                    directed=directed)
     elif constraints == "all-degrees":
-        raise NotImplementedError("Full degrees constraints is not yet "
-                                  "implemented.")
+        new_graph = _swap_rewire(g, **kwargs)
     elif "degree" in constraints:
         degrees   = g.get_degrees(constraints)
         new_graph = gc.from_degree_list(degrees, constraints,
@@ -376,6 +389,43 @@ def random_rewire(g, constraints=None, node_attr_constraints=None,
 # Tools #
 # ----- #
 
+def _swap_rewire(g, swaps=10, groups=None, stats=None, **kwargs):
+    ''' Rewire `g` through double edge swaps (preserves all degrees) '''
+    directed  = g.is_directed()
+    num_nodes = g.node_nb()
+    num_swaps = int(swaps*g.edge_nb())
+
+    if isinstance(groups, str):
+        groups = g.node_attributes[groups]
+
+    if groups is not None:
+        # convert labels to integers
+        groups = np.unique(groups, return_inverse=True)[1]
+
+    ia_edges, accepted = gc._edge_swaps(
+        g.edges_array, num_nodes, num_swaps, directed=directed,
+        groups=groups)
+
+    if stats is not None:
+        stats["attempted"]  = num_swaps
+        stats["accepted"]   = accepted
+        stats["acceptance"] = accepted / num_swaps if num_swaps else 0.
+
+    new_graph = nngt.Graph(nodes=num_nodes, directed=directed)
+
+    new_graph.new_edges(ia_edges, check_duplicates=False,
+                        check_self_loops=False, check_existing=False)
+
+    return new_graph
+
+
+def _ring_step(start, stop, dist, num_nodes):
+    ''' Edges (i, i + dist) on the ring for i in [start, stop[ '''
+    sources = np.arange(start, stop, dtype=np.int64)
+
+    return np.array((sources, (sources + dist) % num_nodes)).T
+
+
 def _set_node_attributes(old_graph, new_graph, constraints, num_nodes):
     ''' Reassign node attributes '''
     order = None
@@ -0,0 +1,246 @@
+# -*- coding: utf-8 -*-
+# SPDX-FileCopyrightText: 2015-2023 Tanguy Fardet
+# SPDX-License-Identifier: GPL-3.0-or-later
+# nngt/io/binary_helpers.py
+
+"""
+Binary graph format.
+
+Layout of a file (little-endian):
+
+* magic string ``b"NNGTGRPH"`` (8 bytes),
+* format version (uint32) and reserved flags (uint32),
+* length of the header (uint64),
+* UTF-8 JSON header with the graph information (same entries as the
+  notifiers of the text formats) and a "blocks" dictionary describing each
+  data block by its dtype, shape, offset from the start of the data section,
+  number of bytes on disk, compression, and CRC32,
+* data section, starting at the first multiple of :data:`ALIGNMENT` after the
+  header, with one aligned block per array: "edges" ((E, 2) int32 or int64
+  depending on the number of nodes), "positions", and one "na:<name>" or
+  "ea:<name>" column per node or edge attribute.
+
+Uncompressed blocks are memory-mapped on loading, so no data is parsed or
+copied until it is used.
+"""
+
+import json
+import pickle
+import struct as _struct
+import zlib
+
+import numpy as np
+
+from nngt.lib import InvalidArgument
+
+
+MAGIC = b"NNGTGRPH"
+
+VERSION = 1
+
+ALIGNMENT = 64
+
+_preamble = _struct.Struct("<8sIIQ")
+
+_compressions = (None, "zlib")
+
+
+# ------ #
+# Saving #
+# ------ #
+
+def _column(values, vtype):
+    ''' Array (or pickled bytes for objects) storing an attribute column '''
+    if vtype == "double":
+        return np.asarray(values, dtype="<f8")
+    elif vtype == "int":
+        return np.asarray(values, dtype="<i8")
+    elif vtype == "string":
+        return np.asarray(values, dtype=str)
+
+    return pickle.dumps(list(values), protocol=4)
+
+
+def _save_binary(filename, info, edges, node_attributes, edge_attributes,
+                 positions=None, compression=None):
+    '''
+    Write a graph to a binary file.
+
+    Parameters
+    ----------
+    filename : str
+        Path to the file.
+    info : dict
+        JSON-serializable graph information.
+    edges : array of shape (E, 2)
+        Edges of the graph.
+    node_attributes, edge_attributes : dict
+        Columns for each node and edge attribute (name as key, (values, type)
+        as value).
+    positions : array of shape (N, d), optional (default: None)
+        Positions of the nodes.
+    compression : str, optional (default: None)
+        Either None or "zlib" to compress each block separately (compressed
+        blocks cannot be memory-mapped).
+    '''
+    if compression not in _compressions:
+        raise InvalidArgument(
+            "`compression` must be among {}.".format(_compressions))
+
+    edge_dtype = "<i4" if info["size"] <= np.iinfo(np.int32).max else "<i8"
+
+    columns = [("edges", np.asarray(edges, dtype=edge_dtype).reshape(-1, 2))]
+
+    if positions is not None:
+        columns.append(("positions", np.asarray(positions, dtype="<f8")))
+
+    for prefix, attributes in (("na:", node_attributes),
+                              ("ea:", edge_attributes)):
+        for name, (values, vtype) in attributes.items():
+            columns.append((prefix + name, _column(values, vtype)))
+
+    # describe the blocks and get their content
+    blocks, chunks, offset = {}, [], 0
+
+    for name, col in columns:
+        if isinstance(col, bytes):
+            data, desc = col, {"dtype": "pickle", "shape": None}
+        else:
+            col  = np.ascontiguousarray(col)
+            data = col.reshape(-1).view(np.uint8)
+            desc = {"dtype": col.dtype.str, "shape": list(col.shape)}
+
+        if compression == "zlib":
+            data = zlib.compress(data)
+
+        desc.update({
+            "offset": offset,
+            "nbytes": len(data),
+            "compression": compression,
+            "crc32": zlib.crc32(data),
+        })
+
+        blocks[name] = desc
+        chunks.append(data)
+
+        offset = _aligned(offset + len(data))
+
+    header = dict(info)
+    header["blocks"] = blocks
+
+    header = json.dumps(header).encode("utf-8")
+
+    data_start = _aligned(_preamble.size + len(header))
+
+    with open(filename, "wb") as f:
+        f.write(_preamble.pack(MAGIC, VERSION, 0, len(header)))
+        f.write(header)
+
+        for (name, _), data in zip(columns, chunks):
+            f.seek(data_start + blocks[name]["offset"])
+            f.write(data)
+
+        # make sure that the file covers the last (possibly empty) block
+        f.truncate(data_start + offset)
+
+
+# ------- #
+# Loading #
+# ------- #
+
+def _load_binary(filename, checksums=False):
+    '''
+    Read a binary graph file.
+
+    Uncompressed blocks are returned as read-only memory maps, compressed
+    blocks are decompressed and, like all blocks if `checksums` is True,
+    checked against their CRC32.
+
+    Returns
+    -------
+    info : dict
+        Graph information.
+    edges : array of shape (E, 2)
+        Edges of the graph.
+    node_attributes, edge_attributes : dict
+        Values of the attributes.
+    positions : array of shape (N, d) or None
+        Positions of the nodes.
+    '''
+    with open(filename, "rb") as f:
+        preamble = f.read(_preamble.size)
+
+        if len(preamble) < _preamble.size:
+            raise IOError("'{}' is not an NNGT binary file.".format(filename))
+
+        magic, version, _, header_size = _preamble.unpack(preamble)
+
+        if magic != MAGIC:
+            raise IOError("'{}' is not an NNGT binary file.".format(filename))
+
+        if version > VERSION:
+            raise IOError("'{}' uses version {} of the binary format, which "
+                          "is more recent than this version of NNGT "
+                          "({}).".format(filename, version, VERSION))
+
+        info = json.loads(f.read(header_size).decode("utf-8"))
+
+        data_start = _aligned(_preamble.size + header_size)
+
+        def read(name):
+            desc = info["blocks"][name]
+            start = data_start + desc["offset"]
+
+            if desc["compression"] is None and desc["dtype"] != "pickle":
+                if checksums:
+                    f.seek(start)
+                    _check_crc(name, f.read(desc["nbytes"]), desc)
+
+                if desc["nbytes"] == 0:
+                    return np.zeros(desc["shape"], dtype=desc["dtype"])
+
+                return np.memmap(filename, dtype=desc["dtype"], mode="r",
+                                 offset=start, shape=tuple(desc["shape"]))
+
+            f.seek(start)
+
+            data = f.read(desc["nbytes"])
+
+            if desc["compression"] is not None or checksums:
+                _check_crc(name, data, desc)
+
+            if desc["compression"] == "zlib":
+                data = zlib.decompress(data)
+
+            if desc["dtype"] == "pickle":
+                return pickle.loads(data)
+
+            return np.frombuffer(data, dtype=desc["dtype"]).reshape(
+                desc["shape"])
+
+        edges = read("edges")
+
+        positions = read("positions") if "positions" in info["blocks"] \
+                    else None
+
+        nattr = {name: read("na:" + name) for name in info["node_attributes"]}
+        eattr = {name: read("ea:" + name) for name in info["edge_attributes"]}
+
+    del info["blocks"]
+
+    return info, edges, nattr, eattr, positions
+
+
+# ----- #
+# Tools #
+# ----- #
+
+def _aligned(offset):
+    ''' Smallest multiple of ALIGNMENT that is greater or equal to `offset` '''
+    return -(-offset // ALIGNMENT) * ALIGNMENT
+
+
+def _check_crc(name, data, desc):
+    if zlib.crc32(data) != desc["crc32"]:
+        raise IOError("Checksum mismatch for the '{}' block, the file is "
+                      "corrupted.".format(name))
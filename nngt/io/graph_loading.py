@@ -17,6 +17,7 @@ import nngt
 from nngt.lib import InvalidArgument
 from nngt.lib.logger import _log_message
 from ..geometry import Shape, _shapely_support
+from .binary_helpers import _load_binary
 from .io_helpers import _get_format
 from .loading_helpers import *
 
@@ -44,13 +45,19 @@ di_get_edges = {
 def load_from_file(filename, fmt="auto", separator=" ", secondary=";",
                    attributes=None, attributes_types=None, notifier="@",
                    ignore="#", name="LoadedGraph", directed=True,
-                   cleanup=False):
+                   cleanup=False, checksums=False):
     '''
     Load a Graph from a file.
 
     .. versionchanged :: 2.0
         Added optional `attributes_types` and `cleanup` arguments.
 
+    .. versionchanged :: 2.8
+        Added the "binary" format and the `checksums` argument; edge and
+        neighbour lists with numeric attributes and single-character
+        separators are parsed in parallel in C++ when multithreading is
+        available.
+
     .. warning ::
        Support for GraphML and DOT formats are currently limited and require
        one of the non-default backends (DOT requires graph-tool).
@@ -68,7 +75,8 @@ def load_from_file(filename, fmt="auto", separator=" ", secondary=";",
         (graphml format, default if `filename` ends with '.graphml' or '.xml'),
         "dot" (dot format, default if `filename` ends with '.dot'), "gt" (only
         when using `graph_tool`<http://graph-tool.skewed.de/>_ as library,
-        detected if `filename` ends with '.gt').
+        detected if `filename` ends with '.gt'), "binary" (NNGT binary
+        format, detected if `filename` ends with '.nngt').
     separator : str, optional (default " ")
         separator used to separate inputs in the case of custom formats (namely
         "neighbour" and "edge_list")
@@ -104,6 +112,10 @@ def load_from_file(filename, fmt="auto", separator=" ", secondary=";",
     cleanup : bool, optional (default: False)
        If true, removes nodes before the first one that appears in the
        edges and after the last one and renumber the nodes from 0.
+    checksums : bool, optional (default: False)
+        For the "binary" format, also check the memory-mapped (uncompressed)
+        blocks against their CRC32 (compressed blocks are always checked).
+        This requires reading the whole file.
 
     Returns
     -------
@@ -114,12 +126,13 @@ def load_from_file(filename, fmt="auto", separator=" ", secondary=";",
         filename, fmt=fmt, separator=separator, secondary=secondary,
         attributes=attributes, attributes_types=attributes_types,
         notifier=notifier, ignore=ignore, name=name, directed=directed,
-        cleanup=cleanup)
+        cleanup=cleanup, checksums=checksums)
 
 
 def _load_from_file(filename, fmt="auto", separator=" ", secondary=";",
                     attributes=None, attributes_types=None,
-                    notifier="@", ignore="#", cleanup=False):
+                    notifier="@", ignore="#", cleanup=False,
+                    checksums=False):
     '''
     Load the main properties (edges, attributes...) from a file.
 
@@ -166,13 +179,15 @@ def _load_from_file(filename, fmt="auto", separator=" ", secondary=";",
     cleanup : bool, optional (default: False)
        If true, removes nodes before the first one that appears in the
        edges and after the last one and renumber the nodes from 0.
+    checksums : bool, optional (default: False)
+        Whether to check all the blocks of a binary file.
 
     Returns
     -------
     di_notif : dict
         Dictionary containing the main graph arguments.
-    edges : list of 2-tuples
-        Edges of the graph.
+    edges : list of 2-tuples or array
+        Edges of the graph (a read-only memory map for binary files).
     di_nattributes : dict
         Dictionary containing the node attributes.
     di_eattributes : dict
@@ -193,11 +208,34 @@ def _load_from_file(filename, fmt="auto", separator=" ", secondary=";",
     lst_lines, struct, shape, positions = None, None, None, None
     fmt = _get_format(fmt, filename)
 
+    if fmt == "binary":
+        di_notif, edges, di_nattributes, di_eattributes, positions = \
+            _load_binary(filename, checksums=checksums)
+
+        if cleanup and len(edges):
+            edges = edges - np.min(edges)
+
+        # positions are stored (and possibly updated) by the graph
+        if positions is not None:
+            positions = np.array(positions)
+
+        struct, shape = _shape_and_structure(di_notif)
+
+        return (di_notif, edges, di_nattributes, di_eattributes, struct,
+                shape, positions)
+
     if fmt not in di_get_edges:
         raise ValueError("Unsupported format: '{}'".format(fmt))
 
+    # for edge and neighbour lists, only the notifiers are read in Python if
+    # the edges can be parsed in C++
+    parser = _compiled_text_parser(fmt, separator, secondary)
+
     with open(filename, "r") as filegraph:
-        lst_lines = _process_file(filegraph, fmt, separator)
+        if parser is None:
+            lst_lines = _process_file(filegraph, fmt, separator)
+        else:
+            lst_lines = _read_notifiers(filegraph, separator, notifier)
 
     # notifier lines
     di_notif = _get_notif(filename, lst_lines, notifier, attributes, fmt=fmt,
@@ -217,11 +255,40 @@ def _load_from_file(filename, fmt="auto", separator=" ", secondary=";",
                                    di_notif["edge_attr_types"],
                                    attributes_types=attributes_types)
 
+    # non-numeric attributes always go through the Python converters
+    if parser is not None and not _numeric_attributes(
+            eattributes, di_notif["edge_attr_types"], attributes_types):
+        parser = None
+
+        with open(filename, "r") as filegraph:
+            lst_lines = _process_file(filegraph, fmt, separator)
+
     # process file
-    edges = di_get_edges[fmt](
-        lst_lines, eattributes, ignore, notifier, separator, secondary,
-        di_attributes=di_eattributes, convertor=eattr_convertor,
-        di_notif=di_notif)
+    if parser is not None:
+        try:
+            edges, values = parser(filename, fmt, separator, secondary,
+                                   notifier, ignore, len(eattributes))
+
+            for i, (name, atype) in enumerate(
+                    zip(eattributes, di_notif["edge_attr_types"])):
+                if atype in ("int", "integer"):
+                    di_eattributes[name] = values[:, i].astype(np.int64)
+                else:
+                    di_eattributes[name] = values[:, i]
+        except ValueError:
+            # lines rejected by the C++ parser (e.g. edges whose number of
+            # attributes does not match) are handled by the Python one, so
+            # that files load the same way with or without multithreading
+            parser = None
+
+            with open(filename, "r") as filegraph:
+                lst_lines = _process_file(filegraph, fmt, separator)
+
+    if parser is None:
+        edges = di_get_edges[fmt](
+            lst_lines, eattributes, ignore, notifier, separator, secondary,
+            di_attributes=di_eattributes, convertor=eattr_convertor,
+            di_notif=di_notif)
 
     if cleanup:
         edges = np.array(edges) - np.min(edges)
@@ -230,6 +297,28 @@ def _load_from_file(filename, fmt="auto", separator=" ", secondary=";",
     if "size" not in di_notif:
         di_notif["size"] = int(np.max(edges)) + 1
 
+    struct, shape = _shape_and_structure(di_notif)
+
+    if 'x' in di_notif:
+        x = np.fromstring(di_notif['x'], sep=separator)
+        y = np.fromstring(di_notif['y'], sep=separator)
+        if 'z' in di_notif:
+            z = np.fromstring(di_notif['z'], sep=separator)
+            positions = np.array((x, y, z)).T
+        else:
+            positions = np.array((x, y)).T
+
+    return (di_notif, edges, di_nattributes, di_eattributes, struct, shape,
+            positions)
+
+
+def _shape_and_structure(di_notif):
+    '''
+    Return the shape and structure described in the graph information (None
+    if absent).
+    '''
+    struct, shape = None, None
+
     # check whether a shape is present
     if 'shape' in di_notif:
         if _shapely_support:
@@ -278,17 +367,7 @@ def _load_from_file(filename, fmt="auto", separator=" ", secondary=";",
         except UnicodeError:
             struct = pickle.loads(str_dec, encoding="latin1")
 
-    if 'x' in di_notif:
-        x = np.fromstring(di_notif['x'], sep=separator)
-        y = np.fromstring(di_notif['y'], sep=separator)
-        if 'z' in di_notif:
-            z = np.fromstring(di_notif['z'], sep=separator)
-            positions = np.array((x, y, z)).T
-        else:
-            positions = np.array((x, y)).T
-
-    return (di_notif, edges, di_nattributes, di_eattributes, struct, shape,
-            positions)
+    return struct, shape
 
 
 def _library_load(filename, fmt):
@@ -21,6 +21,7 @@ from nngt.lib import InvalidArgument, on_master_process
 from nngt.lib.logger import _log_message
 
 from ..geometry import Shape, _shapely_support
+from .binary_helpers import _save_binary
 from .io_helpers import _get_format
 from .saving_helpers import (_neighbour_list, _edge_list, _gml, _xml,
                              _custom_info, _gml_info, _xml_info,
@@ -53,10 +54,16 @@ format_graph_info["graphml"] = _xml_info
 # --------------- #
 
 def save_to_file(graph, filename, fmt="auto", separator=" ",
-                 secondary=";", attributes=None, notifier="@"):
+                 secondary=";", attributes=None, notifier="@",
+                 compression=None):
     '''
     Save a graph to file.
 
+    .. versionchanged :: 2.8
+        Added the "binary" format and the `compression` argument; edge lists
+        with numeric attributes are written by batches in C++ when
+        multithreading is available.
+
     @todo: implement dot, xml/graphml, and gt formats
 
     Parameters
@@ -74,7 +81,8 @@ def save_to_file(graph, filename, fmt="auto", separator=" ",
         (graphml format, default if `filename` ends with '.graphml' or '.xml'),
         "dot" (dot format, default if `filename` ends with '.dot'), "gt" (only
         when using `graph_tool <http://graph-tool.skewed.de/>`_ as library,
-        detected if `filename` ends with '.gt').
+        detected if `filename` ends with '.gt'), "binary" (NNGT binary
+        format, default if `filename` ends with '.nngt').
     separator : str, optional (default " ")
         separator used to separate inputs in the case of custom formats (namely
         "neighbour" and "edge_list")
@@ -92,6 +100,10 @@ def save_to_file(graph, filename, fmt="auto", separator=" ",
         Additional notifiers are ``@type=SpatialGraph/Network/SpatialNetwork``,
         which are followed by the relevant notifiers among ``@shape``,
         ``@structure``, and ``@graph`` to separate the sections.
+    compression : str, optional (default: None)
+        For the "binary" format, compress each data block with "zlib".
+        Uncompressed files are memory-mapped when they are loaded and are
+        therefore faster to read.
 
     Note
     ----
@@ -99,6 +111,9 @@ def save_to_file(graph, filename, fmt="auto", separator=" ",
     '''
     fmt = _get_format(fmt, filename)
 
+    if fmt == "binary":
+        return _to_binary(graph, filename, attributes, compression)
+
     # check for mpi
     if nngt.get_config("mpi"):
         from mpi4py import MPI
@@ -132,11 +147,117 @@ def save_to_file(graph, filename, fmt="auto", separator=" ",
         fh.Write_at_all(offset[rank], str_local.encode('utf-8'))
         fh.Close()
     else:
-        str_graph = _as_string(
-            graph, separator=separator, fmt=fmt, secondary=secondary,
-            attributes=attributes, notifier=notifier)
-        with open(filename, "w") as f_graph:
-            f_graph.write(str_graph)
+        writer = _compiled_edge_list_writer(graph, fmt, attributes)
+
+        if writer is None:
+            str_graph = _as_string(
+                graph, separator=separator, fmt=fmt, secondary=secondary,
+                attributes=attributes, notifier=notifier)
+            with open(filename, "w") as f_graph:
+                f_graph.write(str_graph)
+        else:
+            _to_edge_list(graph, filename, writer, separator, secondary,
+                          attributes, notifier)
+
+
+def _to_binary(graph, filename, attributes, compression):
+    ''' Save a graph in the binary format '''
+    if nngt.get_config("mpi"):
+        raise NotImplementedError("The binary format is not ready for MPI "
+                                  "yet.")
+
+    if attributes is None:
+        attributes = [a for a in graph.edge_attributes if a != "bweight"]
+
+    nattributes = [a for a in graph.node_attributes]
+
+    info = {
+        "directed": graph.is_directed(),
+        "node_attributes": nattributes,
+        "node_attr_types": [
+            graph.get_attribute_type(nattr, "node") for nattr in nattributes
+        ],
+        "edge_attributes": attributes,
+        "edge_attr_types": [
+            graph.get_attribute_type(attr, "edge") for attr in attributes
+        ],
+        "name": graph.name,
+        "size": graph.node_nb(),
+        "num_edges": graph.edge_nb(),
+    }
+
+    _shape_and_structure_info(graph, info)
+
+    # area dictionaries are stored as strings, like in the text formats
+    for key in ("default_areas", "default_areas_prop", "non_default_areas",
+                "non_default_areas_prop"):
+        if key in info:
+            info[key] = str(info[key])
+
+    nattr = {
+        k: (graph.get_node_attributes(name=k), t)
+        for k, t in zip(nattributes, info["node_attr_types"])
+    }
+
+    eattr = {
+        k: (graph.get_edge_attributes(name=k), t)
+        for k, t in zip(attributes, info["edge_attr_types"])
+    }
+
+    positions = graph.get_positions() if graph.is_spatial() else None
+
+    _save_binary(filename, info, graph.edges_array, nattr, eattr,
+                 positions=positions, compression=compression)
+
+
+def _compiled_edge_list_writer(graph, fmt, attributes):
+    '''
+    C++ writer for the "edge_list" format if the multithreaded algorithms are
+    available and all saved attributes are numbers, None otherwise.
+    '''
+    if fmt == "edge_list" and nngt.get_config("multithreading"):
+        if attributes is None:
+            attributes = [a for a in graph.edge_attributes if a != "bweight"]
+
+        numeric = all(
+            graph.get_attribute_type(attr, "edge") in ("double", "int")
+            for attr in attributes)
+
+        if numeric:
+            try:
+                from nngt.generation.cconnect import _write_edge_list
+                return _write_edge_list
+            except ImportError:
+                pass
+
+    return None
+
+
+def _to_edge_list(graph, filename, writer, separator, secondary, attributes,
+                  notifier):
+    '''
+    Save a graph as an edge list, the edges being formatted and written by
+    batches so that the whole text is never stored in memory.
+    '''
+    info = _graph_info(graph, "edge_list", separator, secondary, attributes,
+                       notifier)
+
+    attributes = info["edge_attributes"]
+
+    values = np.zeros((graph.edge_nb(), len(attributes)))
+
+    for i, attr in enumerate(attributes):
+        values[:, i] = graph.get_edge_attributes(name=attr)
+
+    integer = [t == "int" for t in info["edge_attr_types"]]
+
+    info_str = format_graph_info["edge_list"](info, notifier, graph=graph)
+
+    with open(filename, "wb") as f_graph:
+        f_graph.write(info_str.encode("utf-8"))
+
+        writer(f_graph, graph.edges_array, values, integer, separator,
+               secondary)
 
 
 # --------------------- #
@@ -186,6 +307,28 @@ def _as_string(graph, fmt="neighbour", separator=" ", secondary=";",
     str_graph : string
         The full graph representation as a string.
     '''
+    additional_notif = _graph_info(graph, fmt, separator, secondary,
+                                   attributes, notifier)
+
+    str_graph = di_format[fmt](graph, separator=separator,
+                               secondary=secondary,
+                               attributes=additional_notif["edge_attributes"],
+                               additional_notif=additional_notif)
+
+    if return_info:
+        return str_graph, additional_notif
+
+    # format the info into the string
+    info_str = format_graph_info[fmt](additional_notif, notifier, graph=graph)
+
+    return info_str + str_graph
+
+
+def _graph_info(graph, fmt, separator, secondary, attributes, notifier):
+    '''
+    Dictionary of the graph information which is stored in the notifiers of
+    the text formats (node attributes and positions are stored as strings).
+    '''
     # checks
     if separator == secondary and fmt != "edge_list":
         raise InvalidArgument("`separator` and `secondary` strings must be "
@@ -242,37 +385,51 @@ def _as_string(graph, fmt="neighbour", separator=" ", secondary=";",
             # make and store final string
             additional_notif[key] = tmp
 
-    # save positions for SpatialGraph (and shape if Shapely is available)
+    # save positions for SpatialGraph
+    if graph.is_spatial():
+        pos = graph.get_positions()
+        additional_notif['x'] = np.array2string(
+            pos[:, 0], max_line_width=np.NaN, separator=separator)[1:-1]
+        additional_notif['y'] = np.array2string(
+            pos[:, 1], max_line_width=np.NaN, separator=separator)[1:-1]
+        if pos.shape[1] == 3:
+            additional_notif['z'] = np.array2string(
+                pos[:, 2], max_line_width=np.NaN, separator=separator)[1:-1]
+
+    _shape_and_structure_info(graph, additional_notif)
+
+    # set numpy cut threshold back on
+    np.set_printoptions(threshold=old_threshold)
+
+    return additional_notif
+
+
+def _shape_and_structure_info(graph, info):
+    '''
+    Add the shape (if Shapely is available) and the pickled structure of
+    `graph` to the `info` dictionary.
+    '''
     if graph.is_spatial():
         if _shapely_support:
-            additional_notif['shape'] = graph.shape.wkt
-            additional_notif['default_areas'] = \
+            info['shape'] = graph.shape.wkt
+            info['default_areas'] = \
                 {k: v.wkt for k, v in graph.shape.default_areas.items()}
-            additional_notif['default_areas_prop'] = \
+            info['default_areas_prop'] = \
                 {k: v.properties for k, v in graph.shape.default_areas.items()}
-            additional_notif['non_default_areas'] = \
+            info['non_default_areas'] = \
                 {k: v.wkt for k, v in graph.shape.non_default_areas.items()}
-            additional_notif['non_default_areas_prop'] = \
+            info['non_default_areas_prop'] = \
                 {k: v.properties
                  for k, v in graph.shape.non_default_areas.items()}
-            additional_notif['unit'] = graph.shape.unit
+            info['unit'] = graph.shape.unit
             min_x, min_y, max_x, max_y = graph.shape.bounds
-            additional_notif['min_x'] = min_x
-            additional_notif['max_x'] = max_x
+            info['min_x'] = min_x
+            info['max_x'] = max_x
         else:
             _log_message(logger, "WARNING",
                          'The `shape` attribute of the graph could not be '
                          'saved to file because Shapely is not installed.')
 
-        pos = graph.get_positions()
-        additional_notif['x'] = np.array2string(
-            pos[:, 0], max_line_width=np.NaN, separator=separator)[1:-1]
-        additional_notif['y'] = np.array2string(
-            pos[:, 1], max_line_width=np.NaN, separator=separator)[1:-1]
-        if pos.shape[1] == 3:
-            additional_notif['z'] = np.array2string(
-                pos[:, 2], max_line_width=np.NaN, separator=separator)[1:-1]
-
     if graph.structure is not None:
         # temporarily remove weakrefs
         graph.structure._parent = None
@@ -282,11 +439,11 @@ def _as_string(graph, fmt="neighbour", separator=" ", secondary=";",
         # save as string
         if nngt.get_config("mpi"):
             if nngt.get_config("mpi_comm").Get_rank() == 0:
-                additional_notif["structure"] = codecs.encode(
+                info["structure"] = codecs.encode(
                     pickle.dumps(graph.structure, protocol=2),
                                  "base64").decode().replace('\n', '~')
         else:
-            additional_notif["structure"] = codecs.encode(
+            info["structure"] = codecs.encode(
                 pickle.dumps(graph.structure, protocol=2),
                              "base64").decode().replace('\n', '~')
         # restore weakrefs
@@ -294,18 +451,3 @@ def _as_string(graph, fmt="neighbour", separator=" ", secondary=";",
         for g in graph.structure.values():
             g._struct = weakref.ref(graph.structure)
             g._net    = weakref.ref(graph)
-
-    str_graph = di_format[fmt](graph, separator=separator,
-                               secondary=secondary, attributes=attributes,
-                               additional_notif=additional_notif)
-
-    # set numpy cut threshold back on
-    np.set_printoptions(threshold=old_threshold)
-
-    if return_info:
-        return str_graph, additional_notif
-
-    # format the info into the string
-    info_str = format_graph_info[fmt](additional_notif, notifier, graph=graph)
-
-    return info_str + str_graph
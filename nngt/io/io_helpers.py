@@ -28,6 +28,8 @@ def _get_format(fmt, filename):
             fmt = 'neighbour'
         elif filename.endswith('.el'):
             fmt = 'edge_list'
+        elif filename.endswith('.nngt'):
+            fmt = 'binary'
         else:
             raise InvalidArgument('Could not determine format from filename '
                                   'please specify `fmt`.')
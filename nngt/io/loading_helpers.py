@@ -12,6 +12,7 @@ import types
 
 import numpy as np
 
+import nngt
 from ..lib.logger import _log_message
 from ..lib.converters import (_np_dtype, _to_int, _to_string, _to_list,
                               _string_from_object, _python_type, _default_value)
@@ -19,6 +20,7 @@ from ..lib.converters import (_np_dtype, _to_int, _to_string, _to_list,
 
 __all__ = [
     "_cleanup_line",
+    "_compiled_text_parser",
     "_gen_convert",
     "_get_edges_elist",
     "_get_edges_gml",
@@ -26,7 +28,9 @@ __all__ = [
     "_get_edges_neighbour",
     "_get_node_attr",
     "_get_notif",
+    "_numeric_attributes",
     "_process_file",
+    "_read_notifiers",
 ]
 
 
@@ -60,6 +64,44 @@ def _process_file(f, fmt, separator):
     return [_cleanup_line(line, separator) for line in f.readlines() if line]
 
 
+def _read_notifiers(f, separator, notifier):
+    '''
+    Cleaned-up notifier lines at the beginning of the file (the rest of the
+    file is not read).
+    '''
+    lines = []
+
+    for line in f:
+        clean_line = _cleanup_line(line, separator)
+
+        if not clean_line.startswith(notifier):
+            break
+
+        lines.append(clean_line)
+
+    return lines
+
+
+def _compiled_text_parser(fmt, separator, secondary):
+    '''
+    C++ parser for the edges of "edge_list" and "neighbour" files if the
+    multithreaded algorithms are available and both separators are single
+    ASCII characters, None otherwise.
+    '''
+    def single_char(sep):
+        return len(sep) == 1 and ord(sep) < 128
+
+    if fmt in ("edge_list", "neighbour") and single_char(separator) \
+       and single_char(secondary) and nngt.get_config("multithreading"):
+        try:
+            from nngt.generation.cconnect import _parse_edge_file
+            return _parse_edge_file
+        except ImportError:
+            pass
+
+    return None
+
+
 # ---------------- #
 # Graph properties #
 # ---------------- #
@@ -491,6 +533,23 @@ def _get_node_attr(di_notif, separator, fmt=None, lines=None, convertor=None):
 # Converters #
 # ---------- #
 
+def _numeric_attributes(attributes, attr_types, attributes_types=None):
+    '''
+    Whether all attributes are numbers that are converted by the default
+    (double or int) converters.
+    '''
+    numeric = ("double", "float", "real", "int", "integer")
+
+    for attr, attr_type in zip(attributes, attr_types):
+        if attributes_types is not None and attr in attributes_types:
+            return False
+
+        if attr_type not in numeric:
+            return False
+
+    return len(attributes) == len(attr_types)
+
+
 def _gen_convert(attributes, attr_types, attributes_types=None):
     '''
     Generate a conversion dictionary that associates the right type to each
@@ -206,12 +206,30 @@ def _filter(ia_edges, ia_edges_tmp, num_ecurrent, edges_hash, b_one_pop,
     return ia_edges, num_ecurrent
 
 
+def _compiled_edge_status():
+    '''
+    C++ edge-checking function if the multithreaded algorithms are available,
+    None otherwise.
+    '''
+    if nngt.get_config("multithreading"):
+        try:
+            from nngt.generation.cconnect import _check_new_edges
+            return _check_new_edges
+        except ImportError:
+            pass
+
+    return None
+
+
 def _cleanup_edges(g, edges, attributes, duplicates, loops, existing, ignore):
     '''
     Cleanup an list of edges.
     '''
     loops_only = loops and not (duplicates or existing)
 
+    # C++ hash-based checks if available
+    edge_status = None if loops_only else _compiled_edge_status()
+
     new_edges = None
     new_attr  = {}
     directed  = g.is_directed()
@@ -235,6 +253,49 @@ def _cleanup_edges(g, edges, attributes, duplicates, loops, existing, ignore):
             dtype = _np_dtype(g.get_attribute_type(k))
 
             new_attr[k] = np.asarray(v, dtype=dtype)[test]
+    elif edge_status is not None:
+        # check (also) either duplicates or existing with the C++ edge hash
+        edges = np.asarray(edges, dtype=np.int64)
+
+        status, num_valid = edge_status(
+            edges, g.edges_array if existing else None, directed=directed,
+            loops=loops, existing=existing)
+
+        if num_valid != len(edges):
+            invalid = np.flatnonzero(status)
+
+            # report the first invalid edge, as the python version does
+            tpl_e = tuple(edges[invalid[0]])
+
+            if not ignore:
+                if status[invalid[0]] == 1:
+                    raise InvalidArgument(
+                        "Edge {} already exists.".format(tpl_e))
+
+                raise InvalidArgument("Self-loop on {}.".format(tpl_e[0]))
+
+            for i in invalid:
+                if status[i] == 1:
+                    _log_message(logger, "INFO", "Existing edge {} "
+                                 "ignored.".format(tuple(edges[i])))
+                else:
+                    _log_message(logger, "INFO", "Self-loop on {} "
+                                 "ignored.".format(edges[i, 0]))
+
+        test = (status == 0)
+
+        new_edges = edges[test]
+
+        for k, v in attributes.items():
+            if nonstring_container(v):
+                dtype = None
+
+                if k in g.edge_attributes:
+                    dtype = _np_dtype(g.get_attribute_type(k))
+
+                new_attr[k] = np.asarray(v, dtype=dtype)[test]
+            else:
+                new_attr[k] = [v]*num_valid
     else:
         # check (also) either duplicates or existing
         new_attr = {key: [] for key in attributes}
@@ -369,11 +430,12 @@ def _set_dist_new_edges(new_attr, graph, edge_list):
             positions = graph.get_positions(list(edge_list[0]))
             new_attr["distance"] = cdist([positions[0]], [positions[1]])[0][0]
         else:
+            # one pass over the edges (no N x N matrix)
             positions = graph.get_positions()
-            mat = cdist(positions, positions)
-            distances = [mat[e[0], e[1]] for e in edge_list]
+            edges = np.asarray(edge_list, dtype=np.int64).reshape(-1, 2)
 
-            new_attr["distance"] = distances
+            new_attr["distance"] = np.linalg.norm(
+                positions[edges[:, 1]] - positions[edges[:, 0]], axis=1)
 
 
 def _set_default_edge_attributes(g, attributes, num_edges):
@@ -384,13 +446,33 @@ def _set_default_edge_attributes(g, attributes, num_edges):
         if k not in attributes:
             dtype = g.get_attribute_type(k)
             if dtype == "string":
-                attributes[k] = ["" for _ in range(num_edges)]
+                attributes[k] = [""]*num_edges
             elif dtype == "double" and not skip:
-                attributes[k] = [np.NaN for _ in range(num_edges)]
+                attributes[k] = np.full(num_edges, np.NaN)
             elif dtype == "int":
-                attributes[k] = [0 for _ in range(num_edges)]
+                attributes[k] = np.zeros(num_edges, dtype=int)
             elif not skip:
-                attributes[k] = [None for _ in range(num_edges)]
+                attributes[k] = [None]*num_edges
+
+
+def _connected_components(g):
+    '''
+    Connected components of `g` (strong for directed graphs), sorted by
+    decreasing size: returns the component of each node and the component
+    sizes.
+    Uses the C++ engine on the edges if the multithreaded algorithms are
+    available, whatever the backend, since it is recomputed after each round
+    of bridges in :func:`_connect_ccs`.
+    '''
+    if nngt.get_config("multithreading"):
+        try:
+            from nngt.generation.cconnect import _connected_components
+            return _connected_components(g.edges_array, g.node_nb(),
+                                         g.is_directed())
+        except ImportError:
+            pass
+
+    return nngt.analysis.connected_components(g)
 
 
 def _connect_ccs(g, cids, cc1, cc2, cc, c, cmean, edges, bridges,
@@ -173,6 +173,8 @@ def set_config(config, value=None, silent=False):
 
         if key == "log_level":
             new_config[key] = _convert(val)
+        if key == "nngt_storage" and val not in ("dict", "csr"):
+            raise ValueError("`nngt_storage` must be either 'dict' or 'csr'.")
         if key == "backend" and val != old_gl:
             nngt.use_backend(val)
         if key == "log_folder":
@@ -24,6 +24,10 @@ __all__ = [
 ]
 
 
+# maximum number of connections sent to NEST in a single call
+BATCH_SIZE = 1000000
+
+
 # -------- #
 # Topology #
 # -------- #
@@ -37,6 +41,11 @@ def make_nest_network(network, send_only=None, weights=True):
     .. versionchanged:: 0.8
         Added `send_only` parameter.
 
+    .. versionchanged:: 2.8
+        Connections are sent as source-sorted arrays, by batches of at most
+        :data:`BATCH_SIZE` edges, and each edge of a multigraph becomes a
+        separate synapse.
+
     Parameters
     ----------
     network: :class:`nngt.Network` or :class:`nngt.SpatialNetwork`
@@ -63,7 +72,7 @@ def make_nest_network(network, send_only=None, weights=True):
     if send_only in (-1, 1):
         send = [g for g in send if pop[g].neuron_type == send_only]
     elif isinstance(send_only, str):
-        send = [pop[send_only]]
+        send = [send_only]
     elif nonstring_container(send_only):
         send = [g for g in send_only]
 
@@ -118,101 +127,44 @@ def make_nest_network(network, send_only=None, weights=True):
         gid: idx for (idx, gid) in zip(ia_nngt_ids, ia_nest_gids)
     }
 
-    # get all properties as scipy.sparse.csr matrices
-    csr_weights = network.adjacency_matrix(types=False, weights=weights)
-    csr_delays  = network.adjacency_matrix(types=False, weights=DELAY)
-
-    cspec = 'one_to_one'
-
-    num_conn = 0
-
-    for src_name in send:
-        src_group = pop[src_name]
-        syn_sign = src_group.neuron_type
+    # source-sorted edges between the sent groups with their properties
+    groups = [pop[name] for name in send]
 
-        # local connectivity matrix and offset to correct neuron id
-        arr_idx = np.sort(src_group.ids).astype(int)
+    edges, weight_values, delays, bounds = _export_edges(
+        network, groups, weights)
 
-        local_csr = csr_weights[arr_idx, :]
-
-        assert local_csr.shape[1] == network.node_nb()
-
-        if len(src_group.ids) > 0 and pop.syn_spec is not None:
-            # check whether custom synapses should be used
-            local_tgt_names = [name for name in send if pop[name].ids]
-
-            for tgt_name in send:
-                tgt_group = pop[tgt_name]
-                # get list of targets for each
-                arr_tgt_idx = np.sort(tgt_group.ids).astype(int)
+    cspec = 'one_to_one'
 
-                # get non-wero entries (global NNGT ids)
-                keep = local_csr[:, arr_tgt_idx].nonzero()
+    for (i, j), (first, last) in bounds.items():
+        src_group, tgt_group = groups[i], groups[j]
 
-                local_tgt_ids = arr_tgt_idx[keep[1]]
-                local_src_ids = arr_idx[keep[0]]
+        # get the synaptic parameters
+        syn_spec = {}
 
-                if len(local_tgt_ids) and len(local_src_ids):
-                    # get the synaptic parameters
-                    syn_spec = _get_syn_param(
-                        src_name, src_group, tgt_name, tgt_group, pop.syn_spec)
+        if pop.syn_spec is not None:
+            syn_spec = _get_syn_param(send[i], src_group, send[j], tgt_group,
+                                      pop.syn_spec)
 
-                    # check whether sign must be given or not
-                    local_sign = syn_sign
-                    if "receptor_type" in syn_spec:
-                        if "cond" in tgt_group.neuron_model:
-                            # do not specify the sign for conductance-based
-                            # multisynapse model
-                            local_sign = 1
+        # check whether sign must be given or not
+        local_sign = src_group.neuron_type
 
-                    # using A1 to get data from matrix
-                    if weights:
-                        syn_spec[WEIGHT] = local_sign *\
-                            csr_weights[local_src_ids, local_tgt_ids].A1
-                    else:
-                        syn_spec[WEIGHT] = np.repeat(local_sign, len(tgt_ids))
-
-                    syn_spec[DELAY] = \
-                        csr_delays[local_src_ids, local_tgt_ids].A1
-
-                    num_conn += len(local_src_ids)
-
-                    # check backend
-                    with_mpi = nngt.get_config("mpi")
-                    if nngt.get_config("backend") == "nngt" and with_mpi:
-                        comm = nngt.get_config("mpi_comm")
-                        for i in range(comm.Get_size()):
-                            sources = \
-                                comm.bcast(network.nest_gids[local_src_ids], i)
-                            targets = \
-                                comm.bcast(network.nest_gids[local_tgt_ids], i)
-                            sspec   = comm.bcast(syn_spec, i)
-                            nest.Connect(sources, targets, syn_spec=sspec,
-                                         conn_spec=cspec, _warn=False)
-                            comm.Barrier()
-                    else:
-                        nest.Connect(
-                            network.nest_gids[local_src_ids],
-                            network.nest_gids[local_tgt_ids],
-                            syn_spec=syn_spec, conn_spec=cspec, _warn=False)
+        if "receptor_type" in syn_spec and "cond" in tgt_group.neuron_model:
+            # do not specify the sign for conductance-based multisynapse
+            # model
+            local_sign = 1
 
-        elif len(src_group.ids) > 0:
-            # get NEST gids of sources and targets for each edge
-            src_ids = network.nest_gids[local_csr.nonzero()[0] + min_sidx]
-            tgt_ids = network.nest_gids[local_csr.nonzero()[1]]
+        # connect by large batches of contiguous arrays
+        for start in range(first, last, BATCH_SIZE):
+            stop = min(start + BATCH_SIZE, last)
 
-            # prepare weights
-            syn_spec = {
-                WEIGHT: np.repeat(syn_sign, len(src_ids)).astype(float)
-            }
+            sspec = dict(syn_spec)
 
-            if weights not in {None, False}:
-                syn_spec[WEIGHT] *= csr_weights[src_group.ids, :].data
+            sspec[WEIGHT] = local_sign * weight_values[start:stop]
+            sspec[DELAY]  = delays[start:stop]
 
-            syn_spec[DELAY] = csr_delays[src_group.ids, :].data
-
-            nest.Connect(src_ids, tgt_ids, syn_spec=syn_spec, conn_spec=cspec,
-                         _warn=False)
+            nest.Connect(network.nest_gids[edges[start:stop, 0]],
+                         network.nest_gids[edges[start:stop, 1]],
+                         syn_spec=sspec, conn_spec=cspec, _warn=False)
 
     # tell the populaton that the network it describes was sent to NEST
     network.population._sent_to_nest()
@@ -422,3 +374,99 @@ def _get_psp_list(bins, neuron_model, di_param, timestep, simtime):
                               "range.")
     else:
         return da_max_psp
+
+
+# ----- #
+# Tools #
+# ----- #
+
+def _export_edges(network, groups, weights):
+    '''
+    Edges between `groups`, with their weights and delays, as contiguous
+    arrays sorted by group pair then by source.
+
+    With MPI and the "nngt" backend, the edges of all processes are gathered
+    so that every process sends the same connections to NEST.
+
+    Returns
+    -------
+    edges : int64 array of shape (E, 2)
+        Sorted edges.
+    weights : float array of size E
+        Unsigned weights (ones if `weights` is ``None`` or ``False``).
+    delays : float array of size E
+        Delays of the connections.
+    bounds : dict
+        For each pair of group indices (i, j) with connections, the first
+        and last+1 positions of the edges from groups[i] to groups[j].
+    '''
+    num_nodes = network.node_nb()
+
+    # group index of each node (-1 if it is not sent)
+    node_group = np.full(num_nodes, -1, dtype=np.int64)
+
+    for i, g in enumerate(groups):
+        node_group[np.asarray(g.ids, dtype=np.int64)] = i
+
+    edges = np.asarray(network.edges_array, dtype=np.int64).reshape(-1, 2)
+
+    if weights is True:
+        weights = WEIGHT
+
+    if weights in (None, False):
+        wvalues = np.ones(len(edges))
+    else:
+        wvalues = network.get_edge_attributes(name=weights)
+
+    wvalues = np.asarray(wvalues, dtype=float).ravel()
+    delays  = np.asarray(network.get_delays(), dtype=float).ravel()
+
+    # keep the edges between sent groups
+    src_group = node_group[edges[:, 0]]
+    tgt_group = node_group[edges[:, 1]]
+
+    keep = (src_group >= 0) & (tgt_group >= 0)
+
+    edges, wvalues, delays = edges[keep], wvalues[keep], delays[keep]
+
+    src_group, tgt_group = src_group[keep], tgt_group[keep]
+
+    # undirected edges are stored once but go both ways in NEST
+    if not network.is_directed():
+        loop = edges[:, 0] == edges[:, 1]
+
+        edges     = np.concatenate((edges, edges[~loop, ::-1]))
+        wvalues   = np.concatenate((wvalues, wvalues[~loop]))
+        delays    = np.concatenate((delays, delays[~loop]))
+
+        src_group, tgt_group = (
+            np.concatenate((src_group, tgt_group[~loop])),
+            np.concatenate((tgt_group, src_group[~loop])))
+
+    pair = src_group * len(groups) + tgt_group
+
+    if nngt.get_config("mpi") and nngt.get_config("backend") == "nngt":
+        comm = nngt.get_config("mpi_comm")
+
+        edges   = np.concatenate(comm.allgather(edges)).reshape(-1, 2)
+        wvalues = np.concatenate(comm.allgather(wvalues))
+        delays  = np.concatenate(comm.allgather(delays))
+        pair    = np.concatenate(comm.allgather(pair))
+
+    order = np.lexsort((edges[:, 1], edges[:, 0], pair))
+
+    edges   = np.ascontiguousarray(edges[order])
+    wvalues = np.ascontiguousarray(wvalues[order])
+    delays  = np.ascontiguousarray(delays[order])
+    pair    = pair[order]
+
+    # boundaries of each group pair
+    starts = np.flatnonzero(np.diff(pair)) + 1 if len(pair) else []
+    starts = np.concatenate(([0], starts, [len(pair)])).astype(int)
+
+    bounds = {
+        divmod(int(pair[first]), len(groups)): (first, last)
+        for first, last in zip(starts[:-1], starts[1:]) if last > first
+    }
+
+    return edges, wvalues, delays, bounds
@@ -136,7 +136,9 @@ if __name__ == "__main__":
                 "nngt.generation.cconnect",
                 sources=[
                     os.path.join(dirname, "cconnect.pyx"),
-                    os.path.join(dirname, "func_connect.cpp")
+                    os.path.join(dirname, "func_connect.cpp"),
+                    os.path.join(dirname, "func_analysis.cpp"),
+                    os.path.join(dirname, "func_io.cpp"),
                 ],
                 extra_compile_args=[],
                 language="c++",
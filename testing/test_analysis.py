@@ -791,6 +791,159 @@ def test_local_closure():
             res))
 
 
+@pytest.mark.mpi_skip
+def test_triangle_kernels():
+    '''
+    Check that the C++ triangle kernels match the scipy matrix products,
+    including for a hub.
+    '''
+    from nngt.analysis.clustering import (
+        _py_product_diagonal, _py_triangle_intensity, _triangle_kernels)
+
+    intensity, product = _triangle_kernels()
+
+    if intensity is _py_triangle_intensity:
+        pytest.skip("Multithreaded algorithms are not available.")
+
+    num_nodes = 200
+
+    g = ng.erdos_renyi(nodes=num_nodes, avg_deg=10, directed=True)
+
+    hub = [(0, i) for i in range(1, num_nodes) if not g.has_edge(0, i)]
+    hub += [(i, 0) for i in range(1, num_nodes, 2) if not g.has_edge(i, 0)]
+
+    g.new_edges(hub)
+    g.set_weights(np.random.uniform(0.1, 2, g.edge_nb()))
+
+    W    = g.adjacency_matrix(weights="weight")
+    Wsym = W + W.T
+
+    assert np.allclose(intensity(Wsym), _py_triangle_intensity(Wsym))
+
+    # the intensities do not depend on the number of threads
+    num_omp = nngt.get_config("omp")
+    results = []
+
+    try:
+        for omp in (1, 4):
+            nngt.set_config("omp", omp)
+            results.append(intensity(Wsym))
+    finally:
+        nngt.set_config("omp", num_omp)
+
+    assert np.array_equal(*results)
+
+    for x, y, z in ((W, W, W), (W, W.T, W), (W.T, W, W), (W, Wsym, W.T)):
+        assert np.allclose(product(x, y, z), _py_product_diagonal(x, y, z))
+
+
+@pytest.mark.mpi_skip
+def test_components_engine():
+    '''
+    Check the C++ connected components against scipy.
+    '''
+    from scipy.sparse.csgraph import connected_components as sp_components
+    from nngt.analysis.nngt_functions import _compiled_components
+
+    engine = _compiled_components()
+
+    if engine is None:
+        pytest.skip("Multithreaded algorithms are not available.")
+
+    num_nodes = 300
+
+    for directed in (True, False):
+        g = ng.erdos_renyi(nodes=num_nodes, avg_deg=1.5, directed=directed)
+
+        for strong in (True, False):
+            connection = "strong" if strong else "weak"
+
+            labels, hist = engine(g.edges_array, num_nodes,
+                                  strong and directed)
+
+            num_cc, ref = sp_components(g.adjacency_matrix(),
+                                        directed=directed,
+                                        connection=connection)
+
+            # same partition (up to the labels) and sorted sizes
+            assert len(set(zip(labels, ref))) == len(hist) == num_cc
+            assert np.array_equal(np.sort(hist)[::-1], hist)
+            assert np.array_equal(hist, np.bincount(labels))
+
+        if nngt_backend:
+            assert g.is_connected("weak") == (len(hist) == 1)
+
+
+@pytest.mark.mpi_skip
+def test_spike_statistics():
+    '''
+    Check the streamed spike statistics against a direct computation, and the
+    C++ Bayesian blocks against the Python loop.
+    '''
+    from nngt.analysis.bayesian_blocks import Events
+
+    rng = np.random.default_rng(5)
+
+    num_spikes = 5000
+    senders = rng.integers(0, 30, num_spikes)
+    times   = np.sort(rng.uniform(0, 1000, num_spikes))
+
+    nodes = [5, 1, 12, 40]
+
+    # reference values
+    ref_b2, ref_fr = [], []
+
+    for n in nodes:
+        dt1 = np.diff(times[senders == n])
+        dt2 = dt1[1:] + dt1[:-1]
+
+        ref_fr.append(len(times[senders == n]) / (times[-1] - times[0]))
+
+        if len(dt2):
+            ref_b2.append((2*np.var(dt1) - np.var(dt2)) / (2*np.mean(dt1)**2))
+        else:
+            ref_b2.append(np.NaN)
+
+    # streamed chunks, shuffled inside each chunk, with both implementations
+    for numpy_only in (False, True):
+        stats = na.SpikeStatistics(nodes)
+
+        for chunk in np.array_split(np.arange(num_spikes), 7):
+            chunk = rng.permutation(chunk)
+
+            if numpy_only:
+                stats._start = min(stats._start, np.min(times[chunk]))
+                stats._stop  = max(stats._stop, np.max(times[chunk]))
+                stats._add_numpy(senders[chunk], times[chunk])
+            else:
+                stats.add(senders[chunk], times[chunk])
+
+        assert np.allclose(stats.b2(), ref_b2, equal_nan=True)
+        assert np.allclose(stats.firing_rate(), ref_fr)
+        assert np.array_equal(stats.nodes, nodes)
+
+    # helpers of get_b2 and get_firing_rate
+    from nngt.analysis.activity_analysis import _b2_from_data, _fr_from_data
+
+    data = np.array([senders, times]).T
+
+    assert np.allclose(_b2_from_data(nodes, data), ref_b2, equal_nan=True)
+    assert np.allclose(_fr_from_data(nodes, data), ref_fr)
+
+    # Bayesian blocks (a subclass of Events always uses the Python loop)
+    class PyEvents(Events):
+        pass
+
+    t = np.concatenate((rng.normal(0, 1, 300), rng.normal(10, 3, 500),
+                        rng.uniform(-5, 20, 200)))
+
+    for kwargs in ({"p0": 0.05}, {"gamma": 0.8}):
+        edges = na.bayesian_blocks(t, fitness="events", **kwargs)
+        ref   = na.bayesian_blocks(t, fitness=PyEvents(**kwargs))
+
+        assert np.allclose(edges, ref)
+
+
 if __name__ == "__main__":
     if not nngt.get_config("mpi"):
         test_binary_undirected_clustering()
@@ -803,3 +956,6 @@ if __name__ == "__main__":
         test_clustering_parameters()
         test_global_clustering()
         test_local_closure()
+        test_triangle_kernels()
+        test_components_engine()
+        test_spike_statistics()
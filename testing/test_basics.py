@@ -238,6 +238,133 @@ def test_edge_creation():
     assert g.edge_nb() == 10
 
 
+@pytest.mark.mpi_skip
+def test_bulk_edge_creation():
+    ''' Check attributes and degrees when invalid edges are filtered '''
+    num_nodes = 50
+
+    for directed in (True, False):
+        g = nngt.Graph(num_nodes, directed=directed)
+
+        g.new_edges([(0, 1), (2, 3)])
+
+        edges = np.array([(0, 1), (4, 5), (4, 4), (2, 3), (4, 5), (6, 7)])
+        weights = np.arange(1, len(edges) + 1, dtype=float)
+
+        g.new_edges(edges, attributes={"weight": weights},
+                    ignore_invalid=True)
+
+        assert g.edge_nb() == 4
+        assert np.array_equal(g.edges_array, [(0, 1), (2, 3), (4, 5), (6, 7)])
+        assert np.array_equal(g.get_weights(), [1, 1, 2, 6])
+
+        # reciprocal edges are duplicates in undirected graphs
+        if not directed:
+            g.new_edges([(1, 0), (7, 6), (8, 9)], ignore_invalid=True)
+            assert g.edge_nb() == 5
+            assert g.edge_id((9, 8)) == 4
+
+        deg = np.zeros(num_nodes, dtype=int)
+
+        for s, t in g.edges_array:
+            deg[s] += 1
+            deg[t] += 1
+
+        assert np.array_equal(g.get_degrees(), deg)
+
+
+@pytest.mark.mpi_skip
+@pytest.mark.skipif(nngt.get_config("backend") != "nngt",
+                    reason="Storage of the native backend.")
+def test_compact_storage():
+    ''' Check that the "csr" storage behaves as the "dict" storage '''
+    num_nodes = 30
+
+    rng   = np.random.default_rng(5)
+    edges = np.unique(rng.integers(0, num_nodes, (200, 2)), axis=0)
+    edges = edges[edges[:, 0] != edges[:, 1]]
+    edges = edges[rng.permutation(len(edges))]
+
+    for directed in (True, False):
+        if not directed:
+            edges = np.unique(np.sort(edges, axis=1), axis=0)
+
+        graphs = []
+
+        try:
+            for storage in ("dict", "csr"):
+                nngt.set_config("nngt_storage", storage)
+
+                g = nngt.Graph(num_nodes, directed=directed)
+
+                # bulk and single insertions, with unindexed edges
+                g.new_edges(edges[:100])
+                g.get_degrees()
+                g.new_edges(edges[100:-1])
+                g.new_edge(*edges[-1])
+
+                with pytest.raises(InvalidArgument):
+                    g.new_edge(*edges[0])
+
+                graphs.append(g)
+        finally:
+            nngt.set_config("nngt_storage", "dict")
+
+        gd, gc = graphs
+
+        assert gc._graph._compact is not None
+        assert np.array_equal(gd.edges_array, gc.edges_array)
+
+        for mode in ("in", "out", "total"):
+            assert np.array_equal(gd.get_degrees(mode),
+                                  gc.get_degrees(mode))
+
+        for n in range(num_nodes):
+            for mode in ("in", "out", "all"):
+                assert gd.neighbours(n, mode) == gc.neighbours(n, mode)
+
+        for i, e in enumerate(edges[:20]):
+            assert gc.has_edge(e) and gc.edge_id(tuple(e)) == i
+
+        assert gd.edge_id(edges[:20]) == gc.edge_id(edges[:20])
+
+        gd.set_weights(np.arange(gd.edge_nb()))
+        gc.set_weights(np.arange(gc.edge_nb()))
+
+        assert np.array_equal(gd.adjacency_matrix().todense(),
+                              gc.adjacency_matrix().todense())
+
+        assert np.isclose(nngt.analysis.reciprocity(gd),
+                          nngt.analysis.reciprocity(gc))
+
+        # deletions (the remaining edges keep their order)
+        gc.delete_edges(edges[5:15])
+
+        remaining = np.concatenate((edges[:5], edges[15:]))
+
+        assert np.array_equal(gc.edges_array, remaining)
+
+        gc.delete_nodes([3, 7])
+
+        removed = np.isin(remaining, [3, 7]).any(axis=1)
+        mapping = np.cumsum(~np.isin(np.arange(num_nodes), [3, 7])) - 1
+
+        assert np.array_equal(gc.edges_array, mapping[remaining[~removed]])
+        assert np.array_equal(
+            gc.get_degrees(),
+            np.bincount(gc.edges_array.ravel(), minlength=num_nodes - 2))
+
+        gc.clear_all_edges()
+
+        assert gc.edge_nb() == 0
+        assert np.all(gc.get_degrees() == 0)
+
+        # self-loops appear once in the adjacency matrix
+        gc.new_edge(2, 2, attributes={"weight": 3.}, self_loop=True)
+
+        assert gc.adjacency_matrix(weights=True)[2, 2] == 3.
+
+
 @pytest.mark.mpi_skip
 def test_has_edges_edge_id():
     ''' Test the ``has_edge`` and ``edge_id`` methods '''
@@ -889,6 +1016,8 @@ if __name__ == "__main__":
     if not nngt.get_config('mpi'):
         test_node_creation()
         test_edge_creation()
+        test_bulk_edge_creation()
+        test_compact_storage()
         test_has_edges_edge_id()
         test_delete()
         test_density()
@@ -171,6 +171,131 @@ def test_group_vs_type():
         assert np.all(net1.get_degrees() == net2.get_degrees())
 
 
+@pytest.mark.mpi_skip
+def test_streamed_attributes():
+    ''' Attributes and checks of edges added as they are generated '''
+    pop = nngt.NeuralPop.exc_and_inhib(500)
+
+    shape = nngt.geometry.Shape.rectangle(100, 100)
+
+    net = nngt.SpatialNetwork(population=pop, shape=shape)
+
+    ids = net.get_nodes()
+
+    ng.connect_nodes(net, ids, ids, "fixed_degree", degree=10,
+                     degree_type="out", delays=3.,
+                     weights={"distribution": "uniform", "lower": 1,
+                              "upper": 2})
+
+    # the second call must avoid the existing edges
+    elist = ng.connect_nodes(net, ids, ids, "fixed_degree", degree=10,
+                             degree_type="out", delays=5.)
+
+    assert len(elist) == 10*pop.size
+    assert net.edge_nb() == 20*pop.size
+    assert np.all(net.get_degrees("out") == 20)
+
+    edges = net.edges_array
+
+    assert len({tuple(e) for e in edges}) == net.edge_nb()
+    assert not np.any(edges[:, 0] == edges[:, 1])
+
+    delays = net.get_delays()
+
+    assert set(np.unique(delays)) == {3., 5.}
+
+    weights = net.get_weights()[:10*pop.size]
+
+    assert np.all((weights >= 1) & (weights <= 2))
+
+    pos  = net.get_positions()
+    dist = np.linalg.norm(pos[edges[:, 1]] - pos[edges[:, 0]], axis=1)
+
+    assert np.allclose(net.edge_attributes["distance"], dist)
+
+
+@pytest.mark.mpi_skip
+def test_batch_connections():
+    ''' Several connections generated together '''
+    pop = nngt.NeuralPop.exc_and_inhib(1000)
+
+    egroup = pop["excitatory"]
+    igroup = pop["inhibitory"]
+
+    net = nngt.Network(population=pop)
+
+    everyone = ["excitatory", "inhibitory"]
+
+    connections = [
+        ("excitatory", everyone, "fixed_degree",
+         {"degree": 20, "degree_type": "out", "weights": 2.}),
+        (igroup, everyone, "fixed_degree",
+         {"degree": 40, "degree_type": "out", "weights": 3.}),
+        # shares edges with the previous one (made after the batch)
+        ("excitatory", "inhibitory", "gaussian_degree",
+         {"avg": 5, "std": 1, "degree_type": "in", "weights": 4.}),
+    ]
+
+    elist = ng.connect_groups_batch(net, connections, ignore_invalid=True)
+
+    assert len(elist) == net.edge_nb()
+
+    edges = net.edges_array
+
+    assert len({tuple(e) for e in edges}) == net.edge_nb()
+    assert not np.any(edges[:, 0] == edges[:, 1])
+
+    assert np.all(net.get_degrees("out", nodes=egroup.ids) == 20)
+
+    # inhibitory nodes are the only sources of the gaussian connection
+    ideg = net.get_degrees("out", nodes=igroup.ids)
+
+    assert np.all(ideg >= 40)
+    assert np.sum(ideg) == net.edge_nb() - 20*egroup.size
+
+    weights = net.get_weights()
+    is_exc  = np.isin(edges[:, 0], egroup.ids)
+
+    assert np.all(weights[is_exc] == 2.)
+    assert set(np.unique(weights[~is_exc])) == {3., 4.}
+
+    # existing edges are avoided by the compiled generators
+    if not ng.graph_connectivity.using_mt_algorithms:
+        return
+
+    num_edges = net.edge_nb()
+
+    ng.connect_groups_batch(net, connections[:2])
+
+    assert net.edge_nb() == num_edges + 20*egroup.size + 40*igroup.size
+    assert np.all(net.get_degrees("out", nodes=egroup.ids) == 40)
+    assert len({tuple(e) for e in net.edges_array}) == net.edge_nb()
+
+    # parameters that the batch does not handle go through connect_groups
+    from nngt.generation import connectors
+
+    calls = []
+
+    def connect_groups(*args, **kwargs):
+        calls.append(kwargs)
+        return np.zeros((0, 2), dtype=np.int64)
+
+    connect_groups_orig = connectors.connect_groups
+
+    connectors.connect_groups = connect_groups
+
+    try:
+        ng.connect_groups_batch(
+            net, [("excitatory", everyone, "fixed_degree",
+                   {"degree": 1, "degree_type": "out", "unit": "mm",
+                    "weighted": False})])
+    finally:
+        connectors.connect_groups = connect_groups_orig
+
+    assert len(calls) == 1
+    assert calls[0]["unit"] == "mm" and not calls[0]["weighted"]
+
+
 if __name__ == "__main__":
     import os
 
@@ -183,6 +308,8 @@ if __name__ == "__main__":
 
     if not nngt.get_config("mpi"):
         test_fixed()
+        test_streamed_attributes()
+        test_batch_connections()
 
     test_gaussian()
     test_group_vs_type()
@@ -76,6 +76,42 @@ def test_from_degree_list():
         print("Skipping non graphical sequence for undirected graph.")
 
 
+@pytest.mark.mpi_skip
+def test_degree_sequence():
+    '''
+    Check the configuration model for undirected degree lists.
+    '''
+    num_nodes = 20000
+
+    # heavy-tailed sequence
+    deg_list = np.minimum(
+        (2*(1 - np.random.uniform(size=num_nodes))**(-1/1.5)).astype(int), 500)
+
+    if np.sum(deg_list) % 2:
+        deg_list[0] += 1
+
+    for directed in (False, True):
+        degree_type = "total" if directed else "in"
+
+        g = ng.from_degree_list(deg_list, degree_type=degree_type,
+                                directed=directed, max_rounds=None)
+
+        assert np.array_equal(g.get_degrees("total"), deg_list)
+
+        edges = g.edges_array
+
+        assert not np.any(edges[:, 0] == edges[:, 1])
+
+        if not directed:
+            edges = np.sort(edges, axis=1)
+
+        assert len(np.unique(edges, axis=0)) == len(edges)
+
+    # non-graphical sequence
+    with pytest.raises(ValueError):
+        ng.from_degree_list([3, 3, 1, 1], directed=False)
+
+
 @pytest.mark.mpi_skip
 def test_newman_watts():
     '''
@@ -121,6 +157,16 @@ def test_newman_watts():
     assert g.edge_nb() == 8  # 7 lattice edges + 1 shortcuts
     assert 0.5 <= na.reciprocity(g) <= 0.75
 
+    # multigraph: more shortcuts than possible distinct edges
+    g = ng.newman_watts(k_lattice, reciprocity_circular=0., edges=30,
+                        nodes=num_nodes, directed=True, multigraph=True)
+
+    edges = g.edges_array
+
+    assert g.edge_nb() == 30
+    assert not np.any(edges[:, 0] == edges[:, 1])
+    assert len(np.unique(edges, axis=0)) <= num_nodes*(num_nodes - 1)
+
     ## USING PROBABILITY
 
     # undirected
@@ -211,6 +257,45 @@ def test_watts_strogatz():
         assert g.edge_nb() == k_lattice*num_nodes
 
 
+@pytest.mark.mpi_skip
+def test_small_world_edges():
+    '''
+    Check the edges of larger circular, Newman-Watts and Watts-Strogatz
+    graphs.
+    '''
+    num_nodes, k_lattice, p_shortcut = 2000, 10, 0.1
+
+    for directed in (True, False):
+        num_circ = k_lattice*num_nodes if directed \
+                   else k_lattice*num_nodes // 2
+
+        g = ng.circular(k_lattice, nodes=num_nodes, directed=directed)
+
+        assert g.edge_nb() == num_circ
+        assert np.all(g.get_degrees() == (2*k_lattice if directed
+                                          else k_lattice))
+
+        graphs = (
+            ng.newman_watts(k_lattice, p_shortcut, nodes=num_nodes,
+                            directed=directed),
+            ng.watts_strogatz(k_lattice, p_shortcut, nodes=num_nodes,
+                              directed=directed),
+        )
+
+        for g in graphs:
+            edges = g.edges_array
+
+            assert not np.any(edges[:, 0] == edges[:, 1])
+
+            if not directed:
+                edges = np.sort(edges, axis=1)
+
+            assert len(np.unique(edges, axis=0)) == len(edges)
+
+        assert graphs[0].edge_nb() > num_circ
+        assert graphs[1].edge_nb() == num_circ
+
+
 @pytest.mark.mpi
 def test_mpi_from_degree_list():
     '''
@@ -432,6 +517,47 @@ def test_price():
     assert rmin < na.reciprocity(g) < rmax
 
 
+@pytest.mark.mpi_skip
+def test_price_edges():
+    '''
+    Check the edges of a larger Price network.
+    '''
+    m, num_nodes = 3, 5000
+
+    for directed in (True, False):
+        nngt.seed(msd=0)
+
+        g = ng.price_scale_free(m, nodes=num_nodes, directed=directed)
+
+        # node i creates min(i, m) edges
+        assert g.edge_nb() == m*(num_nodes - 1) - m*(m - 1) // 2
+
+        edges = g.edges_array
+
+        assert not np.any(edges[:, 0] == edges[:, 1])
+
+        if not directed:
+            edges = np.sort(edges, axis=1)
+
+        assert len(np.unique(edges, axis=0)) == len(edges)
+
+        # each new node only connects to older ones, so that node i has
+        # min(i, m) edges towards lower ids
+        src, tgt = edges.max(axis=1), edges.min(axis=1)
+
+        if directed:
+            assert np.array_equal(src, edges[:, 0])
+
+        assert np.array_equal(
+            np.bincount(src, minlength=num_nodes),
+            np.minimum(np.arange(num_nodes), m))
+
+        # preferential attachment leads to hubs (fixed seed)
+        deg = g.get_degrees("in" if directed else "total")
+
+        assert deg.max() > 10*deg.mean()
+
+
 @pytest.mark.mpi_skip
 def test_connect_switch_distance_rule_max_proba():
     num_omp = nngt.get_config("omp")
@@ -565,6 +691,335 @@ def test_sparse_clustered():
                     assert g.is_connected()
 
 
+@pytest.mark.mpi_skip
+@pytest.mark.skipif(not nngt.get_config("multithreading"),
+                    reason="Requires the multithreaded algorithms.")
+def test_edge_streaming():
+    '''
+    Check that the C++ generators can pass their edges by batches.
+    '''
+    from nngt.generation import cconnect
+
+    num_nodes  = 1000
+    batch_size = 333
+    ids        = np.arange(num_nodes, dtype=np.uint)
+
+    batches = []
+
+    def consume(edges, distances):
+        batches.append((edges, distances))
+
+    # fixed degree
+    res = cconnect._fixed_degree(ids, ids, degree=20, degree_type="in",
+                                 edge_callback=consume, batch_size=batch_size)
+
+    assert res is None
+    assert all(len(e) <= batch_size for e, _ in batches)
+
+    edges = np.concatenate([e for e, _ in batches])
+
+    assert len(edges) == 20*num_nodes
+    assert np.array_equal(np.bincount(edges[:, 1], minlength=num_nodes),
+                          np.full(num_nodes, 20))
+
+    # distance rule
+    batches = []
+
+    positions = np.random.uniform(
+        -500, 500, size=(2, num_nodes)).astype(np.float32)
+
+    res = cconnect._distance_rule(ids, ids, avg_deg=10, scale=50.,
+                                  positions=positions, edge_callback=consume,
+                                  batch_size=batch_size)
+
+    assert res is None
+
+    edges = np.concatenate([e for e, _ in batches])
+    dist  = np.concatenate([d for _, d in batches])
+
+    assert len(edges) == len(dist) == 10*num_nodes
+    assert np.allclose(
+        dist, np.linalg.norm(positions[:, edges[:, 0]]
+                             - positions[:, edges[:, 1]], axis=0), rtol=1e-4)
+
+    # undirected distance rule: no duplicate pairs across the batches
+    batches = []
+
+    cconnect._distance_rule(ids, ids, avg_deg=10, scale=50.,
+                            positions=positions, directed=False,
+                            edge_callback=consume, batch_size=batch_size)
+
+    edges = np.sort(np.concatenate([e for e, _ in batches]), axis=1)
+
+    assert len(edges) == 10*num_nodes
+    assert len(np.unique(edges, axis=0)) == len(edges)
+
+    # each undirected pair of neighbours can only be used once
+    lim      = 10*2.
+    diff     = np.abs(positions[:, :, None] - positions[:, None, :])
+    num_neig = np.sum(np.all(diff < lim, axis=0)) - num_nodes
+
+    with pytest.raises(ValueError):
+        cconnect._distance_rule(ids, ids, edges=num_neig // 2 + 1, scale=2.,
+                                positions=positions, directed=False,
+                                edge_callback=consume)
+
+    # errors in the callback are propagated
+    def fail(edges, distances):
+        raise ValueError("stop")
+
+    with pytest.raises(ValueError):
+        cconnect._fixed_degree(ids, ids, degree=20, edge_callback=fail,
+                               batch_size=batch_size)
+
+
+@pytest.mark.mpi_skip
+@pytest.mark.skipif(not nngt.get_config("multithreading"),
+                    reason="Requires the multithreaded algorithms.")
+def test_thread_independence():
+    '''
+    Check that the multithreaded generators give the same graph whatever the
+    number of threads.
+    '''
+    num_omp = nngt.get_config("omp")
+
+    num_nodes = 1000
+
+    shape = nngt.geometry.Shape.rectangle(1000., 1000.)
+
+    positions = np.random.uniform(-500, 500, (num_nodes, 2))
+
+    edges = []
+
+    try:
+        for omp in (1, 2):
+            nngt.set_config("omp", omp)
+            nngt.seed(msd=0)
+
+            g = ng.fixed_degree(10, "out", nodes=num_nodes)
+
+            sg = ng.distance_rule(50., avg_deg=10, nodes=num_nodes,
+                                  shape=shape, positions=positions)
+
+            edges.append((set(map(tuple, g.edges_array)),
+                          set(map(tuple, sg.edges_array))))
+    finally:
+        nngt.set_config("omp", num_omp)
+
+    assert edges[0][0] == edges[1][0]
+    assert edges[0][1] == edges[1][1]
+
+
+@pytest.mark.mpi_skip
+@pytest.mark.skipif(not nngt.get_config("multithreading"),
+                    reason="Requires the multithreaded algorithms.")
+def test_existing_edges_excluded():
+    '''
+    Check that the C++ generator does not recreate existing edges.
+    '''
+    from nngt.generation import cconnect
+
+    num_nodes = 500
+    ids       = np.arange(num_nodes, dtype=np.uint)
+
+    old = cconnect._fixed_degree(ids, ids, degree=50, degree_type="out")
+
+    new = cconnect._fixed_degree(ids, ids, degree=50, degree_type="out",
+                                 existing_edges=old)
+
+    assert len(new) == 50*num_nodes
+    assert not np.any(new[:, 0] == new[:, 1])
+
+    old_set = set(map(tuple, old))
+    new_set = set(map(tuple, new))
+
+    assert len(new_set) == len(new)
+    assert not old_set.intersection(new_set)
+
+
+@pytest.mark.mpi_skip
+@pytest.mark.skipif(not nngt.get_config("multithreading"),
+                    reason="Requires the multithreaded algorithms.")
+def test_strided_inputs():
+    '''
+    Check that the C++ generators accept non-contiguous arrays and return
+    arrays which own their memory.
+    '''
+    import gc
+
+    from nngt.generation import cconnect
+
+    num_nodes = 500
+
+    # every other node, as a strided view
+    ids = np.arange(2*num_nodes, dtype=np.uint)[::2]
+
+    edges = cconnect._fixed_degree(ids, ids, degree=20, degree_type="in")
+
+    assert len(edges) == 20*num_nodes
+    assert np.all(edges % 2 == 0)
+    assert np.array_equal(np.unique(edges[:, 1]), ids)
+
+    old = edges[::-1]  # strided existing edges
+
+    new = cconnect._fixed_degree(ids, ids, degree=20, degree_type="in",
+                                 existing_edges=old)
+
+    assert not set(map(tuple, old)).intersection(map(tuple, new))
+
+    # vector-backed outputs stay valid after the generator returned
+    gnp = cconnect._erdos_renyi(ids, ids, density=0.05, exact_edge_nb=False)
+
+    gc.collect()
+
+    assert gnp.flags.writeable
+    assert np.all(np.isin(gnp, ids))
+    assert not np.any(gnp[:, 0] == gnp[:, 1])
+
+
+@pytest.mark.mpi_skip
+@pytest.mark.skipif(not nngt.get_config("multithreading"),
+                    reason="Requires the multithreaded algorithms.")
+def test_distance_rule_3d():
+    '''
+    Check that the C++ distance rule uses all dimensions of the positions.
+    '''
+    from nngt.generation import cconnect
+
+    num_nodes = 1000
+    ids       = np.arange(num_nodes, dtype=np.uint)
+
+    positions = np.random.uniform(
+        -200, 200, size=(3, num_nodes)).astype(np.float32)
+
+    distance = []
+
+    edges = cconnect._distance_rule(ids, ids, avg_deg=10, scale=50.,
+                                    rule="gaussian", positions=positions,
+                                    distance=distance)
+
+    assert len(edges) == len(distance) == 10*num_nodes
+    assert np.allclose(
+        distance, np.linalg.norm(positions[:, edges[:, 0]]
+                                 - positions[:, edges[:, 1]], axis=0),
+        rtol=1e-4)
+
+    with pytest.raises(ValueError):
+        cconnect._distance_rule(ids, ids, avg_deg=10, scale=50.,
+                                rule="unknown", positions=positions)
+
+    # the neighbours on the diagonal are too far for the linear rule, so
+    # the required edges can never be found
+    diagonal = np.tile(0.9*np.arange(10, dtype=np.float32), (2, 1))
+
+    with pytest.raises(RuntimeError):
+        cconnect._distance_rule(ids[:10], ids[:10], edges=5, scale=1.,
+                                rule="lin", positions=diagonal)
+
+
+@pytest.mark.mpi_skip
+@pytest.mark.skipif(not nngt.get_config("multithreading"),
+                    reason="Requires the multithreaded algorithms.")
+def test_distance_rule_max_proba_mt():
+    '''
+    Check the multithreaded max_proba distance rule.
+    '''
+    from nngt.generation import cconnect
+
+    num_nodes = 1000
+    ids       = np.arange(num_nodes, dtype=np.uint)
+    scale     = 20.
+    max_proba = 0.2
+
+    positions = np.random.uniform(
+        -200, 200, size=(2, num_nodes)).astype(np.float32)
+
+    for directed in (True, False):
+        distance = []
+
+        edges = cconnect._distance_rule(
+            ids, ids, scale=scale, rule="exp", max_proba=max_proba,
+            positions=positions, directed=directed, distance=distance)
+
+        assert len(edges) == len(distance)
+        assert not np.any(edges[:, 0] == edges[:, 1])
+
+        if not directed:
+            # each pair is tested only once
+            assert np.all(edges[:, 0] < edges[:, 1])
+
+        # distances and expected number of edges
+        assert np.allclose(
+            distance, np.linalg.norm(positions[:, edges[:, 0]]
+                                     - positions[:, edges[:, 1]], axis=0),
+            rtol=1e-4)
+
+        dist = np.linalg.norm(positions[:, :, None] - positions[:, None, :],
+                              axis=0)
+
+        proba = max_proba*np.exp(-dist / scale)
+        np.fill_diagonal(proba, 0)
+
+        expected = proba.sum() if directed else 0.5*proba.sum()
+
+        assert abs(len(edges) - expected) < 5*np.sqrt(expected)
+
+
+@pytest.mark.mpi_skip
+def test_erdos_renyi_models():
+    '''
+    Check the G(n, m) and G(n, p) Erdos-Renyi models.
+    '''
+    num_nodes = 1000
+    density   = 0.02
+
+    for directed in (True, False):
+        num_pairs = num_nodes*(num_nodes - 1)
+
+        if not directed:
+            num_pairs //= 2
+
+        # fixed number of edges
+        g = ng.erdos_renyi(edges=5000, nodes=num_nodes, directed=directed)
+
+        assert g.edge_nb() == 5000
+
+        edges = g.edges_array
+
+        assert not np.any(edges[:, 0] == edges[:, 1])
+
+        # fixed probability
+        g = ng.erdos_renyi(density=density, nodes=num_nodes,
+                           directed=directed, exact_edge_nb=False)
+
+        expected = density*num_pairs
+        sigma    = np.sqrt(expected*(1 - density))
+
+        assert abs(g.edge_nb() - expected) < 5*sigma
+
+        # G(n, m) creates density*N^2 edges for the same density, i.e. about
+        # twice the mean of G(n, p) for undirected graphs
+        num_gnm = ng.erdos_renyi(density=density, nodes=num_nodes,
+                                 directed=directed).edge_nb()
+
+        ratio = num_nodes**2 / num_pairs
+
+        assert num_gnm == int(density*num_nodes**2)
+        assert abs(num_gnm - ratio*g.edge_nb()) < 5*ratio*sigma
+
+        if not directed:
+            assert np.isclose(ratio, 2, rtol=1e-2)
+
+        edges = g.edges_array
+
+        assert not np.any(edges[:, 0] == edges[:, 1])
+
+        if not directed:
+            edges = np.sort(edges, axis=1)
+
+        assert len(np.unique(edges, axis=0)) == len(edges)
+
+
 if __name__ == "__main__":
     if not nngt.get_config("mpi"):
         test_circular()
@@ -575,8 +1030,18 @@ if __name__ == "__main__":
         test_all_to_all()
         test_distances()
         test_price()
+        test_price_edges()
+        test_degree_sequence()
+        test_small_world_edges()
         test_connect_switch_distance_rule_max_proba()
         test_sparse_clustered()
+        test_edge_streaming()
+        test_thread_independence()
+        test_existing_edges_excluded()
+        test_strided_inputs()
+        test_distance_rule_3d()
+        test_distance_rule_max_proba_mt()
+        test_erdos_renyi_models()
 
     if nngt.get_config("mpi"):
         test_mpi_from_degree_list()
@@ -29,9 +29,9 @@ from tools_testing import foreach_graph
 current_dir = os.path.dirname(os.path.abspath(__file__)) + '/'
 error = 'Wrong {{val}} for {graph}.'
 
-formats = ("neighbour", "edge_list", "gml", "graphml")
+formats = ("neighbour", "edge_list", "gml", "graphml", "binary")
 
-filetypes = ("nn", "el", "gml", "graphml")
+filetypes = ("nn", "el", "gml", "graphml", "nngt")
 
 gfilename = current_dir + 'g.graph'
 
@@ -326,6 +326,166 @@ def test_partial_graphml():
             assert g.get_edge_attributes(edges=e, name="eattr") == value
 
 
+@pytest.mark.mpi_skip
+def test_binary_format():
+    '''
+    Check compression, checksums, and memory-mapping of the binary format.
+    '''
+    from nngt.io.binary_helpers import _load_binary
+
+    g = nngt.generation.erdos_renyi(nodes=100, avg_deg=5)
+
+    g.new_edge_attribute("label", "string",
+                         values=[str(i) for i in range(g.edge_nb())])
+
+    g.new_node_attribute("obj", "object",
+                         values=[{"i": i} for i in range(g.node_nb())])
+
+    for compression in (None, "zlib"):
+        g.to_file(gfilename, fmt="binary", compression=compression)
+
+        h = nngt.load_from_file(gfilename, fmt="binary", checksums=True)
+
+        assert np.array_equal(g.edges_array, h.edges_array)
+        assert np.allclose(g.get_weights(), h.get_weights())
+        assert list(g.edge_attributes["label"]) == \
+               list(h.edge_attributes["label"])
+        assert list(g.node_attributes["obj"]) == \
+               list(h.node_attributes["obj"])
+
+        _, edges, _, eattr, _ = _load_binary(gfilename)
+
+        assert isinstance(edges, np.memmap) == (compression is None)
+        assert isinstance(eattr["weight"], np.memmap) == (compression is None)
+
+    # corrupt the last edge and check that it is detected
+    g.to_file(gfilename, fmt="binary")
+
+    info, edges, _, _, _ = _load_binary(gfilename)
+
+    last = edges.offset + edges.nbytes - 1
+
+    del edges
+
+    with open(gfilename, "r+b") as f:
+        f.seek(last)
+        byte = f.read(1)
+        f.seek(last)
+        f.write(bytes([byte[0] ^ 1]))
+
+    with pytest.raises(IOError):
+        nngt.load_from_file(gfilename, fmt="binary", checksums=True)
+
+
+@pytest.mark.mpi_skip
+def test_compiled_text_formats():
+    '''
+    Check the C++ edge list writer and parser against the Python ones.
+    '''
+    from nngt.io.loading_helpers import (_compiled_text_parser, _gen_convert,
+                                         _get_edges_elist,
+                                         _get_edges_neighbour, _process_file)
+
+    parser = _compiled_text_parser("edge_list", " ", ";")
+
+    if parser is None:
+        pytest.skip("Multithreaded algorithms are not available.")
+
+    g = nngt.generation.erdos_renyi(nodes=100, avg_deg=5)
+
+    g.new_edge_attribute("delay", "double",
+                         values=np.random.uniform(0.1, 3, g.edge_nb()))
+    g.new_edge_attribute("num", "int",
+                         values=np.random.randint(-5, 5, g.edge_nb()))
+
+    attributes = ["weight", "delay", "num"]
+    types = ["double", "double", "int"]
+
+    for fmt in ("edge_list", "neighbour"):
+        g.to_file(gfilename, fmt=fmt)
+
+        h = nngt.load_from_file(gfilename, fmt=fmt)
+
+        # edges of neighbour lists are sorted by source
+        order = np.lexsort(g.edges_array.T[::-1]) if fmt == "neighbour" \
+                else slice(None)
+
+        assert np.array_equal(g.edges_array[order], h.edges_array)
+
+        for attr in attributes:
+            assert np.array_equal(g.get_edge_attributes(name=attr)[order],
+                                  h.get_edge_attributes(name=attr))
+
+        # compare with the Python parser
+        with open(gfilename, "r") as f:
+            lines = _process_file(f, fmt, " ")
+
+        convertor = _gen_convert(attributes, types)
+        di_attr = {attr: [] for attr in attributes}
+
+        get_edges = _get_edges_elist if fmt == "edge_list" \
+                    else _get_edges_neighbour
+
+        edges = get_edges(lines, attributes, "#", "@", " ", ";",
+                          di_attributes=di_attr, convertor=convertor)
+
+        cedges, values = parser(gfilename, fmt, " ", ";", "@", "#", 3)
+
+        assert np.array_equal(edges, cedges)
+
+        for i, attr in enumerate(attributes):
+            assert np.array_equal(di_attr[attr], values[:, i])
+
+    # attributes given as columns, comments and invalid lines
+    with open(gfilename, "w") as f:
+        f.write("# comment\n0,1,0.5\n\n1,,2,1e-3\n")
+
+    edges, values = parser(gfilename, "edge_list", ",", ";", "@", "#", 1)
+
+    assert np.array_equal(edges, [[0, 1], [1, 2]])
+    assert np.array_equal(values[:, 0], [0.5, 1e-3])
+
+    with open(gfilename, "a") as f:
+        f.write("2,x\n")
+
+    with pytest.raises(ValueError):
+        parser(gfilename, "edge_list", ",", ";", "@", "#", 1)
+
+    # files rejected by the C++ parser load as with the Python parser
+    import nngt.io.graph_loading as gl
+
+    g.to_file(gfilename, fmt="edge_list")
+
+    with open(gfilename, "r") as f:
+        lines = f.readlines()
+
+    num_edge = next(i for i, l in enumerate(lines)
+                    if l.strip() and l[0] not in "@#")
+
+    lines[num_edge] = " ".join(lines[num_edge].split(" ")[:2]) + "\n"
+
+    with open(gfilename, "w") as f:
+        f.writelines(lines)
+
+    with pytest.raises(ValueError):
+        parser(gfilename, "edge_list", " ", ";", "@", "#", 3)
+
+    res = gl._load_from_file(gfilename, fmt="edge_list")
+
+    compiled_parser = gl._compiled_text_parser
+
+    try:
+        gl._compiled_text_parser = lambda *args: None
+        ref = gl._load_from_file(gfilename, fmt="edge_list")
+    finally:
+        gl._compiled_text_parser = compiled_parser
+
+    assert np.array_equal(res[1], ref[1])
+
+    for attr in attributes:
+        assert np.array_equal(res[3][attr], ref[3][attr])
+
+
 # ---------- #
 # Test suite #
 # ---------- #
@@ -340,4 +500,6 @@ if __name__ == "__main__":
         test_node_attributes()
         test_spatial()
         test_partial_graphml()
+        test_binary_format()
+        test_compiled_text_formats()
         unittest.main()
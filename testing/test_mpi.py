@@ -111,6 +111,60 @@ class TestMPI(TestBasis):
                     ".format(graph.name, err, tolerance))
 
 
+    @unittest.skipIf(not nngt.get_config('mpi'), "Not using MPI.")
+    def test_balanced_distance_rule(self):
+        '''
+        Check that the spatially tiled distance rule creates the required
+        number of edges and balances them between the processes.
+        '''
+        from mpi4py import MPI
+        comm = MPI.COMM_WORLD
+
+        num_nodes, num_edges = 2000, 20000
+
+        shape = nngt.geometry.Shape.rectangle(1000., 1000.)
+
+        g = nngt.generation.distance_rule(
+            100., rule="exp", shape=shape, nodes=num_nodes, edges=num_edges)
+
+        if nngt.get_config("backend") == "nngt":
+            counts = comm.allgather(g.edge_nb())
+
+            self.assertEqual(sum(counts), num_edges)
+            self.assertLessEqual(max(counts) - min(counts), 1)
+        elif nngt.on_master_process():
+            self.assertEqual(g.edge_nb(), num_edges)
+
+        if nngt.get_config("backend") == "nngt" or nngt.on_master_process():
+            edges = g.edges_array
+
+            self.assertFalse(np.any(edges[:, 0] == edges[:, 1]))
+            self.assertEqual(len(g.edge_attributes["distance"]), len(edges))
+
+
+    @unittest.skipIf(not nngt.get_config('mpi'), "Not using MPI.")
+    def test_fixed_degree(self):
+        ''' Check the degrees of a fixed-degree graph generated with MPI '''
+        from mpi4py import MPI
+        comm = MPI.COMM_WORLD
+
+        num_nodes, degree = 1000, 20
+
+        g = nngt.generation.fixed_degree(degree, degree_type="out",
+                                         nodes=num_nodes)
+
+        if nngt.get_config("backend") == "nngt":
+            self.assertEqual(comm.allreduce(g.edge_nb()), degree*num_nodes)
+        elif nngt.on_master_process():
+            self.assertTrue(np.all(g.get_degrees("out") == degree))
+
+        if nngt.get_config("backend") == "nngt" or nngt.on_master_process():
+            edges = g.edges_array
+
+            self.assertFalse(np.any(edges[:, 0] == edges[:, 1]))
+            self.assertEqual(len({tuple(e) for e in edges}), len(edges))
+
+
 
 # ---------- #
 # Test suite #
@@ -132,7 +132,85 @@ def test_utils():
     ns.plot_activity(vm, rec, show=True)
 
 
+@pytest.mark.skipif(nngt.get_config('mpi'), reason="Don't test for MPI")
+def test_bulk_export():
+    '''
+    Check that the batched export sends every edge with its weight and
+    delay.
+    '''
+    nest = pytest.importorskip("nest")
+
+    import nngt.simulation.nest_graph as nsg
+
+    nest.ResetKernel()
+
+    net = nngt.Network.exc_and_inhib(200)
+
+    ng.connect_groups(net, net.population, net.population,
+                      graph_model="erdos_renyi", avg_deg=20)
+
+    rng = np.random.default_rng(2)
+
+    net.set_weights(rng.uniform(1, 10, net.edge_nb()))
+    net.set_delays(np.round(rng.uniform(1, 5, net.edge_nb()), 1))
+
+    # use small batches to split the group pairs
+    batch_size = nsg.BATCH_SIZE
+
+    try:
+        nsg.BATCH_SIZE = 97
+        gids = net.to_nest()
+    finally:
+        nsg.BATCH_SIZE = batch_size
+
+    # expected connections (in NEST gids)
+    edges  = net.edges_array
+    sign   = net.get_edge_types()
+    src    = net.nest_gids[edges[:, 0]]
+    tgt    = net.nest_gids[edges[:, 1]]
+    weight = sign*net.get_weights()
+    delay  = net.get_delays()
+
+    expected = sorted(zip(src, tgt, np.round(weight, 6), np.round(delay, 6)))
+
+    status = nest.GetStatus(nest.GetConnections(source=gids))
+
+    sent = sorted((d["source"], d["target"], round(d["weight"], 6),
+                   round(d["delay"], 6)) for d in status)
+
+    assert len(sent) == net.edge_nb()
+    assert sent == expected
+
+    # undirected edges (including a self-loop) are exported both ways
+    pop = nngt.NeuralPop.exc_and_inhib(50)
+    g   = nngt.Graph(50, directed=False)
+
+    g.new_edges([(0, 0), (0, 25)] + [(i, i + 1) for i in range(1, 49)],
+                check_self_loops=False, check_duplicates=False)
+
+    g.set_weights(rng.uniform(1, 10, g.edge_nb()))
+    g.new_edge_attribute("delay", "double",
+                         values=np.round(rng.uniform(1, 5, g.edge_nb()), 1))
+
+    groups = list(pop.values())
+
+    exported, weights, delays, bounds = nsg._export_edges(g, groups, True)
+
+    edges  = g.edges_array
+    loop   = edges[:, 0] == edges[:, 1]
+    both   = np.concatenate((edges, edges[~loop, ::-1]))
+    ew     = np.concatenate((g.get_weights(), g.get_weights()[~loop]))
+    ed     = np.concatenate((g.get_delays(), g.get_delays()[~loop]))
+
+    assert len(exported) == 2*g.edge_nb() - 1
+    assert sorted(zip(map(tuple, exported), weights, delays)) == \
+        sorted(zip(map(tuple, both), ew, ed))
+    assert sum(last - first for first, last in bounds.values()) == \
+        len(exported)
+
+
 if __name__ == "__main__":
     if not nngt.get_config("mpi"):
         test_net_creation()
         test_utils()
+        test_bulk_export()
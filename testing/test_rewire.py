@@ -120,6 +120,57 @@ def test_random_rewire():
                     assert set(old_attr) == set(new_attr)
 
 
+@pytest.mark.mpi_skip
+def test_all_degrees_rewire():
+    ''' Check the degree-preserving rewiring through edge swaps '''
+    num_nodes = 200
+
+    for directed in (True, False):
+        g = ng.erdos_renyi(avg_deg=10, nodes=num_nodes, directed=directed)
+
+        g.new_node_attribute("group", "int",
+                             values=np.arange(num_nodes) % 3)
+
+        stats = {}
+
+        r = ng.random_rewire(g, constraints="all-degrees", stats=stats,
+                             node_attr_constraints="preserve")
+
+        assert r.edge_nb() == g.edge_nb()
+        assert np.array_equal(r.get_degrees("in"), g.get_degrees("in"))
+        assert np.array_equal(r.get_degrees("out"), g.get_degrees("out"))
+
+        assert stats["attempted"] == 10*g.edge_nb()
+        assert 0 < stats["accepted"] <= stats["attempted"]
+
+        edges = r.edges_array
+
+        assert not np.any(edges[:, 0] == edges[:, 1])
+
+        if not directed:
+            edges = np.sort(edges, axis=1)
+
+        assert len(np.unique(edges, axis=0)) == len(edges)
+
+        # the graph was actually rewired
+        assert not np.array_equal(r.edges_array, g.edges_array)
+
+        # preserve the number of edges between groups
+        r = ng.random_rewire(g, constraints="all-degrees", groups="group",
+                             node_attr_constraints="preserve")
+
+        def group_counts(graph):
+            group = graph.node_attributes["group"]
+            pairs = group[graph.edges_array]
+
+            if not directed:
+                pairs = np.sort(pairs, axis=1)
+
+            return np.unique(pairs, axis=0, return_counts=True)[1]
+
+        assert np.array_equal(group_counts(r), group_counts(g))
+
+
 @pytest.mark.mpi_skip
 def test_clst_rewire():
     ''' Test rewire preserving clustering '''
@@ -313,6 +364,7 @@ def test_reciprocity_lattice_rewire():
 if __name__ == "__main__":
     if not nngt.get_config("mpi"):
         test_random_rewire()
+        test_all_degrees_rewire()
         test_clst_rewire()
         test_complete_lattice_rewire()
         test_incomplete_lattice_rewire()